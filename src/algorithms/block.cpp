@@ -0,0 +1,35 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <limits>
+
+#include <core/logging.h>
+#include <algorithms/block.h>
+
+namespace luisa::compute::detail {
+
+std::vector<size_t> parallel_primitive_levels(size_t count) noexcept {
+    std::vector<size_t> levels;
+    do {
+        count = std::max((count + parallel_primitive_block_size - 1u) / parallel_primitive_block_size, size_t{1u});
+        levels.emplace_back(count);
+    } while (count > 1u);
+    return levels;
+}
+
+void check_parallel_primitive_size(const char *primitive, size_t count, size_t capacity) noexcept {
+    if (count > capacity) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Too many elements for {} (count = {}, capacity = {}).",
+            primitive, count, capacity);
+    }
+    // dispatch sizes are rounded up to whole blocks
+    if (count > std::numeric_limits<uint>::max() - parallel_primitive_block_size) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Too many elements for {} (count = {}).",
+            primitive, count);
+    }
+}
+
+}// namespace luisa::compute::detail
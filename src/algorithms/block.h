@@ -0,0 +1,81 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <vector>
+
+#include <runtime/command.h>
+#include <dsl/syntax.h>
+
+namespace luisa::compute {
+
+// Kernels of the parallel primitives run in blocks of this many threads, each
+// thread taking one element, so that block-level passes stay in shared memory.
+static constexpr auto parallel_primitive_block_size = 256u;
+
+namespace detail {
+
+// number of blocks at each level of a multi-level scan or reduction over
+// count elements, from the elements up to a single block; empty inputs
+// still take one block, so that results are always written
+[[nodiscard]] std::vector<size_t> parallel_primitive_levels(size_t count) noexcept;
+
+// aborts with a message if the count elements of a primitive do not fit
+void check_parallel_primitive_size(const char *primitive, size_t count, size_t capacity) noexcept;
+
+// links the commands of a primitive into a single chain
+class CommandChain {
+
+private:
+    Command *_head{nullptr};
+    Command *_tail{nullptr};
+
+public:
+    CommandChain &operator<<(Command *command) noexcept {
+        _tail = _tail == nullptr ? (_head = command)->tail() : _tail->set_next(command);
+        return *this;
+    }
+    [[nodiscard]] auto head() const noexcept { return _head; }
+};
+
+// Inclusive scan of x over the threads of the block (Hillis and Steele), with
+// temp holding parallel_primitive_block_size elements. Operands are combined
+// in order as op(left, right), so op needs to be associative but not
+// commutative. All threads of the block must call it; on return, temp holds
+// the inclusive prefixes of the block.
+template<typename T>
+[[nodiscard]] inline auto block_inclusive_scan(const Shared<T> &temp, Expr<T> x, const Callable<T(T, T)> &op) noexcept {
+    auto tid = thread_x();
+    Var prefix = x;
+    temp[tid] = prefix;
+    for (auto offset = 1u; offset < parallel_primitive_block_size; offset <<= 1u) {
+        group_memory_barrier();
+        if_(tid >= offset, [&] { prefix = op(temp[tid - offset], prefix); });
+        group_memory_barrier();
+        temp[tid] = prefix;
+    }
+    group_memory_barrier();
+    return prefix;
+}
+
+// Reduction of x over the threads of the block, pairing neighbours in a tree,
+// with the same requirements as block_inclusive_scan(); returns the total.
+template<typename T>
+[[nodiscard]] inline auto block_reduce(const Shared<T> &temp, Expr<T> x, const Callable<T(T, T)> &op) noexcept {
+    auto tid = thread_x();
+    temp[tid] = x;
+    for (auto stride = 1u; stride < parallel_primitive_block_size; stride <<= 1u) {
+        group_memory_barrier();
+        Var i = tid * (stride * 2u);
+        if_(i < parallel_primitive_block_size, [&] { temp[i] = op(temp[i], temp[i + stride]); });
+    }
+    group_memory_barrier();
+    Var total = temp[0u];
+    return total;
+}
+
+}// namespace detail
+
+}// namespace luisa::compute
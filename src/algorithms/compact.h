@@ -0,0 +1,78 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <algorithms/scan.h>
+
+namespace luisa::compute {
+
+// Stream compaction: copies the elements satisfying a predicate to the front
+// of the output, keeping their order, and writes their number. Unlike the
+// atomic compaction of RayQueue, output slots come from a scan of the flags,
+// so the result is deterministic. Input and output must not alias. The
+// compaction holds scratch buffers, so it must not be used by several
+// streams at the same time.
+template<typename T>
+class CompactIf : concepts::Noncopyable {
+
+private:
+    Buffer<uint> _flags;
+    Buffer<uint> _offsets;
+    Scan<uint> _scan;
+    Shader1D<Buffer<T>, Buffer<uint>, uint> _mark;
+    Shader1D<Buffer<T>, Buffer<uint>, Buffer<T>, Buffer<uint>, uint> _scatter;
+
+public:
+    CompactIf(Device &device, size_t capacity, const Callable<bool(T)> &predicate) noexcept
+        : _flags{device.create_buffer<uint>(std::max(capacity, size_t{1u}))},
+          _offsets{device.create_buffer<uint>(std::max(capacity, size_t{1u}))},
+          _scan{device, capacity, Callable<uint(uint, uint)>{[](UInt lhs, UInt rhs) noexcept { return lhs + rhs; }}, 0u} {
+        Kernel1D mark_kernel = [&predicate](BufferVar<T> input, BufferUInt flags, UInt count) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            auto i = dispatch_x();
+            if_(i < count, [&] { flags[i] = select(0u, 1u, predicate(input[i])); });
+        };
+        // offsets holds the inclusive scan of the flags, so an element is
+        // selected iff its offset exceeds the previous one
+        Kernel1D scatter_kernel = [](BufferVar<T> input, BufferUInt offsets, BufferVar<T> output,
+                                     BufferUInt selected_count, UInt count) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            auto i = dispatch_x();
+            if_(i < count, [&] {
+                Var offset = offsets[i];
+                Var previous = 0u;
+                if_(i != 0u, [&] { previous = offsets[i - 1u]; });
+                if_(offset > previous, [&] { output[previous] = input[i]; });
+                if_(i == count - 1u, [&] { selected_count[0u] = offset; });
+            });
+            if_(i == 0u && count == 0u, [&] { selected_count[0u] = 0u; });
+        };
+        _mark = device.compile(mark_kernel);
+        _scatter = device.compile(scatter_kernel);
+    }
+
+    [[nodiscard]] auto capacity() const noexcept { return _scan.capacity(); }
+
+    // compacts input into output and writes the number of selected elements to count[0]
+    [[nodiscard]] Command *operator()(BufferView<T> input, BufferView<T> output, BufferView<uint> count) noexcept {
+        detail::check_parallel_primitive_size("compaction", input.size(), capacity());
+        if (output.size() < input.size() || count.size() == 0u) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Invalid compaction (input = {}, output = {}, count = {}).",
+                input.size(), output.size(), count.size());
+        }
+        auto n = static_cast<uint>(input.size());
+        auto dispatch_size = static_cast<uint>(detail::parallel_primitive_levels(n).front() * parallel_primitive_block_size);
+        auto flags = _flags.view(0u, n);
+        auto offsets = _offsets.view(0u, n);
+        detail::CommandChain chain;
+        chain << _mark(input, flags, n).dispatch(dispatch_size)
+              << _scan.inclusive(flags, offsets)
+              << _scatter(input, offsets, output, count, n).dispatch(dispatch_size);
+        return chain.head();
+    }
+};
+
+}// namespace luisa::compute
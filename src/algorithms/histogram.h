@@ -0,0 +1,97 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <limits>
+
+#include <runtime/device.h>
+#include <runtime/buffer.h>
+#include <runtime/shader.h>
+#include <algorithms/block.h>
+
+namespace luisa::compute {
+
+// Counts the elements falling into each of bin_count bins, as given by a bin
+// function; elements mapped to bins outside [0, bin_count) are not counted.
+// Up to shared_histogram_max_bins bins, each block counts into a histogram in
+// shared memory and merges its non-empty bins, so that contended bins cost
+// one device atomic per block instead of one per element.
+template<typename T>
+class Histogram : concepts::Noncopyable {
+
+public:
+    static constexpr auto shared_histogram_max_bins = 4096u;
+
+private:
+    uint _bin_count;
+    Shader1D<Buffer<uint>, uint> _clear;
+    Shader1D<Buffer<T>, Buffer<uint>, uint> _count;
+
+public:
+    Histogram(Device &device, uint bin_count, const Callable<uint(T)> &bin) noexcept
+        : _bin_count{bin_count} {
+        if (bin_count == 0u) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Empty histogram."); }
+        Kernel1D clear_kernel = [](BufferUInt bins, UInt bin_count) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            auto i = dispatch_x();
+            if_(i < bin_count, [&] { bins[i] = 0u; });
+        };
+        _clear = device.compile(clear_kernel);
+        if (bin_count <= shared_histogram_max_bins) {
+            Kernel1D count_kernel = [&bin, bin_count](BufferVar<T> input, BufferUInt bins, UInt count) noexcept {
+                set_block_size(parallel_primitive_block_size);
+                Shared<uint> local_bins{bin_count};
+                auto i = dispatch_x();
+                auto tid = thread_x();
+                for (auto b = 0u; b < bin_count; b += parallel_primitive_block_size) {
+                    if_(tid + b < bin_count, [&] { local_bins[tid + b] = 0u; });
+                }
+                group_memory_barrier();
+                if_(i < count, [&] {
+                    Var index = bin(input[i]);
+                    if_(index < bin_count, [&] { [[maybe_unused]] Var old = local_bins.atomic(index).fetch_add(1u); });
+                });
+                group_memory_barrier();
+                for (auto b = 0u; b < bin_count; b += parallel_primitive_block_size) {
+                    if_(tid + b < bin_count, [&] {
+                        Var n = local_bins[tid + b];
+                        if_(n != 0u, [&] { [[maybe_unused]] Var old = bins.atomic(tid + b).fetch_add(n); });
+                    });
+                }
+            };
+            _count = device.compile(count_kernel);
+        } else {
+            Kernel1D count_kernel = [&bin, bin_count](BufferVar<T> input, BufferUInt bins, UInt count) noexcept {
+                set_block_size(parallel_primitive_block_size);
+                auto i = dispatch_x();
+                if_(i < count, [&] {
+                    Var index = bin(input[i]);
+                    if_(index < bin_count, [&] { [[maybe_unused]] Var old = bins.atomic(index).fetch_add(1u); });
+                });
+            };
+            _count = device.compile(count_kernel);
+        }
+    }
+
+    [[nodiscard]] auto bin_count() const noexcept { return _bin_count; }
+
+    // clears bins[0, bin_count) and counts input into them
+    [[nodiscard]] Command *operator()(BufferView<T> input, BufferView<uint> bins) noexcept {
+        detail::check_parallel_primitive_size("histogram", input.size(), std::numeric_limits<uint>::max());
+        if (bins.size() < _bin_count) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Histogram has {} bin(s) instead of {}.",
+                bins.size(), _bin_count);
+        }
+        auto n = static_cast<uint>(input.size());
+        auto blocks = [](size_t count) noexcept { return detail::parallel_primitive_levels(count).front(); };
+        detail::CommandChain chain;
+        chain << _clear(bins, _bin_count).dispatch(static_cast<uint>(blocks(_bin_count) * parallel_primitive_block_size))
+              << _count(input, bins, n).dispatch(static_cast<uint>(blocks(n) * parallel_primitive_block_size));
+        return chain.head();
+    }
+};
+
+}// namespace luisa::compute
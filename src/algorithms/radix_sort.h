@@ -0,0 +1,331 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <bit>
+#include <span>
+#include <array>
+#include <utility>
+#include <vector>
+#include <concepts>
+
+#include <algorithms/scan.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+// host LSD radix sort over 8-bit digits; values may be empty
+template<typename Key>
+void host_radix_sort(std::span<Key> keys, std::span<uint> values, uint key_bits) noexcept {
+    static constexpr auto digit_bits = 8u;
+    static constexpr auto radix = 1u << digit_bits;
+    if (key_bits == 0u || key_bits > sizeof(Key) * 8u || (!values.empty() && values.size() != keys.size())) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid host radix sort (keys = {}, values = {}, key_bits = {}).",
+            keys.size(), values.size(), key_bits);
+    }
+    std::vector<Key> sorted_keys(keys.size());
+    std::vector<uint> sorted_values(values.size());
+    for (auto shift = 0u; shift < key_bits; shift += digit_bits) {
+        auto mask = (1u << std::min(digit_bits, key_bits - shift)) - 1u;
+        std::array<size_t, radix> offsets{};
+        for (auto k : keys) { offsets[(k >> shift) & mask]++; }
+        auto offset = size_t{0u};
+        for (auto &&o : offsets) { o = std::exchange(offset, offset + o); }
+        for (auto i = 0u; i < keys.size(); i++) {
+            auto slot = offsets[(keys[i] >> shift) & mask]++;
+            sorted_keys[slot] = keys[i];
+            if (!values.empty()) { sorted_values[slot] = values[i]; }
+        }
+        std::copy(sorted_keys.cbegin(), sorted_keys.cend(), keys.begin());
+        std::copy(sorted_values.cbegin(), sorted_values.cend(), values.begin());
+    }
+}
+
+}// namespace detail
+
+// Host equivalents of the device sorts below, e.g. for CPU devices. They sort
+// by the lowest key_bits bits of the keys, stably, with the same results as
+// the device sorts.
+template<typename Key>
+requires std::same_as<Key, uint32_t> || std::same_as<Key, uint64_t>
+void radix_sort_keys(std::span<Key> keys, uint key_bits = sizeof(Key) * 8u) noexcept {
+    detail::host_radix_sort(keys, {}, key_bits);
+}
+
+template<typename Key>
+requires std::same_as<Key, uint32_t> || std::same_as<Key, uint64_t>
+void radix_sort_pairs(std::span<Key> keys, std::span<uint> values, uint key_bits = sizeof(Key) * 8u) noexcept {
+    detail::host_radix_sort(keys, values, key_bits);
+}
+
+// segment s holds the elements in [segment_offsets[s], segment_offsets[s + 1])
+inline void segmented_sort(std::span<uint> keys, std::span<uint> values,
+                           std::span<const uint> segment_offsets, uint key_bits = 32u) noexcept {
+    for (auto s = 0u; s + 1u < segment_offsets.size(); s++) {
+        auto begin = segment_offsets[s];
+        auto count = segment_offsets[s + 1u] - begin;
+        detail::host_radix_sort(keys.subspan(begin, count),
+                                values.empty() ? values : values.subspan(begin, count),
+                                key_bits);
+    }
+}
+
+// Device LSD radix sort of uint keys, or of 64-bit keys stored as uint2 (low
+// word first, as uint64_t on little-endian hosts), optionally carrying uint
+// values, e.g. ray or hit indices. Each pass sorts 4 bits: blocks count their
+// digits, the counts are scanned digit by digit over the blocks, and blocks
+// scatter their keys, ranked by a scan of packed digit counters, so that the
+// sort is stable. Keys and values are sorted in place through scratch buffers,
+// so the sort must not be used by several streams at the same time.
+template<typename Key>
+class RadixSort : concepts::Noncopyable {
+
+    static_assert(std::is_same_v<Key, uint> || std::is_same_v<Key, uint2>);
+
+public:
+    static constexpr auto digit_bits = 4u;
+    static constexpr auto radix = 1u << digit_bits;
+    static constexpr auto max_key_bits = static_cast<uint>(sizeof(Key) * 8u);
+
+private:
+    size_t _capacity;
+    Buffer<Key> _keys;
+    Buffer<uint> _values;
+    Buffer<uint> _block_counts;
+    Buffer<uint> _block_offsets;
+    Scan<uint> _scan;
+    Shader1D<Buffer<Key>, Buffer<uint>, uint, uint, uint> _count_digits;
+    Shader1D<Buffer<Key>, Buffer<Key>, Buffer<uint>, uint, uint, uint> _scatter_keys;
+    Shader1D<Buffer<Key>, Buffer<uint>, Buffer<Key>, Buffer<uint>, Buffer<uint>, uint, uint, uint> _scatter_pairs;
+
+private:
+    // the last digit is masked to the remaining key bits
+    [[nodiscard]] static auto _digit(detail::Expr<Key> key, detail::Expr<uint> shift, detail::Expr<uint> mask) noexcept {
+        if constexpr (std::is_same_v<Key, uint>) {
+            return (key >> shift) & mask;
+        } else {
+            return (select(key.y, key.x, shift < 32u) >> (shift & 31u)) & mask;
+        }
+    }
+
+    [[nodiscard]] Command *_sort(BufferView<Key> keys, BufferView<uint> values, bool has_values, uint key_bits) noexcept {
+        detail::check_parallel_primitive_size("radix sort", keys.size(), _capacity);
+        if (key_bits == 0u || key_bits > max_key_bits || (has_values && values.size() != keys.size())) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Invalid radix sort (keys = {}, values = {}, key_bits = {}).",
+                keys.size(), values.size(), key_bits);
+        }
+        auto n = static_cast<uint>(keys.size());
+        auto blocks = detail::parallel_primitive_levels(n).front();
+        auto dispatch_size = static_cast<uint>(blocks * parallel_primitive_block_size);
+        auto block_counts = _block_counts.view(0u, blocks * radix);
+        auto block_offsets = _block_offsets.view(0u, blocks * radix);
+        std::array src_keys{keys, _keys.view(0u, n)};
+        std::array src_values{values, _values.view(0u, n)};
+        detail::CommandChain chain;
+        auto pass = 0u;
+        for (auto shift = 0u; shift < key_bits; shift += digit_bits, pass ^= 1u) {
+            auto mask = (1u << std::min(digit_bits, key_bits - shift)) - 1u;
+            chain << _count_digits(src_keys[pass], block_counts, n, shift, mask).dispatch(dispatch_size)
+                  << _scan.exclusive(block_counts, block_offsets);
+            if (has_values) {
+                chain << _scatter_pairs(src_keys[pass], src_values[pass], src_keys[pass ^ 1u], src_values[pass ^ 1u],
+                                        block_offsets, n, shift, mask)
+                             .dispatch(dispatch_size);
+            } else {
+                chain << _scatter_keys(src_keys[pass], src_keys[pass ^ 1u], block_offsets, n, shift, mask).dispatch(dispatch_size);
+            }
+        }
+        if (pass == 1u) {// sorted into the scratch buffers
+            chain << keys.copy_from(src_keys[1u]);
+            if (has_values) { chain << values.copy_from(src_values[1u]); }
+        }
+        return chain.head();
+    }
+
+public:
+    RadixSort(Device &device, size_t capacity) noexcept
+        : _capacity{capacity},
+          _keys{device.create_buffer<Key>(std::max(capacity, size_t{1u}))},
+          _values{device.create_buffer<uint>(std::max(capacity, size_t{1u}))},
+          _block_counts{device.create_buffer<uint>(detail::parallel_primitive_levels(capacity).front() * radix)},
+          _block_offsets{device.create_buffer<uint>(detail::parallel_primitive_levels(capacity).front() * radix)},
+          _scan{device, detail::parallel_primitive_levels(capacity).front() * radix,
+                Callable<uint(uint, uint)>{[](UInt lhs, UInt rhs) noexcept { return lhs + rhs; }}, 0u} {
+
+        // block_counts[digit * blocks + block], so that the exclusive scan
+        // gives the first slot of each block for each digit
+        Kernel1D count_digits_kernel = [](BufferVar<Key> keys, BufferUInt block_counts, UInt count, UInt shift, UInt mask) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            Shared<uint> counts{radix};
+            auto i = dispatch_x();
+            auto tid = thread_x();
+            if_(tid < radix, [&] { counts[tid] = 0u; });
+            group_memory_barrier();
+            if_(i < count, [&] { [[maybe_unused]] Var old = counts.atomic(_digit(keys[i], shift, mask)).fetch_add(1u); });
+            group_memory_barrier();
+            if_(tid < radix, [&] {
+                block_counts[tid * (dispatch_size_x() / parallel_primitive_block_size) + block_x()] = counts[tid];
+            });
+        };
+        _count_digits = device.compile(count_digits_kernel);
+
+        // 16-bit counters of the 16 digits are packed into two uint4, and
+        // scanned over the block to rank each key among the equal digits
+        Callable<uint4(uint4, uint4)> add = [](UInt4 lhs, UInt4 rhs) noexcept { return lhs + rhs; };
+        auto scatter = [&add](const BufferVar<Key> &keys, const BufferVar<Key> &sorted_keys,
+                              const BufferUInt &block_offsets, detail::Expr<uint> count, detail::Expr<uint> shift, detail::Expr<uint> mask,
+                              auto &&scatter_value) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            Shared<uint4> temp{parallel_primitive_block_size};
+            auto i = dispatch_x();
+            Var<Key> key;
+            Var<uint> digit = radix;// out-of-range threads count for no digit
+            if_(i < count, [&] {
+                key = keys[i];
+                digit = _digit(key, shift, mask);
+            });
+            Var word = digit >> 1u;
+            Var bit = (digit & 1u) << 4u;
+            Var flag = 1u << bit;
+            auto counter = [&](uint first_word) noexcept {
+                return make_uint4(select(0u, flag, word == first_word), select(0u, flag, word == first_word + 1u),
+                                  select(0u, flag, word == first_word + 2u), select(0u, flag, word == first_word + 3u));
+            };
+            auto lo = detail::block_inclusive_scan(temp, counter(0u), add);
+            auto hi = detail::block_inclusive_scan(temp, counter(4u), add);
+            if_(i < count, [&] {
+                Var counters = lo;
+                if_(word >= 4u, [&] { counters = hi; });
+                Var rank = ((counters[word & 3u] >> bit) & 0xffffu) - 1u;
+                Var slot = block_offsets[digit * (dispatch_size_x() / parallel_primitive_block_size) + block_x()] + rank;
+                sorted_keys[slot] = key;
+                scatter_value(slot);
+            });
+        };
+        Kernel1D scatter_keys_kernel = [&](BufferVar<Key> keys, BufferVar<Key> sorted_keys, BufferUInt block_offsets,
+                                           UInt count, UInt shift, UInt mask) noexcept {
+            scatter(keys, sorted_keys, block_offsets, count, shift, mask, [](auto &&) noexcept {});
+        };
+        Kernel1D scatter_pairs_kernel = [&](BufferVar<Key> keys, BufferUInt values, BufferVar<Key> sorted_keys,
+                                            BufferUInt sorted_values, BufferUInt block_offsets, UInt count, UInt shift, UInt mask) noexcept {
+            scatter(keys, sorted_keys, block_offsets, count, shift, mask, [&](auto &&slot) noexcept {
+                sorted_values[slot] = values[dispatch_x()];
+            });
+        };
+        _scatter_keys = device.compile(scatter_keys_kernel);
+        _scatter_pairs = device.compile(scatter_pairs_kernel);
+    }
+
+    [[nodiscard]] auto capacity() const noexcept { return _capacity; }
+
+    // sorts keys in place by their lowest key_bits bits
+    [[nodiscard]] Command *sort_keys(BufferView<Key> keys, uint key_bits = max_key_bits) noexcept {
+        return _sort(keys, _values.view(0u, 0u), false, key_bits);
+    }
+
+    // sorts keys and moves values along, in place, by the lowest key_bits bits of the keys
+    [[nodiscard]] Command *sort_pairs(BufferView<Key> keys, BufferView<uint> values, uint key_bits = max_key_bits) noexcept {
+        return _sort(keys, values, true, key_bits);
+    }
+};
+
+// Sorts uint keys and values in place within segments, where segment s holds
+// the elements in [segment_offsets[s], segment_offsets[s + 1]) and the offsets
+// cover all elements. Elements are sorted by their segment and key together,
+// as 64-bit keys with a single radix sort, instead of one sort per segment,
+// so that many small segments, e.g. hits grouped by pixel tile, still fill
+// the device.
+class SegmentedSort : concepts::Noncopyable {
+
+private:
+    Buffer<uint2> _composite_keys;
+    Buffer<uint> _indices;
+    Buffer<uint> _keys;
+    Buffer<uint> _values;
+    RadixSort<uint2> _sort;
+    Shader1D<Buffer<uint>, Buffer<uint>, Buffer<uint2>, Buffer<uint>, uint, uint, uint> _make_composite_keys;
+    Shader1D<Buffer<uint>, Buffer<uint>, Buffer<uint>, uint> _gather;
+
+private:
+    [[nodiscard]] Command *_sort_segments(BufferView<uint> keys, BufferView<uint> values, bool has_values,
+                                          BufferView<uint> segment_offsets, uint key_bits) noexcept {
+        if (segment_offsets.size() < 2u || key_bits == 0u || key_bits > 32u ||
+            (has_values && values.size() != keys.size())) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Invalid segmented sort (keys = {}, values = {}, segment_offsets = {}, key_bits = {}).",
+                keys.size(), values.size(), segment_offsets.size(), key_bits);
+        }
+        auto n = static_cast<uint>(keys.size());
+        auto segment_count = static_cast<uint>(segment_offsets.size() - 1u);
+        auto segment_bits = static_cast<uint>(std::bit_width(segment_count - 1u));
+        auto dispatch_size = static_cast<uint>(detail::parallel_primitive_levels(n).front() * parallel_primitive_block_size);
+        auto composite_keys = _composite_keys.view(0u, n);
+        auto indices = _indices.view(0u, n);
+        detail::CommandChain chain;
+        chain << _make_composite_keys(keys, segment_offsets, composite_keys, indices, n, segment_count, key_bits).dispatch(dispatch_size)
+              << _sort.sort_pairs(composite_keys, indices, key_bits + segment_bits)
+              << _gather(keys, indices, _keys, n).dispatch(dispatch_size)
+              << keys.copy_from(_keys.view(0u, n));
+        if (has_values) {
+            chain << _gather(values, indices, _values, n).dispatch(dispatch_size)
+                  << values.copy_from(_values.view(0u, n));
+        }
+        return chain.head();
+    }
+
+public:
+    SegmentedSort(Device &device, size_t capacity) noexcept
+        : _composite_keys{device.create_buffer<uint2>(std::max(capacity, size_t{1u}))},
+          _indices{device.create_buffer<uint>(std::max(capacity, size_t{1u}))},
+          _keys{device.create_buffer<uint>(std::max(capacity, size_t{1u}))},
+          _values{device.create_buffer<uint>(std::max(capacity, size_t{1u}))},
+          _sort{device, capacity} {
+
+        // (segment << key_bits) | (key & mask) as a 64-bit key, with the
+        // segment found by bisection over the offsets
+        Kernel1D make_composite_keys_kernel = [](BufferUInt keys, BufferUInt segment_offsets, BufferVar<uint2> composite_keys,
+                                                 BufferUInt indices, UInt count, UInt segment_count, UInt key_bits) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            auto i = dispatch_x();
+            if_(i < count, [&] {
+                Var lo = 0u;
+                Var hi = segment_count;
+                while_(lo + 1u < hi, [&] {
+                    Var mid = (lo + hi) >> 1u;
+                    if_(segment_offsets[mid] <= i, [&] { lo = mid; }).else_([&] { hi = mid; });
+                });
+                Var mask = select(~0u, (1u << key_bits) - 1u, key_bits < 32u);
+                Var segment_lo = select(0u, lo << key_bits, key_bits < 32u);
+                composite_keys[i] = make_uint2((keys[i] & mask) | segment_lo, lo >> (32u - key_bits));
+                indices[i] = i;
+            });
+        };
+        Kernel1D gather_kernel = [](BufferUInt input, BufferUInt indices, BufferUInt output, UInt count) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            auto i = dispatch_x();
+            if_(i < count, [&] { output[i] = input[indices[i]]; });
+        };
+        _make_composite_keys = device.compile(make_composite_keys_kernel);
+        _gather = device.compile(gather_kernel);
+    }
+
+    [[nodiscard]] auto capacity() const noexcept { return _sort.capacity(); }
+
+    // sorts keys in place within the segments by their lowest key_bits bits
+    [[nodiscard]] Command *operator()(BufferView<uint> keys, BufferView<uint> segment_offsets, uint key_bits = 32u) noexcept {
+        return _sort_segments(keys, _values.view(0u, 0u), false, segment_offsets, key_bits);
+    }
+
+    // sorts keys and moves values along, in place, within the segments
+    [[nodiscard]] Command *operator()(BufferView<uint> keys, BufferView<uint> values,
+                                      BufferView<uint> segment_offsets, uint key_bits = 32u) noexcept {
+        return _sort_segments(keys, values, true, segment_offsets, key_bits);
+    }
+};
+
+}// namespace luisa::compute
@@ -0,0 +1,67 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <runtime/device.h>
+#include <runtime/buffer.h>
+#include <runtime/shader.h>
+#include <algorithms/block.h>
+
+namespace luisa::compute {
+
+// Device-wide reduction with an associative operator op and its identity,
+// e.g. a sum, a minimum or the union of bounding boxes. Each pass reduces
+// blocks of elements into partial results until one block is left. Operands
+// are combined in order, so op needs not be commutative. The reduction holds
+// scratch buffers, so it must not be used by several streams at the same time.
+template<typename T>
+class Reduce : concepts::Noncopyable {
+
+private:
+    T _identity;
+    size_t _capacity;
+    std::vector<Buffer<T>> _partials;
+    Shader1D<Buffer<T>, Buffer<T>, uint, T> _reduce_blocks;
+
+public:
+    Reduce(Device &device, size_t capacity, const Callable<T(T, T)> &op, T identity) noexcept
+        : _identity{identity}, _capacity{capacity} {
+        auto levels = detail::parallel_primitive_levels(capacity);
+        for (auto i = 0u; i + 1u < levels.size(); i++) {
+            _partials.emplace_back(device.create_buffer<T>(levels[i]));
+        }
+        Kernel1D reduce_blocks_kernel = [&op](BufferVar<T> input, BufferVar<T> output, UInt count, Var<T> identity) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            Shared<T> temp{parallel_primitive_block_size};
+            auto i = dispatch_x();
+            Var x = identity;
+            if_(i < count, [&] { x = input[i]; });
+            auto total = detail::block_reduce(temp, x, op);
+            if_(thread_x() == 0u, [&] { output[block_x()] = total; });
+        };
+        _reduce_blocks = device.compile(reduce_blocks_kernel);
+    }
+
+    [[nodiscard]] auto capacity() const noexcept { return _capacity; }
+
+    // reduces all of input into result[0], which is identity for empty inputs
+    [[nodiscard]] Command *operator()(BufferView<T> input, BufferView<T> result) noexcept {
+        detail::check_parallel_primitive_size("reduction", input.size(), _capacity);
+        if (result.size() == 0u) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Empty reduction result."); }
+        detail::CommandChain chain;
+        auto levels = detail::parallel_primitive_levels(input.size());
+        auto count = input.size();
+        for (auto i = 0u; i < levels.size(); i++) {
+            auto output = i + 1u == levels.size() ? result.subview(0u, 1u) : _partials[i].view(0u, levels[i]);
+            chain << _reduce_blocks(input, output, static_cast<uint>(count), _identity)
+                         .dispatch(static_cast<uint>(levels[i] * parallel_primitive_block_size));
+            input = output;
+            count = levels[i];
+        }
+        return chain.head();
+    }
+};
+
+}// namespace luisa::compute
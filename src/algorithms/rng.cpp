@@ -0,0 +1,112 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <algorithms/rng.h>
+
+namespace luisa::compute {
+
+void philox_uniform(std::span<float> values, uint sample_index, uint2 key) noexcept {
+    static constexpr auto lanes = 8u;
+    for (auto base = size_t{0u}; base < values.size(); base += 4u * lanes) {
+        uint32_t c[4][lanes];
+        for (auto i = 0u; i < lanes; i++) {
+            c[0][i] = static_cast<uint32_t>(base / 4u + i);
+            c[1][i] = 0u;
+            c[2][i] = 0u;
+            c[3][i] = sample_index;
+        }
+        detail::philox4x32_lanes(c, key.x, key.y);
+        auto count = std::min(values.size() - base, size_t{4u * lanes});
+        for (auto i = 0u; i < count; i++) {
+            values[base + i] = detail::random_uint_to_float(c[i % 4u][i / 4u]);
+        }
+    }
+}
+
+void squares_uniform(std::span<float> values, uint sample_index, uint64_t key) noexcept {
+    auto high = static_cast<uint64_t>(sample_index) << 32u;
+    for (auto i = size_t{0u}; i < values.size(); i++) {
+        values[i] = detail::random_uint_to_float(squares32(high | static_cast<uint32_t>(i), key));
+    }
+}
+
+namespace detail {
+
+// high word of the 64-bit product, from the products of the 16-bit halves
+[[nodiscard]] static auto mul_hi(Expr<uint> a, Expr<uint> b) noexcept {
+    static Callable _mul_hi = [](UInt a, UInt b) noexcept {
+        Var a_lo = a & 0xffffu;
+        Var a_hi = a >> 16u;
+        Var b_lo = b & 0xffffu;
+        Var b_hi = b >> 16u;
+        Var lo_hi = a_lo * b_hi;
+        Var hi_lo = a_hi * b_lo;
+        Var mid = ((a_lo * b_lo) >> 16u) + (lo_hi & 0xffffu) + (hi_lo & 0xffffu);
+        return a_hi * b_hi + (lo_hi >> 16u) + (hi_lo >> 16u) + (mid >> 16u);
+    };
+    return _mul_hi(a, b);
+}
+
+// lower 64 bits of a * b and a + b, on (low, high) words
+[[nodiscard]] static auto mul64(Expr<uint2> a, Expr<uint2> b) noexcept {
+    static Callable _mul64 = [](UInt2 a, UInt2 b) noexcept {
+        return make_uint2(a.x * b.x, mul_hi(a.x, b.x) + a.x * b.y + a.y * b.x);
+    };
+    return _mul64(a, b);
+}
+
+[[nodiscard]] static auto add64(Expr<uint2> a, Expr<uint2> b) noexcept {
+    static Callable _add64 = [](UInt2 a, UInt2 b) noexcept {
+        Var lo = a.x + b.x;
+        return make_uint2(lo, a.y + b.y + select(0u, 1u, lo < a.x));
+    };
+    return _add64(a, b);
+}
+
+}// namespace detail
+
+detail::Expr<uint4> philox4x32(detail::Expr<uint4> counter, detail::Expr<uint2> key) noexcept {
+    static Callable _philox4x32 = [](UInt4 counter, UInt2 key) noexcept {
+        Var c = counter;
+        Var k = key;
+        for (auto round = 0u; round < 10u; round++) {
+            Var hi0 = detail::mul_hi(detail::philox_m0, c.x);
+            Var hi1 = detail::mul_hi(detail::philox_m1, c.z);
+            c = make_uint4(hi1 ^ c.y ^ k.x, detail::philox_m1 * c.z,
+                           hi0 ^ c.w ^ k.y, detail::philox_m0 * c.x);
+            k += make_uint2(detail::philox_w0, detail::philox_w1);
+        }
+        return c;
+    };
+    return _philox4x32(counter, key);
+}
+
+detail::Expr<uint> squares32(detail::Expr<uint2> counter, detail::Expr<uint2> key) noexcept {
+    static Callable _squares32 = [](UInt2 counter, UInt2 key) noexcept {
+        Var x = detail::mul64(counter, key);
+        Var y = x;
+        Var z = detail::add64(y, key);
+        x = detail::add64(detail::mul64(x, x), y).yx();
+        x = detail::add64(detail::mul64(x, x), z).yx();
+        x = detail::add64(detail::mul64(x, x), y).yx();
+        return detail::add64(detail::mul64(x, x), z).y;
+    };
+    return _squares32(counter, key);
+}
+
+detail::Expr<float4> philox_uniform(detail::Expr<uint3> id, detail::Expr<uint> sample_index, detail::Expr<uint2> key) noexcept {
+    static Callable _philox_uniform = [](UInt3 id, UInt sample_index, UInt2 key) noexcept {
+        return make_float4(philox4x32(make_uint4(id, sample_index), key) >> 8u) * 0x1p-24f;
+    };
+    return _philox_uniform(id, sample_index, key);
+}
+
+detail::Expr<float> squares_uniform(detail::Expr<uint> index, detail::Expr<uint> sample_index, detail::Expr<uint2> key) noexcept {
+    static Callable _squares_uniform = [](UInt index, UInt sample_index, UInt2 key) noexcept {
+        return cast<float>(squares32(make_uint2(index, sample_index), key) >> 8u) * 0x1p-24f;
+    };
+    return _squares_uniform(index, sample_index, key);
+}
+
+}// namespace luisa::compute
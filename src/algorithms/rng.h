@@ -0,0 +1,100 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <span>
+
+#include <core/basic_types.h>
+#include <dsl/syntax.h>
+
+namespace luisa::compute {
+
+// Counter-based random number generators: each number is a pure function of
+// a counter and a key, so kernels seek streams by (dispatch id, sample index)
+// and need no state buffers, and hosts and devices produce the same streams.
+// - Philox4x32-10 (Salmon et al. [2011]) gives 4 numbers per counter;
+// - Squares (Widynski [2020]) gives 1 number per 64-bit counter, with keys
+//   made of well-mixed hexadecimal digits, e.g. squares_default_key.
+// 64-bit products are emulated with 32-bit ones in kernels, since the DSL has
+// no 64-bit integers; 64-bit counters and keys are uint2 there (low word first).
+
+static constexpr uint64_t squares_default_key = 0xc8e4fd154ce32f6dull;
+
+namespace detail {
+
+static constexpr auto philox_m0 = 0xd2511f53u;
+static constexpr auto philox_m1 = 0xcd9e8d57u;
+static constexpr auto philox_w0 = 0x9e3779b9u;
+static constexpr auto philox_w1 = 0xbb67ae85u;
+
+// Philox4x32-10 over N counters, lane by lane, so that the compiler
+// vectorizes the rounds to the width of the target
+template<uint N>
+inline void philox4x32_lanes(uint32_t (&c)[4][N], uint32_t k0, uint32_t k1) noexcept {
+    for (auto round = 0u; round < 10u; round++) {
+        for (auto i = 0u; i < N; i++) {
+            auto p0 = static_cast<uint64_t>(philox_m0) * c[0][i];
+            auto p1 = static_cast<uint64_t>(philox_m1) * c[2][i];
+            auto x0 = static_cast<uint32_t>(p1 >> 32u) ^ c[1][i] ^ k0;
+            auto x2 = static_cast<uint32_t>(p0 >> 32u) ^ c[3][i] ^ k1;
+            c[1][i] = static_cast<uint32_t>(p1);
+            c[3][i] = static_cast<uint32_t>(p0);
+            c[0][i] = x0;
+            c[2][i] = x2;
+        }
+        k0 += philox_w0;
+        k1 += philox_w1;
+    }
+}
+
+// maps the 24 high bits to [0, 1), exactly as the kernels do
+[[nodiscard]] constexpr auto random_uint_to_float(uint32_t x) noexcept {
+    return static_cast<float>(x >> 8u) * 0x1p-24f;
+}
+
+}// namespace detail
+
+[[nodiscard]] inline auto philox4x32(uint4 counter, uint2 key) noexcept {
+    uint32_t c[4][1]{{counter.x}, {counter.y}, {counter.z}, {counter.w}};
+    detail::philox4x32_lanes(c, key.x, key.y);
+    return luisa::make_uint4(c[0][0], c[1][0], c[2][0], c[3][0]);
+}
+
+[[nodiscard]] constexpr auto squares32(uint64_t counter, uint64_t key) noexcept {
+    auto x = counter * key;
+    auto y = x;
+    auto z = y + key;
+    x = x * x + y;
+    x = (x >> 32u) | (x << 32u);
+    x = x * x + z;
+    x = (x >> 32u) | (x << 32u);
+    x = x * x + y;
+    x = (x >> 32u) | (x << 32u);
+    return static_cast<uint32_t>((x * x + z) >> 32u);
+}
+
+// Host streams, e.g. to fill buffers on CPU devices or to check kernels:
+// values[i] is component i % 4 of philox_uniform(make_uint3(i / 4, 0, 0), ...),
+// or squares_uniform(i, ...), as given by the kernel versions below.
+void philox_uniform(std::span<float> values, uint sample_index, uint2 key) noexcept;
+void squares_uniform(std::span<float> values, uint sample_index, uint64_t key = squares_default_key) noexcept;
+
+// Kernel versions. The uniform ones map each number to [0, 1) with 24 bits.
+[[nodiscard]] detail::Expr<uint4> philox4x32(detail::Expr<uint4> counter, detail::Expr<uint2> key) noexcept;
+[[nodiscard]] detail::Expr<uint> squares32(detail::Expr<uint2> counter, detail::Expr<uint2> key) noexcept;
+
+// counter (id, sample_index)
+[[nodiscard]] detail::Expr<float4> philox_uniform(
+    detail::Expr<uint3> id,
+    detail::Expr<uint> sample_index,
+    detail::Expr<uint2> key) noexcept;
+
+// counter (index, sample_index), i.e. index in the low word
+[[nodiscard]] detail::Expr<float> squares_uniform(
+    detail::Expr<uint> index,
+    detail::Expr<uint> sample_index,
+    detail::Expr<uint2> key) noexcept;
+
+}// namespace luisa::compute
@@ -0,0 +1,113 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <runtime/device.h>
+#include <runtime/buffer.h>
+#include <runtime/shader.h>
+#include <algorithms/block.h>
+
+namespace luisa::compute {
+
+// Device-wide prefix scans with an associative operator op and its identity.
+// Blocks are scanned in shared memory, their totals are scanned recursively
+// and then combined back into the blocks. Operands are combined in order, so
+// op needs not be commutative. Input and output must not alias. The scan holds
+// scratch buffers, so it must not be used by several streams at the same time.
+template<typename T>
+class Scan : concepts::Noncopyable {
+
+private:
+    T _identity;
+    size_t _capacity;
+    std::vector<Buffer<T>> _block_sums;
+    std::vector<Buffer<T>> _block_offsets;
+    Shader1D<Buffer<T>, Buffer<T>, Buffer<T>, uint, T> _scan_blocks_exclusive;
+    Shader1D<Buffer<T>, Buffer<T>, Buffer<T>, uint, T> _scan_blocks_inclusive;
+    Shader1D<Buffer<T>, Buffer<T>, uint> _add_block_offsets;
+
+private:
+    void _scan(detail::CommandChain &chain, BufferView<T> input, BufferView<T> output, size_t level, bool inclusive) noexcept {
+        auto count = input.size();
+        auto blocks = detail::parallel_primitive_levels(count).front();
+        auto block_sums = _block_sums[level].view(0u, blocks);
+        auto block_offsets = _block_offsets[level].view(0u, blocks);
+        auto dispatch_size = static_cast<uint>(blocks * parallel_primitive_block_size);
+        chain << (inclusive ? _scan_blocks_inclusive : _scan_blocks_exclusive)(
+                     input, output, block_sums, static_cast<uint>(count), _identity)
+                     .dispatch(dispatch_size);
+        if (blocks > 1u) {
+            _scan(chain, block_sums, block_offsets, level + 1u, false);
+            chain << _add_block_offsets(output, block_offsets, static_cast<uint>(count)).dispatch(dispatch_size);
+        }
+    }
+
+    [[nodiscard]] Command *_scan(BufferView<T> input, BufferView<T> output, bool inclusive) noexcept {
+        detail::check_parallel_primitive_size("scan", input.size(), _capacity);
+        if (output.size() < input.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Scan output is too small (input = {}, output = {}).",
+                input.size(), output.size());
+        }
+        detail::CommandChain chain;
+        _scan(chain, input, output, 0u, inclusive);
+        return chain.head();
+    }
+
+public:
+    Scan(Device &device, size_t capacity, const Callable<T(T, T)> &op, T identity) noexcept
+        : _identity{identity}, _capacity{capacity} {
+        for (auto blocks : detail::parallel_primitive_levels(capacity)) {
+            _block_sums.emplace_back(device.create_buffer<T>(blocks));
+            _block_offsets.emplace_back(device.create_buffer<T>(blocks));
+        }
+        // scans each block and writes its total to block_sums
+        auto compile_scan_blocks = [&](bool inclusive) noexcept {
+            Kernel1D scan_blocks_kernel = [&op, inclusive](BufferVar<T> input, BufferVar<T> output, BufferVar<T> block_sums,
+                                                           UInt count, Var<T> identity) noexcept {
+                set_block_size(parallel_primitive_block_size);
+                Shared<T> temp{parallel_primitive_block_size};
+                auto i = dispatch_x();
+                auto tid = thread_x();
+                Var x = identity;
+                if_(i < count, [&] { x = input[i]; });
+                auto prefix = detail::block_inclusive_scan(temp, x, op);
+                if (inclusive) {
+                    if_(i < count, [&] { output[i] = prefix; });
+                } else {
+                    Var previous = identity;
+                    if_(tid != 0u, [&] { previous = temp[tid - 1u]; });
+                    if_(i < count, [&] { output[i] = previous; });
+                }
+                if_(tid == parallel_primitive_block_size - 1u, [&] { block_sums[block_x()] = prefix; });
+            };
+            return device.compile(scan_blocks_kernel);
+        };
+        _scan_blocks_exclusive = compile_scan_blocks(false);
+        _scan_blocks_inclusive = compile_scan_blocks(true);
+
+        // block_offsets holds the exclusive scan of the block totals
+        Kernel1D add_block_offsets_kernel = [&op](BufferVar<T> output, BufferVar<T> block_offsets, UInt count) noexcept {
+            set_block_size(parallel_primitive_block_size);
+            auto i = dispatch_x();
+            if_(i < count, [&] { output[i] = op(block_offsets[block_x()], output[i]); });
+        };
+        _add_block_offsets = device.compile(add_block_offsets_kernel);
+    }
+
+    [[nodiscard]] auto capacity() const noexcept { return _capacity; }
+
+    // output[i] = input[0] op ... op input[i - 1], and identity for i = 0
+    [[nodiscard]] Command *exclusive(BufferView<T> input, BufferView<T> output) noexcept {
+        return _scan(input, output, false);
+    }
+
+    // output[i] = input[0] op ... op input[i]
+    [[nodiscard]] Command *inclusive(BufferView<T> input, BufferView<T> output) noexcept {
+        return _scan(input, output, true);
+    }
+};
+
+}// namespace luisa::compute
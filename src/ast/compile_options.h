@@ -0,0 +1,67 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <array>
+
+#include <core/hash.h>
+#include <core/logging.h>
+#include <core/basic_types.h>
+#include <ast/function.h>
+
+namespace luisa::compute {
+
+// Per-kernel code generation options, given to Device::compile() and passed
+// to backends along with the kernel. Backends ignore the ones they do not
+// support; the defaults are what kernels have always been compiled with.
+struct CompileOptions {
+
+    // lets backends reassociate floating-point operations and assume that
+    // there are no NaNs or infinities
+    bool fast_math{true};
+
+    // lets backends use approximations of the transcendental functions,
+    // e.g. CallOp::EXP, LOG, POW, RSQRT, SIN and COS
+    bool approximate_transcendentals{true};
+
+    // upper bound of loop unroll factors, 0 for the backend's heuristics
+    // and 1 to disable unrolling; backends that can only force a factor
+    // (e.g. Metal) honor 1 and leave other bounds to their heuristics
+    uint max_unroll{0u};
+
+    // overrides the block size of the kernel when non-zero; kernels reading
+    // block_size() have the one they are defined with baked in, so validate()
+    // rejects other overrides for them
+    uint3 block_size{};
+
+    [[nodiscard]] auto block_size_of(Function kernel) const noexcept {
+        return any(block_size == 0u) ? kernel.block_size() : block_size;
+    }
+
+    // aborts if the options cannot be applied to the kernel
+    void validate(Function kernel) const noexcept {
+        if (kernel.block_size_used() && any(block_size_of(kernel) != kernel.block_size())) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Block size override ({}, {}, {}) differs from the block size "
+                "({}, {}, {}) read by the kernel.",
+                block_size.x, block_size.y, block_size.z,
+                kernel.block_size().x, kernel.block_size().y, kernel.block_size().z);
+        }
+    }
+
+    [[nodiscard]] auto hash() const noexcept {
+        std::array<uint, 6u> data{fast_math, approximate_transcendentals, max_unroll,
+                                  block_size.x, block_size.y, block_size.z};
+        return xxh3_hash64(data.data(), sizeof(data));
+    }
+
+    // shader cache key of the kernel compiled with these options
+    [[nodiscard]] auto hash(uint64_t kernel_hash) const noexcept {
+        std::array<uint64_t, 2u> data{kernel_hash, hash()};
+        return xxh3_hash64(data.data(), sizeof(data));
+    }
+};
+
+}// namespace luisa::compute
@@ -68,8 +68,16 @@ bool Function::raytracing() const noexcept {
     return _builder->raytracing();
 }
 
+bool Function::block_size_used() const noexcept {
+    return _builder->block_size_used();
+}
+
 std::span<const Function::TextureHeapBinding> Function::captured_texture_heaps() const noexcept {
     return _builder->captured_texture_heaps();
 }
 
+std::span<const Function::AccelBinding> Function::captured_accels() const noexcept {
+    return _builder->captured_accels();
+}
+
 }// namespace luisa::compute
@@ -30,7 +30,8 @@ void FunctionBuilder::pop(const FunctionBuilder *func) noexcept {
              && f->shared_variables().empty()
              && f->captured_buffers().empty()
              && f->captured_textures().empty()
-             && f->captured_texture_heaps().empty())) [[unlikely]] {
+             && f->captured_texture_heaps().empty()
+             && f->captured_accels().empty())) [[unlikely]] {
         LUISA_ERROR_WITH_LOCATION(
             "Custom callables may not have builtin, "
             "shared or captured variables.");
@@ -58,10 +59,22 @@ void FunctionBuilder::_append(const Statement *statement) noexcept {
 }
 
 void FunctionBuilder::break_() noexcept {
+    if (!_jump_targets.empty() && _jump_targets.back() == JumpTarget::UNROLLED_LOOP) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Invalid break statement in unrolled loop.");
+    }
     _append(_arena->create<BreakStmt>());
 }
 
 void FunctionBuilder::continue_() noexcept {
+    // continue skips enclosing switches and applies to the innermost loop
+    for (auto i = _jump_targets.size(); i != 0u; i--) {
+        if (auto t = _jump_targets[i - 1u]; t != JumpTarget::SWITCH) {
+            if (t == JumpTarget::UNROLLED_LOOP) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION("Invalid continue statement in unrolled loop.");
+            }
+            break;
+        }
+    }
     _append(_arena->create<ContinueStmt>());
 }
 
@@ -239,6 +252,17 @@ void FunctionBuilder::pop_scope(const ScopeStmt *s) noexcept {
     _scope_stack.pop_back();
 }
 
+void FunctionBuilder::push_jump_target(JumpTarget t) noexcept {
+    _jump_targets.emplace_back(t);
+}
+
+void FunctionBuilder::pop_jump_target(JumpTarget t) noexcept {
+    if (_jump_targets.empty() || _jump_targets.back() != t) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Invalid jump target stack pop.");
+    }
+    _jump_targets.pop_back();
+}
+
 void FunctionBuilder::for_(const Statement *init, const Expression *condition, const Statement *update, const ScopeStmt *body) noexcept {
     _append(_arena->create<ForStmt>(init, condition, update, body));
 }
@@ -253,12 +277,14 @@ FunctionBuilder::FunctionBuilder(Arena *arena, FunctionBuilder::Tag tag) noexcep
     : _arena{arena},
       _body{ArenaVector<const Statement *>(*arena)},
       _scope_stack{*arena},
+      _jump_targets{*arena},
       _builtin_variables{*arena},
       _shared_variables{*arena},
       _captured_constants{*arena},
       _captured_buffers{*arena},
       _captured_textures{*arena},
       _captured_heaps{*arena},
+      _captured_accels{*arena},
       _arguments{*arena},
       _used_custom_callables{*arena},
       _used_builtin_callables{*arena},
@@ -322,6 +348,8 @@ const CallExpr *FunctionBuilder::call(const Type *type, Function custom, std::in
         iter == _used_custom_callables.cend()) {
         _used_custom_callables.emplace_back(custom);
     }
+    // the block size read by callables is baked in, too
+    if (custom.block_size_used()) { _block_size_used = true; }
     return expr;
 }
 
@@ -342,6 +370,10 @@ void FunctionBuilder::mark_raytracing() noexcept {
     _raytracing = true;
 }
 
+void FunctionBuilder::mark_block_size_used() noexcept {
+    _block_size_used = true;
+}
+
 const RefExpr *FunctionBuilder::texture_heap_binding(uint64_t handle) noexcept {
     if (auto iter = std::find_if(
             _captured_heaps.cbegin(),
@@ -355,6 +387,19 @@ const RefExpr *FunctionBuilder::texture_heap_binding(uint64_t handle) noexcept {
     return _ref(v);
 }
 
+const RefExpr *FunctionBuilder::accel_binding(uint64_t handle) noexcept {
+    if (auto iter = std::find_if(
+            _captured_accels.cbegin(),
+            _captured_accels.cend(),
+            [handle](auto &&binding) { return binding.handle == handle; });
+        iter != _captured_accels.cend()) {
+        return _ref(iter->variable);
+    }
+    Variable v{Type::of<Geometry>(), Variable::Tag::ACCEL, _next_variable_uid()};
+    _captured_accels.emplace_back(AccelBinding{v, handle});
+    return _ref(v);
+}
+
 const RefExpr *FunctionBuilder::texture_heap() noexcept {
     Variable v{Type::of<TextureHeap>(), Variable::Tag::TEXTURE_HEAP, _next_variable_uid()};
     _arguments.emplace_back(v);
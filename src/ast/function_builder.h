@@ -21,6 +21,7 @@ namespace luisa::compute {
 
 class Statement;
 class Expression;
+class FunctionSerializer;
 
 }// namespace luisa::compute
 
@@ -28,6 +29,8 @@ namespace luisa::compute::detail {
 
 class FunctionBuilder {
 
+    friend class luisa::compute::FunctionSerializer;
+
 private:
     class ScopeGuard {
 
@@ -47,18 +50,28 @@ public:
     using BufferBinding = Function::BufferBinding;
     using TextureBinding = Function::TextureBinding;
     using TextureHeapBinding = Function::TextureHeapBinding;
+    using AccelBinding = Function::AccelBinding;
+
+    // the statements break_() and continue_() may jump out of, innermost last
+    enum struct JumpTarget : uint8_t {
+        LOOP,
+        SWITCH,
+        UNROLLED_LOOP
+    };
 
 private:
     Arena *_arena;
     ScopeStmt _body;
     const Type *_ret{nullptr};
     ArenaVector<ScopeStmt *> _scope_stack;
+    ArenaVector<JumpTarget> _jump_targets;
     ArenaVector<Variable> _builtin_variables;
     ArenaVector<Variable> _shared_variables;
     ArenaVector<ConstantBinding> _captured_constants;
     ArenaVector<BufferBinding> _captured_buffers;
     ArenaVector<TextureBinding> _captured_textures;
     ArenaVector<TextureHeapBinding> _captured_heaps;
+    ArenaVector<AccelBinding> _captured_accels;
     ArenaVector<Variable> _arguments;
     ArenaVector<Function> _used_custom_callables;
     ArenaVector<CallOp> _used_builtin_callables;
@@ -68,6 +81,7 @@ private:
     uint3 _block_size;
     Tag _tag;
     bool _raytracing{false};
+    bool _block_size_used{false};
 
 protected:
     [[nodiscard]] static std::vector<FunctionBuilder *> &_function_stack() noexcept;
@@ -105,6 +119,7 @@ public:
     [[nodiscard]] auto captured_buffers() const noexcept { return std::span{_captured_buffers.data(), _captured_buffers.size()}; }
     [[nodiscard]] auto captured_textures() const noexcept { return std::span{_captured_textures.data(), _captured_textures.size()}; }
     [[nodiscard]] auto captured_texture_heaps() const noexcept { return std::span{_captured_heaps.data(), _captured_heaps.size()}; }
+    [[nodiscard]] auto captured_accels() const noexcept { return std::span{_captured_accels.data(), _captured_accels.size()}; }
     [[nodiscard]] auto arguments() const noexcept { return std::span{_arguments.data(), _arguments.size()}; }
     [[nodiscard]] auto custom_callables() const noexcept { return std::span{_used_custom_callables.data(), _used_custom_callables.size()}; }
     [[nodiscard]] auto builtin_callables() const noexcept { return std::span{_used_builtin_callables.data(), _used_builtin_callables.size()}; }
@@ -115,6 +130,7 @@ public:
     [[nodiscard]] auto block_size() const noexcept { return _block_size; }
     [[nodiscard]] auto hash() const noexcept { return _hash; }
     [[nodiscard]] auto raytracing() const noexcept { return _raytracing; }
+    [[nodiscard]] auto block_size_used() const noexcept { return _block_size_used; }
 
     // build primitives
     template<typename Def>
@@ -163,6 +179,7 @@ public:
     [[nodiscard]] const RefExpr *buffer_binding(const Type *element_type, uint64_t handle, size_t offset_bytes) noexcept;
     [[nodiscard]] const RefExpr *texture_binding(const Type *type, uint64_t handle) noexcept;
     [[nodiscard]] const RefExpr *texture_heap_binding(uint64_t handle) noexcept;
+    [[nodiscard]] const RefExpr *accel_binding(uint64_t handle) noexcept;
 
     // explicit arguments
     [[nodiscard]] const RefExpr *argument(const Type *type) noexcept;
@@ -208,8 +225,11 @@ public:
 
     void push_scope(ScopeStmt *) noexcept;
     void pop_scope(const ScopeStmt *) noexcept;
+    void push_jump_target(JumpTarget) noexcept;
+    void pop_jump_target(JumpTarget) noexcept;
     void mark_variable_usage(uint32_t uid, Usage usage) noexcept;
     void mark_raytracing() noexcept;
+    void mark_block_size_used() noexcept;
 
     [[nodiscard]] auto function() const noexcept { return Function{this}; }
 };
@@ -0,0 +1,784 @@
+//
+// Created by Mike Smith on 2021/7/2.
+//
+
+#include <unordered_map>
+
+#include <core/hash.h>
+#include <core/logging.h>
+#include <ast/function_builder.h>
+#include <ast/function_serializer.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+static constexpr auto serialized_invalid_id = ~0u;
+
+enum struct SerializedStmtTag : uint32_t {
+    BREAK,
+    CONTINUE,
+    RETURN,
+    SCOPE,
+    DECLARE,
+    IF,
+    WHILE,
+    EXPR,
+    SWITCH,
+    SWITCH_CASE,
+    SWITCH_DEFAULT,
+    ASSIGN,
+    FOR,
+    NONE = serialized_invalid_id
+};
+
+class SerializedWriter {
+
+private:
+    std::vector<std::byte> &_buffer;
+
+public:
+    explicit SerializedWriter(std::vector<std::byte> &buffer) noexcept : _buffer{buffer} {}
+
+    template<typename T>
+    void write(T x) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto offset = _buffer.size();
+        _buffer.resize(offset + sizeof(T));
+        std::memcpy(_buffer.data() + offset, &x, sizeof(T));
+    }
+
+    void write_bytes(const void *data, size_t size) noexcept {
+        write(static_cast<uint32_t>(size));
+        auto offset = _buffer.size();
+        _buffer.resize(offset + size);
+        std::memcpy(_buffer.data() + offset, data, size);
+    }
+
+    void append(std::span<const std::byte> bytes) noexcept {
+        _buffer.insert(_buffer.end(), bytes.begin(), bytes.end());
+    }
+};
+
+class SerializedReader {
+
+private:
+    std::span<const std::byte> _data;
+    size_t _offset{0u};
+
+    void _check(size_t size) const noexcept {
+        if (_offset + size > _data.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Unexpected end of serialized function "
+                "(offset = {}, requested = {}, size = {}).",
+                _offset, size, _data.size());
+        }
+    }
+
+public:
+    explicit SerializedReader(std::span<const std::byte> data) noexcept : _data{data} {}
+
+    template<typename T>
+    [[nodiscard]] T read() noexcept {
+        static_assert(std::is_trivially_copyable_v<T>);
+        _check(sizeof(T));
+        T x;
+        std::memcpy(&x, _data.data() + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return x;
+    }
+
+    [[nodiscard]] std::span<const std::byte> read_bytes() noexcept {
+        auto size = read<uint32_t>();
+        _check(size);
+        auto bytes = _data.subspan(_offset, size);
+        _offset += size;
+        return bytes;
+    }
+};
+
+// invokes f.template operator()<T>() with the basic type T that matches `type`
+template<typename F>
+void visit_basic_type(const Type *type, F &&f) noexcept {
+    auto found = [type, &f]<typename... T>(std::tuple<T...> *) noexcept {
+        return ((*type == *Type::of<T>() ? (f.template operator()<T>(), true) : false) || ...);
+    }(static_cast<basic_types *>(nullptr));
+    if (!found) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid basic type '{}' in serialized function.",
+            type->description());
+    }
+}
+
+class FunctionWriter;
+
+class ModuleWriter {
+
+private:
+    std::vector<const Type *> _types;
+    std::unordered_map<uint64_t, uint32_t> _type_ids;
+    std::vector<Function> _functions;
+    bool _strip_handles;
+
+    void _collect(Function f) noexcept {
+        if (std::find(_functions.cbegin(), _functions.cend(), f) != _functions.cend()) { return; }
+        for (auto c : f.custom_callables()) { _collect(c); }
+        _functions.emplace_back(f);
+    }
+
+public:
+    explicit ModuleWriter(bool strip_handles) noexcept : _strip_handles{strip_handles} {}
+    [[nodiscard]] auto strip_handles() const noexcept { return _strip_handles; }
+
+    [[nodiscard]] uint32_t type_id(const Type *type) noexcept {
+        if (type == nullptr) { return serialized_invalid_id; }
+        if (auto iter = _type_ids.find(type->hash()); iter != _type_ids.cend()) { return iter->second; }
+        auto id = static_cast<uint32_t>(_types.size());
+        _types.emplace_back(type);
+        _type_ids.emplace(type->hash(), id);
+        return id;
+    }
+
+    [[nodiscard]] uint32_t function_id(Function f) const noexcept {
+        auto iter = std::find(_functions.cbegin(), _functions.cend(), f);
+        if (iter == _functions.cend()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Custom callable is not serialized.");
+        }
+        return static_cast<uint32_t>(iter - _functions.cbegin());
+    }
+
+    [[nodiscard]] std::vector<std::byte> write(Function f) noexcept;
+};
+
+class FunctionWriter final : private ExprVisitor, private StmtVisitor {
+
+private:
+    ModuleWriter &_module;
+    Function _function;
+    std::vector<std::byte> _expression_buffer;
+    std::vector<std::byte> _body_buffer;
+    SerializedWriter _expression_writer{_expression_buffer};
+    SerializedWriter _body_writer{_body_buffer};
+    std::unordered_map<const Expression *, uint32_t> _expression_ids;
+    std::vector<Variable> _variables;
+
+private:
+    void _variable(Variable v) noexcept {
+        if (std::none_of(_variables.cbegin(), _variables.cend(), [v](auto u) noexcept {
+                return u.uid() == v.uid();
+            })) { _variables.emplace_back(v); }
+    }
+
+    [[nodiscard]] uint32_t _expression(const Expression *expr) noexcept {
+        if (expr == nullptr) { return serialized_invalid_id; }
+        if (auto iter = _expression_ids.find(expr); iter != _expression_ids.cend()) { return iter->second; }
+        expr->accept(*this);
+        auto id = static_cast<uint32_t>(_expression_ids.size());
+        _expression_ids.emplace(expr, id);
+        return id;
+    }
+
+    void _expression_header(const Expression *expr) noexcept {
+        _expression_writer.write(to_underlying(expr->tag()));
+        _expression_writer.write(_module.type_id(expr->type()));
+    }
+
+    void _statement(const Statement *stmt) noexcept {
+        if (stmt == nullptr) {
+            _body_writer.write(to_underlying(SerializedStmtTag::NONE));
+        } else {
+            stmt->accept(*this);
+        }
+    }
+
+    void visit(const UnaryExpr *expr) override {
+        auto operand = _expression(expr->operand());
+        _expression_header(expr);
+        _expression_writer.write(to_underlying(expr->op()));
+        _expression_writer.write(operand);
+    }
+
+    void visit(const BinaryExpr *expr) override {
+        auto lhs = _expression(expr->lhs());
+        auto rhs = _expression(expr->rhs());
+        _expression_header(expr);
+        _expression_writer.write(to_underlying(expr->op()));
+        _expression_writer.write(lhs);
+        _expression_writer.write(rhs);
+    }
+
+    void visit(const MemberExpr *expr) override {
+        auto self = _expression(expr->self());
+        _expression_header(expr);
+        _expression_writer.write(self);
+        if (expr->is_swizzle()) {
+            auto code = 0ull;
+            for (auto i = 0u; i < expr->swizzle_size(); i++) {
+                code |= static_cast<uint64_t>(expr->swizzle_index(i)) << (i * 4u);
+            }
+            _expression_writer.write(static_cast<uint32_t>(expr->swizzle_size()));
+            _expression_writer.write(code);
+        } else {
+            _expression_writer.write(0u);
+            _expression_writer.write(static_cast<uint64_t>(expr->member_index()));
+        }
+    }
+
+    void visit(const AccessExpr *expr) override {
+        auto range = _expression(expr->range());
+        auto index = _expression(expr->index());
+        _expression_header(expr);
+        _expression_writer.write(range);
+        _expression_writer.write(index);
+    }
+
+    void visit(const LiteralExpr *expr) override {
+        _expression_header(expr);
+        std::visit(
+            [this](auto v) noexcept {
+                _expression_writer.write(_module.type_id(Type::of<decltype(v)>()));
+                _expression_writer.write(v);
+            },
+            expr->value());
+    }
+
+    void visit(const RefExpr *expr) override {
+        _variable(expr->variable());
+        _expression_header(expr);
+        _expression_writer.write(expr->variable().uid());
+    }
+
+    void visit(const ConstantExpr *expr) override {
+        auto constants = _function.constants();
+        auto iter = std::find_if(constants.begin(), constants.end(), [expr](auto c) noexcept {
+            return c.data.hash() == expr->data().hash();
+        });
+        if (iter == constants.end()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Constant data is not captured by the function.");
+        }
+        _expression_header(expr);
+        _expression_writer.write(static_cast<uint32_t>(iter - constants.begin()));
+    }
+
+    void visit(const CallExpr *expr) override {
+        std::vector<uint32_t> args;
+        args.reserve(expr->arguments().size());
+        for (auto arg : expr->arguments()) { args.emplace_back(_expression(arg)); }
+        _expression_header(expr);
+        _expression_writer.write(to_underlying(expr->op()));
+        _expression_writer.write(expr->is_builtin() ? serialized_invalid_id : _module.function_id(expr->custom()));
+        _expression_writer.write(static_cast<uint32_t>(args.size()));
+        for (auto a : args) { _expression_writer.write(a); }
+    }
+
+    void visit(const CastExpr *expr) override {
+        auto source = _expression(expr->expression());
+        _expression_header(expr);
+        _expression_writer.write(to_underlying(expr->op()));
+        _expression_writer.write(source);
+    }
+
+    void visit(const BreakStmt *) override {
+        _body_writer.write(to_underlying(SerializedStmtTag::BREAK));
+    }
+
+    void visit(const ContinueStmt *) override {
+        _body_writer.write(to_underlying(SerializedStmtTag::CONTINUE));
+    }
+
+    void visit(const ReturnStmt *stmt) override {
+        auto expr = _expression(stmt->expression());
+        _body_writer.write(to_underlying(SerializedStmtTag::RETURN));
+        _body_writer.write(expr);
+    }
+
+    void visit(const ScopeStmt *stmt) override {
+        _body_writer.write(to_underlying(SerializedStmtTag::SCOPE));
+        _body_writer.write(static_cast<uint32_t>(stmt->statements().size()));
+        for (auto s : stmt->statements()) { _statement(s); }
+    }
+
+    void visit(const DeclareStmt *stmt) override {
+        _variable(stmt->variable());
+        std::vector<uint32_t> init;
+        init.reserve(stmt->initializer().size());
+        for (auto i : stmt->initializer()) { init.emplace_back(_expression(i)); }
+        _body_writer.write(to_underlying(SerializedStmtTag::DECLARE));
+        _body_writer.write(stmt->variable().uid());
+        _body_writer.write(static_cast<uint32_t>(init.size()));
+        for (auto i : init) { _body_writer.write(i); }
+    }
+
+    void visit(const IfStmt *stmt) override {
+        auto cond = _expression(stmt->condition());
+        _body_writer.write(to_underlying(SerializedStmtTag::IF));
+        _body_writer.write(cond);
+        _statement(stmt->true_branch());
+        _statement(stmt->false_branch());
+    }
+
+    void visit(const WhileStmt *stmt) override {
+        auto cond = _expression(stmt->condition());
+        _body_writer.write(to_underlying(SerializedStmtTag::WHILE));
+        _body_writer.write(cond);
+        _statement(stmt->body());
+    }
+
+    void visit(const ExprStmt *stmt) override {
+        auto expr = _expression(stmt->expression());
+        _body_writer.write(to_underlying(SerializedStmtTag::EXPR));
+        _body_writer.write(expr);
+    }
+
+    void visit(const SwitchStmt *stmt) override {
+        auto expr = _expression(stmt->expression());
+        _body_writer.write(to_underlying(SerializedStmtTag::SWITCH));
+        _body_writer.write(expr);
+        _statement(stmt->body());
+    }
+
+    void visit(const SwitchCaseStmt *stmt) override {
+        auto expr = _expression(stmt->expression());
+        _body_writer.write(to_underlying(SerializedStmtTag::SWITCH_CASE));
+        _body_writer.write(expr);
+        _statement(stmt->body());
+    }
+
+    void visit(const SwitchDefaultStmt *stmt) override {
+        _body_writer.write(to_underlying(SerializedStmtTag::SWITCH_DEFAULT));
+        _statement(stmt->body());
+    }
+
+    void visit(const AssignStmt *stmt) override {
+        auto lhs = _expression(stmt->lhs());
+        auto rhs = _expression(stmt->rhs());
+        _body_writer.write(to_underlying(SerializedStmtTag::ASSIGN));
+        _body_writer.write(to_underlying(stmt->op()));
+        _body_writer.write(lhs);
+        _body_writer.write(rhs);
+    }
+
+    void visit(const ForStmt *stmt) override {
+        auto cond = _expression(stmt->condition());
+        _body_writer.write(to_underlying(SerializedStmtTag::FOR));
+        _body_writer.write(cond);
+        _statement(stmt->initialization());
+        _statement(stmt->update());
+        _statement(stmt->body());
+    }
+
+public:
+    FunctionWriter(ModuleWriter &module, Function f) noexcept
+        : _module{module}, _function{f} {}
+
+    void write(SerializedWriter &writer) noexcept {
+        auto f = _function;
+        auto write_uids = [&writer, this](std::span<const Variable> variables) noexcept {
+            writer.write(static_cast<uint32_t>(variables.size()));
+            for (auto v : variables) {
+                _variable(v);
+                writer.write(v.uid());
+            }
+        };
+
+        // body first, so that all reachable variables and expressions are numbered
+        _statement(f.body());
+
+        writer.write(to_underlying(f.tag()));
+        writer.write(f.block_size());
+        writer.write(static_cast<uint32_t>(f.raytracing()));
+        writer.write(static_cast<uint32_t>(f.block_size_used()));
+        writer.write(_module.type_id(f.return_type()));
+
+        // bindings and signature
+        write_uids(f.builtin_variables());
+        write_uids(f.shared_variables());
+        write_uids(f.arguments());
+        writer.write(static_cast<uint32_t>(f.captured_buffers().size()));
+        for (auto b : f.captured_buffers()) {
+            _variable(b.variable);
+            writer.write(b.variable.uid());
+            writer.write(_module.strip_handles() ? 0ull : b.handle);
+            writer.write(_module.strip_handles() ? 0ull : static_cast<uint64_t>(b.offset_bytes));
+        }
+        writer.write(static_cast<uint32_t>(f.captured_textures().size()));
+        for (auto t : f.captured_textures()) {
+            _variable(t.variable);
+            writer.write(t.variable.uid());
+            writer.write(_module.strip_handles() ? 0ull : t.handle);
+        }
+        writer.write(static_cast<uint32_t>(f.captured_texture_heaps().size()));
+        for (auto h : f.captured_texture_heaps()) {
+            _variable(h.variable);
+            writer.write(h.variable.uid());
+            writer.write(_module.strip_handles() ? 0ull : h.handle);
+        }
+        writer.write(static_cast<uint32_t>(f.captured_accels().size()));
+        for (auto a : f.captured_accels()) {
+            _variable(a.variable);
+            writer.write(a.variable.uid());
+            writer.write(_module.strip_handles() ? 0ull : a.handle);
+        }
+        writer.write(static_cast<uint32_t>(f.constants().size()));
+        for (auto c : f.constants()) {
+            writer.write(_module.type_id(c.type));
+            std::visit(
+                [&writer](auto view) noexcept {
+                    writer.write_bytes(view.data(), view.size_bytes());
+                },
+                c.data.view());
+        }
+        writer.write(static_cast<uint32_t>(f.custom_callables().size()));
+        for (auto c : f.custom_callables()) { writer.write(_module.function_id(c)); }
+        writer.write(static_cast<uint32_t>(f.builtin_callables().size()));
+        for (auto op : f.builtin_callables()) { writer.write(to_underlying(op)); }
+
+        // variables, indexed by uid
+        std::sort(_variables.begin(), _variables.end(), [](auto lhs, auto rhs) noexcept {
+            return lhs.uid() < rhs.uid();
+        });
+        auto variable_count = _variables.empty() ? 0u : _variables.back().uid() + 1u;
+        writer.write(variable_count);
+        for (auto uid = 0u, i = 0u; uid < variable_count; uid++) {
+            if (_variables[i].uid() == uid) {
+                auto v = _variables[i++];
+                writer.write(to_underlying(v.tag()));
+                writer.write(_module.type_id(v.type()));
+            } else {// uid not referenced anywhere
+                writer.write(serialized_invalid_id);
+                writer.write(serialized_invalid_id);
+            }
+            writer.write(to_underlying(f.variable_usage(uid)));
+        }
+
+        // expressions (post-order) and body
+        writer.write(static_cast<uint32_t>(_expression_ids.size()));
+        writer.append(_expression_buffer);
+        writer.append(_body_buffer);
+    }
+};
+
+std::vector<std::byte> ModuleWriter::write(Function f) noexcept {
+    _collect(f);
+    std::vector<std::byte> function_buffer;
+    SerializedWriter function_writer{function_buffer};
+    for (auto func : _functions) {
+        FunctionWriter{*this, func}.write(function_writer);
+    }
+    std::vector<std::byte> buffer;
+    SerializedWriter writer{buffer};
+    writer.write(FunctionSerializer::magic);
+    writer.write(FunctionSerializer::version);
+    writer.write(static_cast<uint32_t>(_types.size()));
+    for (auto t : _types) {
+        auto desc = t->description();
+        writer.write_bytes(desc.data(), desc.size());
+    }
+    writer.write(static_cast<uint32_t>(_functions.size()));
+    writer.append(function_buffer);
+    return buffer;
+}
+
+}// namespace detail
+
+std::vector<std::byte> FunctionSerializer::serialize(Function function) noexcept {
+    return detail::ModuleWriter{false}.write(function);
+}
+
+uint64_t FunctionSerializer::hash(Function function) noexcept {
+    auto blob = detail::ModuleWriter{true}.write(function);
+    return xxh3_hash64(blob.data(), blob.size());
+}
+
+std::shared_ptr<const detail::FunctionBuilder> FunctionSerializer::deserialize(std::span<const std::byte> data) noexcept {
+
+    using namespace detail;
+    SerializedReader reader{data};
+    if (auto m = reader.read<uint32_t>(); m != magic) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Invalid serialized function magic 0x{:08x}.", m);
+    }
+    if (auto v = reader.read<uint32_t>(); v != version) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Unsupported serialized function version {} (expected {}).",
+            v, version);
+    }
+
+    std::vector<const Type *> types(reader.read<uint32_t>());
+    for (auto &&t : types) {
+        auto desc = reader.read_bytes();
+        t = Type::from(std::string_view{reinterpret_cast<const char *>(desc.data()), desc.size()});
+    }
+    auto type = [&types](uint32_t id) noexcept -> const Type * {
+        if (id == serialized_invalid_id) { return nullptr; }
+        if (id >= types.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid type id {} in serialized function.", id);
+        }
+        return types[id];
+    };
+
+    auto function_count = reader.read<uint32_t>();
+    if (function_count == 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("No function found in serialized data.");
+    }
+    auto arena = new Arena;
+    std::vector<FunctionBuilder *> functions;
+    functions.reserve(function_count);
+    for (auto fi = 0u; fi < function_count; fi++) {
+        auto tag = static_cast<Function::Tag>(reader.read<uint32_t>());
+        auto f = arena->create<FunctionBuilder>(arena, tag);
+        FunctionBuilder::push(f);
+        f->_block_size = reader.read<uint3>();
+        f->_raytracing = reader.read<uint32_t>() != 0u;
+        f->_block_size_used = reader.read<uint32_t>() != 0u;
+        f->_ret = type(reader.read<uint32_t>());
+
+        // signature and bindings refer to variables by uid, which are
+        // resolved after the variable table is read at the end of the header
+        auto read_uids = [&reader] {
+            std::vector<uint32_t> uids(reader.read<uint32_t>());
+            for (auto &&uid : uids) { uid = reader.read<uint32_t>(); }
+            return uids;
+        };
+        auto builtin_uids = read_uids();
+        auto shared_uids = read_uids();
+        auto argument_uids = read_uids();
+        struct HandleBinding {
+            uint32_t uid;
+            uint64_t handle;
+            uint64_t offset;
+        };
+        std::vector<HandleBinding> buffers(reader.read<uint32_t>());
+        for (auto &&b : buffers) { b = {reader.read<uint32_t>(), reader.read<uint64_t>(), reader.read<uint64_t>()}; }
+        std::vector<HandleBinding> textures(reader.read<uint32_t>());
+        for (auto &&t : textures) { t = {reader.read<uint32_t>(), reader.read<uint64_t>(), 0u}; }
+        std::vector<HandleBinding> heaps(reader.read<uint32_t>());
+        for (auto &&h : heaps) { h = {reader.read<uint32_t>(), reader.read<uint64_t>(), 0u}; }
+        std::vector<HandleBinding> accels(reader.read<uint32_t>());
+        for (auto &&a : accels) { a = {reader.read<uint32_t>(), reader.read<uint64_t>(), 0u}; }
+        auto constant_count = reader.read<uint32_t>();
+        for (auto i = 0u; i < constant_count; i++) {
+            auto t = type(reader.read<uint32_t>());
+            auto bytes = reader.read_bytes();
+            if (t == nullptr || !t->is_array()) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION("Invalid constant type in serialized function.");
+            }
+            visit_basic_type(t->element(), [f, t, bytes]<typename T>() noexcept {
+                auto n = bytes.size() / sizeof(T);
+                auto elements = std::make_unique<T[]>(n);// not std::vector, which is specialized for bool
+                std::memcpy(elements.get(), bytes.data(), n * sizeof(T));
+                f->_captured_constants.emplace_back(FunctionBuilder::ConstantBinding{
+                    t, ConstantData::create(std::span<const T>{elements.get(), n})});
+            });
+        }
+        auto callable_count = reader.read<uint32_t>();
+        for (auto i = 0u; i < callable_count; i++) {
+            auto id = reader.read<uint32_t>();
+            if (id >= functions.size()) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION("Invalid callable id {} in serialized function.", id);
+            }
+            f->_used_custom_callables.emplace_back(functions[id]->function());
+        }
+        auto builtin_count = reader.read<uint32_t>();
+        for (auto i = 0u; i < builtin_count; i++) {
+            f->_used_builtin_callables.emplace_back(static_cast<CallOp>(reader.read<uint32_t>()));
+        }
+
+        // variables
+        auto variable_count = reader.read<uint32_t>();
+        std::vector<Variable> variables;
+        std::vector<Usage> usages;
+        variables.reserve(variable_count);
+        usages.reserve(variable_count);
+        for (auto uid = 0u; uid < variable_count; uid++) {
+            auto variable_tag = static_cast<Variable::Tag>(reader.read<uint32_t>());
+            auto variable_type = type(reader.read<uint32_t>());
+            usages.emplace_back(static_cast<Usage>(reader.read<uint32_t>()));
+            variables.emplace_back(Variable{variable_type, variable_tag, f->_next_variable_uid()});
+        }
+        auto variable = [&variables](uint32_t uid) noexcept {
+            if (uid >= variables.size() || variables[uid].type() == nullptr) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION("Invalid variable uid {} in serialized function.", uid);
+            }
+            return variables[uid];
+        };
+        for (auto uid : builtin_uids) { f->_builtin_variables.emplace_back(variable(uid)); }
+        for (auto uid : shared_uids) { f->_shared_variables.emplace_back(variable(uid)); }
+        for (auto uid : argument_uids) { f->_arguments.emplace_back(variable(uid)); }
+        for (auto b : buffers) { f->_captured_buffers.emplace_back(FunctionBuilder::BufferBinding{variable(b.uid), b.handle, b.offset}); }
+        for (auto t : textures) { f->_captured_textures.emplace_back(FunctionBuilder::TextureBinding{variable(t.uid), t.handle}); }
+        for (auto h : heaps) { f->_captured_heaps.emplace_back(FunctionBuilder::TextureHeapBinding{variable(h.uid), h.handle}); }
+        for (auto a : accels) { f->_captured_accels.emplace_back(FunctionBuilder::AccelBinding{variable(a.uid), a.handle}); }
+
+        // expressions
+        std::vector<const Expression *> expressions(reader.read<uint32_t>());
+        auto expression = [&expressions](uint32_t id, size_t count) noexcept -> const Expression * {
+            if (id == serialized_invalid_id) { return nullptr; }
+            if (id >= count) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION("Invalid expression id {} in serialized function.", id);
+            }
+            return expressions[id];
+        };
+        for (auto i = 0u; i < expressions.size(); i++) {
+            auto expr_tag = static_cast<Expression::Tag>(reader.read<uint32_t>());
+            auto expr_type = type(reader.read<uint32_t>());
+            auto operand = [&reader, &expression, i] { return expression(reader.read<uint32_t>(), i); };
+            switch (expr_tag) {
+                case Expression::Tag::UNARY: {
+                    auto op = static_cast<UnaryOp>(reader.read<uint32_t>());
+                    expressions[i] = f->unary(expr_type, op, operand());
+                    break;
+                }
+                case Expression::Tag::BINARY: {
+                    auto op = static_cast<BinaryOp>(reader.read<uint32_t>());
+                    auto lhs = operand();
+                    auto rhs = operand();
+                    expressions[i] = f->binary(expr_type, op, lhs, rhs);
+                    break;
+                }
+                case Expression::Tag::MEMBER: {
+                    auto self = operand();
+                    auto swizzle_size = reader.read<uint32_t>();
+                    auto index_or_code = reader.read<uint64_t>();
+                    expressions[i] = swizzle_size == 0u
+                                         ? f->member(expr_type, self, index_or_code)
+                                         : f->swizzle(expr_type, self, swizzle_size, index_or_code);
+                    break;
+                }
+                case Expression::Tag::ACCESS: {
+                    auto range = operand();
+                    auto index = operand();
+                    expressions[i] = f->access(expr_type, range, index);
+                    break;
+                }
+                case Expression::Tag::LITERAL: {
+                    auto value_type = type(reader.read<uint32_t>());
+                    visit_basic_type(value_type, [&]<typename T>() noexcept {
+                        expressions[i] = f->literal(expr_type, reader.read<T>());
+                    });
+                    break;
+                }
+                case Expression::Tag::REF:
+                    expressions[i] = f->_ref(variable(reader.read<uint32_t>()));
+                    break;
+                case Expression::Tag::CONSTANT: {
+                    auto index = reader.read<uint32_t>();
+                    if (index >= f->_captured_constants.size()) [[unlikely]] {
+                        LUISA_ERROR_WITH_LOCATION("Invalid constant index {} in serialized function.", index);
+                    }
+                    auto c = f->_captured_constants[index];
+                    expressions[i] = arena->create<ConstantExpr>(c.type, c.data);
+                    break;
+                }
+                case Expression::Tag::CALL: {
+                    auto op = static_cast<CallOp>(reader.read<uint32_t>());
+                    auto callee = reader.read<uint32_t>();
+                    ArenaVector<const Expression *> args{*arena, reader.read<uint32_t>()};
+                    for (auto a = 0u; a < args.capacity(); a++) { args.emplace_back(operand()); }
+                    const CallExpr *call = nullptr;
+                    if (op == CallOp::CUSTOM) {
+                        if (callee >= functions.size()) [[unlikely]] {
+                            LUISA_ERROR_WITH_LOCATION("Invalid callable id {} in serialized function.", callee);
+                        }
+                        call = arena->create<CallExpr>(expr_type, functions[callee]->function(), args);
+                    } else {
+                        call = arena->create<CallExpr>(expr_type, op, args);
+                    }
+                    f->_call_expressions.emplace_back(call);
+                    expressions[i] = call;
+                    break;
+                }
+                case Expression::Tag::CAST: {
+                    auto op = static_cast<CastOp>(reader.read<uint32_t>());
+                    expressions[i] = f->cast(expr_type, op, operand());
+                    break;
+                }
+                default: LUISA_ERROR_WITH_LOCATION(
+                    "Invalid expression tag {} in serialized function.",
+                    to_underlying(expr_tag));
+            }
+        }
+
+        // statements
+        auto count = expressions.size();
+        auto read_statement = [&](auto &&self) noexcept -> const Statement * {
+            auto stmt_tag = static_cast<SerializedStmtTag>(reader.read<uint32_t>());
+            auto expr = [&] { return expression(reader.read<uint32_t>(), count); };
+            auto scope = [&] {
+                auto s = self(self);
+                if (s != nullptr && dynamic_cast<const ScopeStmt *>(s) == nullptr) [[unlikely]] {
+                    LUISA_ERROR_WITH_LOCATION("Expected scope statement in serialized function.");
+                }
+                return static_cast<const ScopeStmt *>(s);
+            };
+            switch (stmt_tag) {
+                case SerializedStmtTag::BREAK: return arena->create<BreakStmt>();
+                case SerializedStmtTag::CONTINUE: return arena->create<ContinueStmt>();
+                case SerializedStmtTag::RETURN: return arena->create<ReturnStmt>(expr());
+                case SerializedStmtTag::SCOPE: {
+                    auto s = f->scope();
+                    auto n = reader.read<uint32_t>();
+                    for (auto i = 0u; i < n; i++) { s->append(self(self)); }
+                    return s;
+                }
+                case SerializedStmtTag::DECLARE: {
+                    auto v = variable(reader.read<uint32_t>());
+                    ArenaVector<const Expression *> init{*arena, reader.read<uint32_t>()};
+                    for (auto i = 0u; i < init.capacity(); i++) { init.emplace_back(expr()); }
+                    return arena->create<DeclareStmt>(v, init);
+                }
+                case SerializedStmtTag::IF: {
+                    auto cond = expr();
+                    auto true_branch = scope();
+                    auto false_branch = scope();
+                    return arena->create<IfStmt>(cond, true_branch, false_branch);
+                }
+                case SerializedStmtTag::WHILE: {
+                    auto cond = expr();
+                    return arena->create<WhileStmt>(cond, scope());
+                }
+                case SerializedStmtTag::EXPR: return arena->create<ExprStmt>(expr());
+                case SerializedStmtTag::SWITCH: {
+                    auto e = expr();
+                    return arena->create<SwitchStmt>(e, scope());
+                }
+                case SerializedStmtTag::SWITCH_CASE: {
+                    auto e = expr();
+                    return arena->create<SwitchCaseStmt>(e, scope());
+                }
+                case SerializedStmtTag::SWITCH_DEFAULT: return arena->create<SwitchDefaultStmt>(scope());
+                case SerializedStmtTag::ASSIGN: {
+                    auto op = static_cast<AssignOp>(reader.read<uint32_t>());
+                    auto lhs = expr();
+                    auto rhs = expr();
+                    return arena->create<AssignStmt>(op, lhs, rhs);
+                }
+                case SerializedStmtTag::FOR: {
+                    auto cond = expr();
+                    auto init = self(self);
+                    auto update = self(self);
+                    return arena->create<ForStmt>(init, cond, update, scope());
+                }
+                case SerializedStmtTag::NONE: return nullptr;
+                default: break;
+            }
+            LUISA_ERROR_WITH_LOCATION(
+                "Invalid statement tag {} in serialized function.",
+                to_underlying(stmt_tag));
+        };
+        if (static_cast<SerializedStmtTag>(reader.read<uint32_t>()) != SerializedStmtTag::SCOPE) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid function body in serialized function.");
+        }
+        auto body_size = reader.read<uint32_t>();
+        for (auto i = 0u; i < body_size; i++) { f->_body.append(read_statement(read_statement)); }
+
+        // usages are re-derived while building, but restore the recorded ones to be exact
+        std::copy(usages.cbegin(), usages.cend(), f->_variable_usages.data());
+        f->_compute_hash();
+        FunctionBuilder::pop(f);
+        functions.emplace_back(f);
+    }
+    return std::shared_ptr<const FunctionBuilder>{
+        functions.back(), [arena](auto) noexcept { delete arena; }};
+}
+
+}// namespace luisa::compute
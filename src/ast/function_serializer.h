@@ -0,0 +1,40 @@
+//
+// Created by Mike Smith on 2021/7/2.
+//
+
+#pragma once
+
+#include <span>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include <ast/function.h>
+
+namespace luisa::compute {
+
+namespace detail {
+class FunctionBuilder;
+}
+
+// Binary (de)serialization of function ASTs. A blob holds a type table
+// (canonical type descriptions) followed by the serialized functions in
+// dependency order, with the serialized function itself as the last entry.
+// Within a function, variables keep their uids, expressions are numbered
+// in post-order and statements are stored as a tree, so the IDs are stable
+// across processes and independent of where the AST lived in memory.
+class FunctionSerializer {
+
+public:
+    static constexpr auto magic = 0x4e46434cu;// "LCFN"
+    static constexpr auto version = 4u;
+
+public:
+    [[nodiscard]] static std::vector<std::byte> serialize(Function function) noexcept;
+    [[nodiscard]] static std::shared_ptr<const detail::FunctionBuilder> deserialize(std::span<const std::byte> data) noexcept;
+    // structural hash that ignores the handles of captured resources, so that
+    // it is stable across processes, e.g. for looking up precompiled kernels
+    [[nodiscard]] static uint64_t hash(Function function) noexcept;
+};
+
+}// namespace luisa::compute
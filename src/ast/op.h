@@ -128,6 +128,18 @@ enum struct CallOp : uint32_t {
     DEVICE_MEMORY_BARRIER,
     ALL_MEMORY_BARRIER,
 
+    WARP_SIZE,
+    WARP_LANE_ID,
+    WARP_BALLOT,
+    WARP_ANY,
+    WARP_ALL,
+    WARP_BROADCAST,
+    WARP_SHUFFLE,
+    WARP_REDUCE_SUM,
+    WARP_REDUCE_MIN,
+    WARP_REDUCE_MAX,
+    WARP_PREFIX_SUM,
+
     ATOMIC_LOAD,
     ATOMIC_STORE,
     ATOMIC_EXCHANGE,
@@ -62,6 +62,11 @@ const Type *Type::from(std::string_view description) noexcept {
         TRY_PARSE_SCALAR_TYPE(float, FLOAT)
         TRY_PARSE_SCALAR_TYPE(int, INT)
         TRY_PARSE_SCALAR_TYPE(uint, UINT)
+        TRY_PARSE_SCALAR_TYPE(half, HALF)
+        TRY_PARSE_SCALAR_TYPE(short, SHORT)
+        TRY_PARSE_SCALAR_TYPE(ushort, USHORT)
+        TRY_PARSE_SCALAR_TYPE(byte, BYTE)
+        TRY_PARSE_SCALAR_TYPE(ubyte, UBYTE)
 #undef TRY_PARSE_SCALAR_TYPE
 
         if (type_identifier == "vector"sv) {
@@ -156,6 +161,10 @@ const Type *Type::from(std::string_view description) noexcept {
             info._tag = Tag::TEXTURE_HEAP;
             info._size = 8u;
             info._alignment = 8u;
+        } else if (type_identifier == "accel"sv) {
+            info._tag = Tag::ACCEL;
+            info._size = 8u;
+            info._alignment = 8u;
         }
         else [[unlikely]] {
             LUISA_ERROR_WITH_LOCATION("Unknown type identifier: {}.", type_identifier);
@@ -34,6 +34,11 @@ public:
         FLOAT,
         INT,
         UINT,
+        HALF,
+        SHORT,
+        USHORT,
+        BYTE,
+        UBYTE,
 
         VECTOR,
         MATRIX,
@@ -43,7 +48,8 @@ public:
         
         BUFFER,
         TEXTURE,
-        TEXTURE_HEAP
+        TEXTURE_HEAP,
+        ACCEL
     };
 
 private:
@@ -89,7 +95,12 @@ public:
         return _tag == Tag::BOOL
                || _tag == Tag::FLOAT
                || _tag == Tag::INT
-               || _tag == Tag::UINT;
+               || _tag == Tag::UINT
+               || _tag == Tag::HALF
+               || _tag == Tag::SHORT
+               || _tag == Tag::USHORT
+               || _tag == Tag::BYTE
+               || _tag == Tag::UBYTE;
     }
 
     [[nodiscard]] constexpr bool is_array() const noexcept { return _tag == Tag::ARRAY; }
@@ -99,6 +110,7 @@ public:
     [[nodiscard]] constexpr bool is_buffer() const noexcept { return _tag == Tag::BUFFER; }
     [[nodiscard]] constexpr bool is_texture() const noexcept { return _tag == Tag::TEXTURE; }
     [[nodiscard]] constexpr bool is_texture_heap() const noexcept { return _tag == Tag::TEXTURE_HEAP; }
+    [[nodiscard]] constexpr bool is_accel() const noexcept { return _tag == Tag::ACCEL; }
 };
 
 }// namespace luisa::compute
@@ -36,6 +36,7 @@ template<typename T>
 class VolumeView;
 
 class TextureHeap;
+class Geometry;
 
 class TypeRegistry {
 
@@ -93,6 +94,11 @@ LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(bool, BOOL)
 LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(float, FLOAT)
 LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(int, INT32)
 LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(uint, UINT32)
+LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(half, HALF)
+LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(short, SHORT)
+LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(ushort, USHORT)
+LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(byte, BYTE)
+LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION(ubyte, UBYTE)
 
 #undef LUISA_MAKE_SCALAR_AND_VECTOR_TYPE_DESC_SPECIALIZATION
 
@@ -156,6 +162,13 @@ struct TypeDesc<TextureHeap> {
     }
 };
 
+template<>
+struct TypeDesc<Geometry> {
+    static constexpr std::string_view description() noexcept {
+        return "accel";
+    }
+};
+
 template<typename T>
 struct TypeDesc<VolumeView<T>> : TypeDesc<Volume<T>> {};
 
@@ -13,6 +13,8 @@ namespace detail {
 class FunctionBuilder;
 }
 
+class FunctionSerializer;
+
 class Variable {
 
 public:
@@ -27,6 +29,7 @@ public:
         BUFFER,
         TEXTURE,
         TEXTURE_HEAP,
+        ACCEL,
         
         // TODO: Bindless Textures
 
@@ -44,6 +47,7 @@ private:
 
 private:
     friend class detail::FunctionBuilder;
+    friend class FunctionSerializer;
     constexpr Variable(const Type *type, Tag tag, uint32_t uid) noexcept
         : _type{type}, _uid{uid}, _tag{tag} {}
 
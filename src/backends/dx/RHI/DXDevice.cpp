@@ -212,35 +212,15 @@ public:
 			stream->GetQueue(),
 			cpuFence.Get());
 	}
-	uint64 create_mesh(
-		uint64 stream_handle,
-		uint64 vertex_buffer_handle,
-		size_t vertex_buffer_offset_bytes,
-		size_t vertex_count,
-		uint64 index_buffer_handle,
-		size_t index_buffer_offset_bytes,
-		size_t triangle_count) noexcept override {
-		/* return reinterpret_cast<uint64>(
-			new LCMesh(
-				reinterpret_cast<StructuredBuffer*>(vertex_buffer_handle),
-				reinterpret_cast<StructuredBuffer*>(index_buffer_handle),
-				vertex_buffer_offset_bytes,
-				index_buffer_offset_bytes,
-				vertex_count,
-				index_count));*/
+	uint64 create_mesh() noexcept override {
+		//return reinterpret_cast<uint64>(new LCMesh());
 		return 0;
 	}
 	void destroy_mesh(
 		uint64 mesh_handle) noexcept override {
 		//delete reinterpret_cast<LCMesh*>(mesh_handle);
 	}
-	uint64 create_accel(
-		uint64 stream_handle,
-		uint64 mesh_handle_buffer_handle,
-		size_t mesh_handle_buffer_offset_bytes,
-		uint64 transform_buffer_handle,
-		size_t transform_buffer_offset_bytes,
-		size_t mesh_count) noexcept override {
+	uint64 create_accel() noexcept override {
 		return 0;
 	}
 	void destroy_accel(uint64 handle) noexcept override {}
@@ -258,7 +238,7 @@ public:
 		});
 	}
 
-	uint64_t create_shader(Function kernel) noexcept override {
+	uint64_t create_shader(Function kernel, const CompileOptions &options) noexcept override {
 		return 0;
 	}
 	void destroy_shader(uint64_t handle) noexcept override {}
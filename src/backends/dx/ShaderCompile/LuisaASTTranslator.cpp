@@ -73,6 +73,12 @@ struct GetName {
 			return "int"_sv;
 		} else if constexpr (std::is_same_v<uint, T>) {
 			return "uint"_sv;
+		} else if constexpr (std::is_same_v<half, T>) {
+			return "float16_t"_sv;
+		} else if constexpr (std::is_same_v<short, T>) {
+			return "int16_t"_sv;
+		} else if constexpr (std::is_same_v<ushort, T>) {
+			return "uint16_t"_sv;
 		} else {
 			return "unknown"_sv;
 		}
@@ -103,6 +109,12 @@ struct PrintValue<float> {
 		vstd::to_string(v, str);
 	}
 };
+template<>
+struct PrintValue<half> {
+	void operator()(half const& v, vstd::string& str) {
+		vstd::to_string(static_cast<float>(v), str);
+	}
+};
 
 template<typename EleType, size_t N>
 struct PrintValue<Vector<EleType, N>> {
@@ -576,6 +588,15 @@ void CodegenUtility::GetTypeName(Type const& type, vstd::string& str, bool isWri
 		case Type::Tag::UINT:
 			str += "uint"_sv;
 			return;
+		case Type::Tag::HALF:
+			str += "float16_t"_sv;
+			return;
+		case Type::Tag::SHORT:
+			str += "int16_t"_sv;
+			return;
+		case Type::Tag::USHORT:
+			str += "uint16_t"_sv;
+			return;
 		case Type::Tag::MATRIX: {
 			auto dim = vstd::to_string(type.dimension());
 			CodegenUtility::GetTypeName(*type.element(), str, isWritable);
@@ -919,6 +940,39 @@ void CodegenUtility::GetFunctionName(CallExpr const* expr, vstd::string& result,
 		case CallOp::ALL_MEMORY_BARRIER:
 			result << "AllMemoryBarrierWithGroupSync"_sv;
 			break;
+		case CallOp::WARP_SIZE:
+			result << "WaveGetLaneCount"_sv;
+			break;
+		case CallOp::WARP_LANE_ID:
+			result << "WaveGetLaneIndex"_sv;
+			break;
+		case CallOp::WARP_BALLOT:
+			result << "WaveActiveBallot"_sv;
+			break;
+		case CallOp::WARP_ANY:
+			result << "WaveActiveAnyTrue"_sv;
+			break;
+		case CallOp::WARP_ALL:
+			result << "WaveActiveAllTrue"_sv;
+			break;
+		case CallOp::WARP_BROADCAST:
+			result << "WaveReadLaneAt"_sv;
+			break;
+		case CallOp::WARP_SHUFFLE:
+			result << "WaveReadLaneAt"_sv;
+			break;
+		case CallOp::WARP_REDUCE_SUM:
+			result << "WaveActiveSum"_sv;
+			break;
+		case CallOp::WARP_REDUCE_MIN:
+			result << "WaveActiveMin"_sv;
+			break;
+		case CallOp::WARP_REDUCE_MAX:
+			result << "WaveActiveMax"_sv;
+			break;
+		case CallOp::WARP_PREFIX_SUM:
+			result << "WavePrefixSum"_sv;
+			break;
 			///TODO: atomic operation
 		case CallOp::ATOMIC_LOAD:
 			//result << "_atomic_load"_sv;
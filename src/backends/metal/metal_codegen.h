@@ -5,6 +5,7 @@
 #pragma once
 
 #import <ast/interface.h>
+#import <ast/compile_options.h>
 #import <compile/codegen.h>
 
 namespace luisa::compute::metal {
@@ -13,6 +14,7 @@ class MetalCodegen : public Codegen, private TypeVisitor, private ExprVisitor, p
 
 private:
     Function _function;
+    CompileOptions _options;
     std::vector<Function> _generated_functions;
     std::vector<uint64_t> _generated_constants;
     uint32_t _indent{0u};
@@ -54,7 +56,8 @@ private:
     virtual void _emit_preamble() noexcept;
 
 public:
-    explicit MetalCodegen(Codegen::Scratch &scratch) noexcept : Codegen{scratch} {}
+    MetalCodegen(Codegen::Scratch &scratch, const CompileOptions &options) noexcept
+        : Codegen{scratch}, _options{options} {}
     void emit(Function f) override;
 };
 }// namespace luisa::compute::metal
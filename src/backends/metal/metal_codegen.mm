@@ -89,6 +89,15 @@ public:
     }
     void operator()(int v) const noexcept { _s << v; }
     void operator()(uint v) const noexcept { _s << v << "u"; }
+    void operator()(half v) const noexcept {
+        _s << "half(";
+        (*this)(static_cast<float>(v));
+        _s << ")";
+    }
+    void operator()(short v) const noexcept { _s << "short(" << static_cast<int>(v) << ")"; }
+    void operator()(ushort v) const noexcept { _s << "ushort(" << static_cast<uint>(v) << "u)"; }
+    void operator()(byte v) const noexcept { _s << "byte(" << static_cast<int>(v) << ")"; }
+    void operator()(ubyte v) const noexcept { _s << "ubyte(" << static_cast<uint>(v) << "u)"; }
 
     template<typename T, size_t N>
     void operator()(Vector<T, N> v) const noexcept {
@@ -161,6 +170,38 @@ void MetalCodegen::visit(const RefExpr *expr) {
 
 void MetalCodegen::visit(const CallExpr *expr) {
     auto is_atomic_op = false;
+    if (expr->op() == CallOp::WARP_SIZE || expr->op() == CallOp::WARP_LANE_ID) {
+        // simdgroup attributes are only visible to kernel functions
+        if (_function.tag() != Function::Tag::KERNEL) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Warp size and lane id are only available in kernels on Metal.");
+        }
+        _scratch << (expr->op() == CallOp::WARP_SIZE ? "simd_width" : "simd_lane");
+        return;
+    }
+    switch (expr->op()) {
+        case CallOp::ACOS:
+        case CallOp::ASIN:
+        case CallOp::ATAN:
+        case CallOp::ATAN2:
+        case CallOp::COS:
+        case CallOp::COSH:
+        case CallOp::SIN:
+        case CallOp::SINH:
+        case CallOp::TAN:
+        case CallOp::TANH:
+        case CallOp::EXP:
+        case CallOp::EXP2:
+        case CallOp::EXP10:
+        case CallOp::LOG:
+        case CallOp::LOG2:
+        case CallOp::LOG10:
+        case CallOp::POW:
+        case CallOp::SQRT:
+        case CallOp::RSQRT:
+            _scratch << (_options.approximate_transcendentals ? "fast::" : "precise::");
+            break;
+        default: break;
+    }
     switch (expr->op()) {
         case CallOp::CUSTOM: _scratch << "custom_" << hash_to_string(expr->custom().hash()); break;
         case CallOp::ALL: _scratch << "all"; break;
@@ -229,6 +270,17 @@ void MetalCodegen::visit(const CallExpr *expr) {
         case CallOp::GROUP_MEMORY_BARRIER: _scratch << "group_memory_barrier"; break;
         case CallOp::DEVICE_MEMORY_BARRIER: _scratch << "device_memory_barrier"; break;
         case CallOp::ALL_MEMORY_BARRIER: _scratch << "all_memory_barrier"; break;
+        case CallOp::WARP_SIZE: break;
+        case CallOp::WARP_LANE_ID: break;
+        case CallOp::WARP_BALLOT: _scratch << "warp_ballot"; break;
+        case CallOp::WARP_ANY: _scratch << "simd_any"; break;
+        case CallOp::WARP_ALL: _scratch << "simd_all"; break;
+        case CallOp::WARP_BROADCAST: _scratch << "simd_broadcast"; break;
+        case CallOp::WARP_SHUFFLE: _scratch << "simd_shuffle"; break;
+        case CallOp::WARP_REDUCE_SUM: _scratch << "simd_sum"; break;
+        case CallOp::WARP_REDUCE_MIN: _scratch << "simd_min"; break;
+        case CallOp::WARP_REDUCE_MAX: _scratch << "simd_max"; break;
+        case CallOp::WARP_PREFIX_SUM: _scratch << "simd_prefix_exclusive_sum"; break;
         case CallOp::ATOMIC_LOAD:
             _scratch << "atomic_load_explicit";
             is_atomic_op = true;
@@ -499,10 +551,11 @@ void MetalCodegen::_emit_function(Function f) noexcept {
         _scratch << "\n  const uint3 ls;\n};\n\n";
 
         // function signature
+        auto block_size = _options.block_size_of(f);
         _scratch << "[[kernel]] // block_size = ("
-                 << f.block_size().x << ", "
-                 << f.block_size().y << ", "
-                 << f.block_size().z << ")\n"
+                 << block_size.x << ", "
+                 << block_size.y << ", "
+                 << block_size.z << ")\n"
                  << "void kernel_" << hash_to_string(f.hash())
                  << "(\n    device const Argument &arg,";
         for (auto builtin : f.builtin_variables()) {
@@ -512,6 +565,8 @@ void MetalCodegen::_emit_function(Function f) noexcept {
                 _scratch << ",";
             }
         }
+        _scratch << "\n    const uint simd_lane [[thread_index_in_simdgroup]],"
+                 << "\n    const uint simd_width [[threads_per_simdgroup]],";
         _scratch.pop_back();
     } else if (f.tag() == Function::Tag::CALLABLE) {
         if (f.return_type() != nullptr) {
@@ -565,6 +620,7 @@ void MetalCodegen::_emit_variable_name(Variable v) noexcept {
         case Variable::Tag::BUFFER: _scratch << "b" << v.uid(); break;
         case Variable::Tag::TEXTURE: _scratch << "i" << v.uid(); break;
         case Variable::Tag::TEXTURE_HEAP: _scratch << "h" << v.uid(); break;
+        case Variable::Tag::ACCEL: _scratch << "a" << v.uid(); break;
         case Variable::Tag::THREAD_ID: _scratch << "tid"; break;
         case Variable::Tag::BLOCK_ID: _scratch << "bid"; break;
         case Variable::Tag::DISPATCH_ID: _scratch << "did"; break;
@@ -597,6 +653,11 @@ void MetalCodegen::_emit_type_name(const Type *type) noexcept {
         case Type::Tag::FLOAT: _scratch << "float"; break;
         case Type::Tag::INT: _scratch << "int"; break;
         case Type::Tag::UINT: _scratch << "uint"; break;
+        case Type::Tag::HALF: _scratch << "half"; break;
+        case Type::Tag::SHORT: _scratch << "short"; break;
+        case Type::Tag::USHORT: _scratch << "ushort"; break;
+        case Type::Tag::BYTE: _scratch << "byte"; break;
+        case Type::Tag::UBYTE: _scratch << "ubyte"; break;
         case Type::Tag::VECTOR:
             _emit_type_name(type->element());
             _scratch << type->dimension();
@@ -755,6 +816,12 @@ void MetalCodegen::visit(const ConstantExpr *expr) {
 
 void MetalCodegen::visit(const ForStmt *stmt) {
 
+    // the Metal compiler is clang-based, where "#pragma unroll n" forces the
+    // factor instead of bounding it, so only disabling unrolling is passed on
+    if (_options.max_unroll == 1u) {
+        _scratch << "#pragma unroll 1\n";
+        _emit_indent();
+    }
     _scratch << "for (";
 
     if (auto init = stmt->initialization(); init != nullptr) {
@@ -785,9 +852,23 @@ void MetalCodegen::_emit_preamble() noexcept {
 
 using namespace metal;
 
+using byte = char;
+using byte2 = char2;
+using byte3 = char3;
+using byte4 = char4;
+using ubyte = uchar;
+using ubyte2 = uchar2;
+using ubyte3 = uchar3;
+using ubyte4 = uchar4;
+
 template<typename T>
 [[nodiscard]] auto none(T v) { return !any(v); }
 
+[[nodiscard]] auto warp_ballot(bool p) {
+  auto mask = static_cast<simd_vote::vote_t>(simd_ballot(p));
+  return uint4(uint(mask), uint(mask >> 32u), 0u, 0u);
+}
+
 template<typename T, access a>
 [[nodiscard]] auto texture_read(texture2d<T, a> t, uint2 uv) {
   return t.read(uv);
@@ -951,6 +1032,100 @@ template<typename T>
   return cmp;
 }
 
+// float atomics are emulated with compare-and-swap loops on the bits, as
+// MSL 2.3 has no atomic_float; vectors are updated component by component
+template<typename A, int N>
+struct float_atomic_ref {
+  A a;
+};
+
+[[gnu::always_inline, nodiscard]] inline auto as_atomic(device float &a) {
+  return float_atomic_ref<device atomic_uint *, 1>{reinterpret_cast<device atomic_uint *>(&a)};
+}
+
+[[gnu::always_inline, nodiscard]] inline auto as_atomic(threadgroup float &a) {
+  return float_atomic_ref<threadgroup atomic_uint *, 1>{reinterpret_cast<threadgroup atomic_uint *>(&a)};
+}
+
+template<int N>
+[[gnu::always_inline, nodiscard]] inline auto as_atomic(device vec<float, N> &a) {
+  return float_atomic_ref<device atomic_uint *, N>{reinterpret_cast<device atomic_uint *>(&a)};
+}
+
+template<int N>
+[[gnu::always_inline, nodiscard]] inline auto as_atomic(threadgroup vec<float, N> &a) {
+  return float_atomic_ref<threadgroup atomic_uint *, N>{reinterpret_cast<threadgroup atomic_uint *>(&a)};
+}
+
+enum struct float_atomic_op { add, sub, min, max, exchange };
+
+template<float_atomic_op op, typename A>
+[[gnu::always_inline]] inline float float_atomic_update(float_atomic_ref<A, 1> r, float v) {
+  auto old = atomic_load_explicit(r.a, memory_order_relaxed);
+  for (;;) {
+    auto x = as_type<float>(old);
+    auto y = op == float_atomic_op::add ? x + v :
+             op == float_atomic_op::sub ? x - v :
+             op == float_atomic_op::min ? min(x, v) :
+             op == float_atomic_op::max ? max(x, v) : v;
+    if (atomic_compare_exchange_weak_explicit(r.a, &old, as_type<uint>(y), memory_order_relaxed, memory_order_relaxed)) {
+      return x;
+    }
+  }
+}
+
+template<float_atomic_op op, typename A, int N>
+[[gnu::always_inline]] inline auto float_atomic_update(float_atomic_ref<A, N> r, vec<float, N> v) {
+  vec<float, N> old;
+  for (auto i = 0; i < N; i++) {
+    old[i] = float_atomic_update<op>(float_atomic_ref<A, 1>{r.a + i}, v[i]);
+  }
+  return old;
+}
+
+template<typename A, int N, typename T>
+[[gnu::always_inline]] inline auto atomic_fetch_add_explicit(float_atomic_ref<A, N> r, T v, memory_order) {
+  return float_atomic_update<float_atomic_op::add>(r, v);
+}
+
+template<typename A, int N, typename T>
+[[gnu::always_inline]] inline auto atomic_fetch_sub_explicit(float_atomic_ref<A, N> r, T v, memory_order) {
+  return float_atomic_update<float_atomic_op::sub>(r, v);
+}
+
+template<typename A, int N, typename T>
+[[gnu::always_inline]] inline auto atomic_fetch_min_explicit(float_atomic_ref<A, N> r, T v, memory_order) {
+  return float_atomic_update<float_atomic_op::min>(r, v);
+}
+
+template<typename A, int N, typename T>
+[[gnu::always_inline]] inline auto atomic_fetch_max_explicit(float_atomic_ref<A, N> r, T v, memory_order) {
+  return float_atomic_update<float_atomic_op::max>(r, v);
+}
+
+template<typename A>
+[[gnu::always_inline]] inline auto atomic_exchange_explicit(float_atomic_ref<A, 1> r, float v, memory_order) {
+  return float_atomic_update<float_atomic_op::exchange>(r, v);
+}
+
+template<typename A>
+[[gnu::always_inline]] inline void atomic_store_explicit(float_atomic_ref<A, 1> r, float v, memory_order) {
+  atomic_store_explicit(r.a, as_type<uint>(v), memory_order_relaxed);
+}
+
+template<typename A>
+[[gnu::always_inline, nodiscard]] inline auto atomic_load_explicit(float_atomic_ref<A, 1> r, memory_order) {
+  return as_type<float>(atomic_load_explicit(r.a, memory_order_relaxed));
+}
+
+// compares the bits, as the integer versions do
+template<typename A>
+[[gnu::always_inline, nodiscard]] inline auto atomic_compare_exchange(float_atomic_ref<A, 1> r, float cmp, float val, memory_order) {
+  auto expected = as_type<uint>(cmp);
+  atomic_compare_exchange_weak_explicit(r.a, &expected, as_type<uint>(val), memory_order_relaxed, memory_order_relaxed);
+  return as_type<float>(expected);
+}
+
 template<typename X, typename Y>
 [[gnu::always_inline, nodiscard]] inline auto glsl_mod(X x, Y y) {
   return x - y * floor(x / y);
@@ -163,7 +163,7 @@ void MetalCommandEncoder::visit(const ShaderDispatchCommand *command) noexcept {
     auto argument_index = 0u;
 
     auto launch_size = command->dispatch_size();
-    auto block_size = command->kernel().block_size();
+    auto block_size = compiled_kernel.block_size();
     auto blocks = (launch_size + block_size - 1u) / block_size;
     LUISA_VERBOSE_WITH_LOCATION(
         "Dispatch shader #{} in ({}, {}, {}) blocks "
@@ -234,6 +234,10 @@ void MetalCommandEncoder::visit(const ShaderDispatchCommand *command) noexcept {
             [argument_encoder setBuffer:desc_buffer offset:0u atIndex:arg_id];
             [compute_encoder useResource:desc_buffer usage:MTLResourceUsageRead];
             [compute_encoder useHeap:heap->handle()];
+        } else if constexpr (std::is_same_v<T, ShaderDispatchCommand::AccelArgument>) {
+            LUISA_ERROR_WITH_LOCATION(
+                "Tracing accel #{} in kernels is not supported by the Metal backend yet.",
+                argument.handle);
         } else {// uniform
             auto ptr = [argument_encoder constantDataAtIndex:compiled_kernel.arguments()[argument_index++].argumentIndex];
             std::memcpy(ptr, argument.data(), argument.size_bytes());
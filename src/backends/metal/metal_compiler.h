@@ -12,6 +12,7 @@
 
 #import <core/hash.h>
 #import <core/spin_mutex.h>
+#import <ast/compile_options.h>
 #import <backends/metal/metal_shader.h>
 
 namespace luisa::compute::metal {
@@ -27,7 +28,7 @@ private:
 
 public:
     explicit MetalCompiler(MetalDevice *device) noexcept : _device{device} {}
-    [[nodiscard]] MetalShader compile(Function kernel) noexcept;
+    [[nodiscard]] MetalShader compile(Function kernel, const CompileOptions &options) noexcept;
 };
 
 }// namespace luisa::compute::metal
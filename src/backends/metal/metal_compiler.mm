@@ -10,7 +10,7 @@
 
 namespace luisa::compute::metal {
 
-MetalShader MetalCompiler::compile(Function kernel) noexcept {
+MetalShader MetalCompiler::compile(Function kernel, const CompileOptions &options) noexcept {
 
     auto hash_string = std::string{hash_to_string(kernel.hash())};
     LUISA_INFO("Compiling kernel #{}.", hash_string);
@@ -18,11 +18,12 @@ MetalShader MetalCompiler::compile(Function kernel) noexcept {
     Clock clock;
 
     Codegen::Scratch scratch;
-    MetalCodegen codegen{scratch};
+    MetalCodegen codegen{scratch, options};
     codegen.emit(kernel);
 
+    // the source does not reflect all the options, e.g. fast math
     auto s = scratch.view();
-    auto hash = xxh3_hash64(s.data(), s.size());
+    auto hash = options.hash(xxh3_hash64(s.data(), s.size()));
     LUISA_VERBOSE(
         "Generated source (hash = 0x{:016x}) for kernel #{} in {} ms:\n\n{}",
         hash, hash_string, clock.toc(), s);
@@ -42,13 +43,13 @@ MetalShader MetalCompiler::compile(Function kernel) noexcept {
                                         length:s.size()
                                       encoding:NSUTF8StringEncoding];
 
-    auto options = [[MTLCompileOptions alloc] init];
-    options.fastMathEnabled = true;
-    options.languageVersion = MTLLanguageVersion2_3;
-    options.libraryType = MTLLibraryTypeExecutable;
+    auto compile_options = [[MTLCompileOptions alloc] init];
+    compile_options.fastMathEnabled = options.fast_math;
+    compile_options.languageVersion = MTLLanguageVersion2_3;
+    compile_options.libraryType = MTLLibraryTypeExecutable;
 
     __autoreleasing NSError *error = nullptr;
-    auto library = [_device->handle() newLibraryWithSource:src options:options error:&error];
+    auto library = [_device->handle() newLibraryWithSource:src options:compile_options error:&error];
     if (error != nullptr) [[unlikely]] {
         auto error_msg = [error.description cStringUsingEncoding:NSUTF8StringEncoding];
         LUISA_WARNING("Output while compiling kernel #{}: {}", hash_string, error_msg);
@@ -67,7 +68,7 @@ MetalShader MetalCompiler::compile(Function kernel) noexcept {
             name, hash_string);
     }
 
-    auto block_size = kernel.block_size();
+    auto block_size = options.block_size_of(kernel);
     auto desc = [[MTLComputePipelineDescriptor alloc] init];
     desc.computeFunction = func;
     desc.threadGroupSizeIsMultipleOfThreadExecutionWidth = true;
@@ -89,7 +90,7 @@ MetalShader MetalCompiler::compile(Function kernel) noexcept {
 
     // TODO: LRU
     std::scoped_lock lock{_cache_mutex};
-    return _cache.try_emplace(hash, pso, encoder, members).first->second;
+    return _cache.try_emplace(hash, pso, encoder, members, block_size).first->second;
 }
 
 }
@@ -87,21 +87,16 @@ public:
     void destroy_stream(uint64_t handle) noexcept override;
     void dispatch(uint64_t stream_handle, CommandList buffer) noexcept override;
     void synchronize_stream(uint64_t stream_handle) noexcept override;
-    uint64_t create_shader(Function kernel) noexcept override;
+    uint64_t create_shader(Function kernel, const CompileOptions &options) noexcept override;
     void destroy_shader(uint64_t handle) noexcept override;
     uint64_t create_event() noexcept override;
     void signal_event(uint64_t handle, uint64_t stream_handle) noexcept override;
     void wait_event(uint64_t handle, uint64_t stream_handle) noexcept override;
     void destroy_event(uint64_t handle) noexcept override;
     void synchronize_event(uint64_t handle) noexcept override;
-    uint64_t create_mesh(uint64_t stream_handle,
-                         uint64_t vertex_buffer_handle, size_t vertex_buffer_offset_bytes, size_t vertex_count,
-                         uint64_t index_buffer_handle, size_t index_buffer_offset_bytes, size_t triangle_count) noexcept override;
+    uint64_t create_mesh() noexcept override;
     void destroy_mesh(uint64_t handle) noexcept override;
-    uint64_t create_accel(uint64_t stream_handle,
-                          uint64_t mesh_handle_buffer_handle, size_t mesh_handle_buffer_offset_bytes,
-                          uint64_t transform_buffer_handle, size_t transform_buffer_offset_bytes,
-                          size_t mesh_count) noexcept override;
+    uint64_t create_accel() noexcept override;
     void destroy_accel(uint64_t handle) noexcept override;
     uint64_t create_texture_heap(size_t size) noexcept override;
     size_t query_texture_heap_memory_usage(uint64_t handle) noexcept override;
@@ -15,15 +15,18 @@ private:
     id<MTLComputePipelineState> _handle{nullptr};
     id<MTLArgumentEncoder> _encoder{nullptr};
     NSArray<MTLStructMember *> *_arguments{nullptr};
+    uint3 _block_size{};
 
 public:
     MetalShader() noexcept = default;
     MetalShader(id<MTLComputePipelineState> pso,
                 id<MTLArgumentEncoder> encoder,
-                NSArray<MTLStructMember *> *arguments) noexcept
+                NSArray<MTLStructMember *> *arguments,
+                uint3 block_size) noexcept
         : _handle{pso},
           _encoder{encoder},
-          _arguments{arguments} {}
+          _arguments{arguments},
+          _block_size{block_size} {}
     ~MetalShader() noexcept {
         _handle = nullptr;
         _encoder = nullptr;
@@ -33,6 +36,7 @@ public:
     [[nodiscard]] auto handle() const noexcept { return _handle; }
     [[nodiscard]] auto encoder() const noexcept { return _encoder; }
     [[nodiscard]] auto arguments() const noexcept { return _arguments; }
+    [[nodiscard]] auto block_size() const noexcept { return _block_size; }
 };
 
 }// namespace luisa::compute::metal
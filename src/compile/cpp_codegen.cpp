@@ -89,6 +89,15 @@ public:
     }
     void operator()(int v) const noexcept { _s << v; }
     void operator()(uint v) const noexcept { _s << v << "u"; }
+    void operator()(half v) const noexcept {
+        _s << "half(";
+        (*this)(static_cast<float>(v));
+        _s << ")";
+    }
+    void operator()(short v) const noexcept { _s << "short(" << static_cast<int>(v) << ")"; }
+    void operator()(ushort v) const noexcept { _s << "ushort(" << static_cast<uint>(v) << "u)"; }
+    void operator()(byte v) const noexcept { _s << "byte(" << static_cast<int>(v) << ")"; }
+    void operator()(ubyte v) const noexcept { _s << "ubyte(" << static_cast<uint>(v) << "u)"; }
 
     template<typename T, size_t N>
     void operator()(Vector<T, N> v) const noexcept {
@@ -220,6 +229,17 @@ void CppCodegen::visit(const CallExpr *expr) {
         case CallOp::GROUP_MEMORY_BARRIER: _scratch << "group_memory_barrier"; break;
         case CallOp::DEVICE_MEMORY_BARRIER: _scratch << "device_memory_barrier"; break;
         case CallOp::ALL_MEMORY_BARRIER: _scratch << "all_memory_barrier"; break;
+        case CallOp::WARP_SIZE: _scratch << "warp_size"; break;
+        case CallOp::WARP_LANE_ID: _scratch << "warp_lane_id"; break;
+        case CallOp::WARP_BALLOT: _scratch << "warp_ballot"; break;
+        case CallOp::WARP_ANY: _scratch << "warp_any"; break;
+        case CallOp::WARP_ALL: _scratch << "warp_all"; break;
+        case CallOp::WARP_BROADCAST: _scratch << "warp_broadcast"; break;
+        case CallOp::WARP_SHUFFLE: _scratch << "warp_shuffle"; break;
+        case CallOp::WARP_REDUCE_SUM: _scratch << "warp_reduce_sum"; break;
+        case CallOp::WARP_REDUCE_MIN: _scratch << "warp_reduce_min"; break;
+        case CallOp::WARP_REDUCE_MAX: _scratch << "warp_reduce_max"; break;
+        case CallOp::WARP_PREFIX_SUM: _scratch << "warp_prefix_sum"; break;
         case CallOp::ATOMIC_LOAD: _scratch << "atomic_load"; break;
         case CallOp::ATOMIC_STORE: _scratch << "atomic_store"; break;
         case CallOp::ATOMIC_EXCHANGE: _scratch << "atomic_exchange"; break;
@@ -259,8 +279,8 @@ void CppCodegen::visit(const CallExpr *expr) {
         case CallOp::MAKE_FLOAT2X2: _scratch << "float2x2"; break;
         case CallOp::MAKE_FLOAT3X3: _scratch << "float3x3"; break;
         case CallOp::MAKE_FLOAT4X4: _scratch << "float4x4"; break;
-        case CallOp::TRACE_CLOSEST: break;
-        case CallOp::TRACE_ANY: break;
+        case CallOp::TRACE_CLOSEST: _scratch << "trace_closest"; break;
+        case CallOp::TRACE_ANY: _scratch << "trace_any"; break;
     }
     _scratch << "(";
     if (!expr->arguments().empty()) {
@@ -460,6 +480,11 @@ void CppCodegen::_emit_function(Function f) noexcept {
         _emit_access_attribute(buffer.variable);
         _scratch << ",";
     }
+    for (auto accel : f.captured_accels()) {
+        _scratch << "\n    ";
+        _emit_variable_decl(accel.variable);
+        _scratch << ",";
+    }
     for (auto builtin : f.builtin_variables()) {
         _scratch << "\n    ";
         _emit_variable_decl(builtin);
@@ -475,6 +500,7 @@ void CppCodegen::_emit_function(Function f) noexcept {
     if (!f.arguments().empty()
         || !f.captured_textures().empty()
         || !f.captured_buffers().empty()
+        || !f.captured_accels().empty()
         || !f.builtin_variables().empty()) {
         _scratch.pop_back();
     }
@@ -499,6 +525,7 @@ void CppCodegen::_emit_variable_name(Variable v) noexcept {
         case Variable::Tag::UNIFORM: _scratch << "u" << v.uid(); break;
         case Variable::Tag::BUFFER: _scratch << "b" << v.uid(); break;
         case Variable::Tag::TEXTURE: _scratch << "i" << v.uid(); break;
+        case Variable::Tag::ACCEL: _scratch << "a" << v.uid(); break;
         case Variable::Tag::THREAD_ID: _scratch << "tid"; break;
         case Variable::Tag::BLOCK_ID: _scratch << "bid"; break;
         case Variable::Tag::DISPATCH_ID: _scratch << "did"; break;
@@ -532,6 +559,11 @@ void CppCodegen::_emit_type_name(const Type *type) noexcept {
         case Type::Tag::FLOAT: _scratch << "float"; break;
         case Type::Tag::INT: _scratch << "int"; break;
         case Type::Tag::UINT: _scratch << "uint"; break;
+        case Type::Tag::HALF: _scratch << "half"; break;
+        case Type::Tag::SHORT: _scratch << "short"; break;
+        case Type::Tag::USHORT: _scratch << "ushort"; break;
+        case Type::Tag::BYTE: _scratch << "byte"; break;
+        case Type::Tag::UBYTE: _scratch << "ubyte"; break;
         case Type::Tag::VECTOR:
             _emit_type_name(type->element());
             _scratch << type->dimension();
@@ -580,6 +612,9 @@ void CppCodegen::_emit_variable_decl(Variable v) noexcept {
             _scratch << "texture_heap ";
             _emit_variable_name(v);
             break;
+        case Variable::Tag::ACCEL:
+            _scratch << "accel ";
+            break;
         case Variable::Tag::UNIFORM:
         case Variable::Tag::THREAD_ID:
         case Variable::Tag::BLOCK_ID:
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <cstddef>
 #include <tuple>
@@ -37,11 +38,68 @@ inline namespace size_literals {
 
 // scalars
 using uint = unsigned int;
+using ushort = unsigned short;
+using byte = int8_t;
+using ubyte = uint8_t;
+
+// IEEE 754 binary16, a storage type: arithmetic goes through float, just
+// as short and byte arithmetic goes through int. Conversions from float
+// round to nearest even (Giesen's float_to_half_fast3_rtne).
+class half {
+
+private:
+    uint16_t _bits{};
+
+    [[nodiscard]] static constexpr uint16_t _encode(float f) noexcept {
+        auto x = std::bit_cast<uint32_t>(f);
+        auto sign = x & 0x80000000u;
+        x ^= sign;
+        auto bits = 0u;
+        if (x >= 0x47800000u) {// overflows to inf, or nan
+            bits = x > 0x7f800000u ? 0x7e00u : 0x7c00u;
+        } else if (x < 0x38800000u) {// subnormal or zero, rounded by the fp adder
+            auto denorm_magic = std::bit_cast<float>(0x3f000000u);
+            bits = std::bit_cast<uint32_t>(std::bit_cast<float>(x) + denorm_magic) - 0x3f000000u;
+        } else {
+            auto mantissa_odd = (x >> 13u) & 1u;
+            x += 0xc8000fffu;// rebias the exponent and round half up...
+            x += mantissa_odd;// ...or to even
+            bits = x >> 13u;
+        }
+        return static_cast<uint16_t>(bits | (sign >> 16u));
+    }
+
+public:
+    constexpr half() noexcept = default;
+    constexpr half(float f) noexcept : _bits{_encode(f)} {}
+    [[nodiscard]] static constexpr auto from_bits(uint16_t bits) noexcept {
+        half h;
+        h._bits = bits;
+        return h;
+    }
+    [[nodiscard]] constexpr auto bits() const noexcept { return _bits; }
+    [[nodiscard]] constexpr operator float() const noexcept {
+        auto sign = static_cast<uint32_t>(_bits & 0x8000u) << 16u;
+        auto x = static_cast<uint32_t>(_bits & 0x7fffu) << 13u;
+        auto exponent = x & 0x0f800000u;
+        x += 0x38000000u;// rebias the exponent
+        if (exponent == 0x0f800000u) {// inf or nan
+            x += 0x38000000u;
+        } else if (exponent == 0u) {// subnormal or zero, renormalized by the fp adder
+            x = std::bit_cast<uint32_t>(std::bit_cast<float>(x + 0x00800000u) - std::bit_cast<float>(0x38800000u));
+        }
+        return std::bit_cast<float>(x | sign);
+    }
+};
 
 template<typename T>
 using is_integral = std::disjunction<
     std::is_same<T, int>,
-    std::is_same<T, uint>>;
+    std::is_same<T, uint>,
+    std::is_same<T, short>,
+    std::is_same<T, ushort>,
+    std::is_same<T, byte>,
+    std::is_same<T, ubyte>>;
 
 template<typename T>
 constexpr auto is_integral_v = is_integral<T>::value;
@@ -53,7 +111,9 @@ template<typename T>
 constexpr auto is_boolean_v = is_boolean<T>::value;
 
 template<typename T>
-using is_floating_point = std::is_same<T, float>;
+using is_floating_point = std::disjunction<
+    std::is_same<T, float>,
+    std::is_same<T, half>>;
 
 template<typename T>
 constexpr auto is_floating_point_v = is_floating_point<T>::value;
@@ -130,11 +190,7 @@ struct Vector : public detail::VectorStorage<T, N> {
     using value_type = T;
 
     using Storage = detail::VectorStorage<T, N>;
-    static_assert(std::disjunction_v<
-                      std::is_same<T, bool>,
-                      std::is_same<T, float>,
-                      std::is_same<T, int>,
-                      std::is_same<T, uint>> && (N == 2 || N == 3 || N == 4),
+    static_assert(is_scalar_v<T> && (N == 2 || N == 3 || N == 4),
                   "Invalid vector type");
 
     using Storage::VectorStorage;
@@ -266,6 +322,11 @@ LUISA_MAKE_VECTOR_TYPES(bool)
 LUISA_MAKE_VECTOR_TYPES(float)
 LUISA_MAKE_VECTOR_TYPES(int)
 LUISA_MAKE_VECTOR_TYPES(uint)
+LUISA_MAKE_VECTOR_TYPES(half)
+LUISA_MAKE_VECTOR_TYPES(short)
+LUISA_MAKE_VECTOR_TYPES(ushort)
+LUISA_MAKE_VECTOR_TYPES(byte)
+LUISA_MAKE_VECTOR_TYPES(ubyte)
 
 #undef LUISA_MAKE_VECTOR_TYPES
 
@@ -331,7 +392,11 @@ using basic_types = std::tuple<
     bool2, float2, int2, uint2,
     bool3, float3, int3, uint3,
     bool4, float4, int4, uint4,
-    float2x2, float3x3, float4x4>;
+    float2x2, float3x3, float4x4,
+    half, short, ushort, byte, ubyte,
+    half2, short2, ushort2, byte2, ubyte2,
+    half3, short3, ushort3, byte3, ubyte3,
+    half4, short4, ushort4, byte4, ubyte4>;
 
 [[nodiscard]] constexpr auto any(const bool2 v) noexcept { return v.x || v.y; }
 [[nodiscard]] constexpr auto any(const bool3 v) noexcept { return v.x || v.y || v.z; }
@@ -354,11 +419,11 @@ template<typename T, size_t N, std::enable_if_t<std::negation_v<luisa::is_boolea
 [[nodiscard]] constexpr auto operator-(const luisa::Vector<T, N> v) noexcept {
     using R = luisa::Vector<T, N>;
     if constexpr (N == 2) {
-        return R{-v.x, -v.y};
+        return R{static_cast<T>(-v.x), static_cast<T>(-v.y)};
     } else if constexpr (N == 3) {
-        return R{-v.x, -v.y, -v.z};
+        return R{static_cast<T>(-v.x), static_cast<T>(-v.y), static_cast<T>(-v.z)};
     } else {
-        return R{-v.x, -v.y, -v.z, -v.w};
+        return R{static_cast<T>(-v.x), static_cast<T>(-v.y), static_cast<T>(-v.z), static_cast<T>(-v.w)};
     }
 }
 
@@ -378,11 +443,11 @@ template<typename T, size_t N,
 [[nodiscard]] constexpr auto operator~(const luisa::Vector<T, N> v) noexcept {
     using R = luisa::Vector<T, N>;
     if constexpr (N == 2) {
-        return R{~v.x, ~v.y};
+        return R{static_cast<T>(~v.x), static_cast<T>(~v.y)};
     } else if constexpr (N == 3) {
-        return R{~v.x, ~v.y, ~v.z};
+        return R{static_cast<T>(~v.x), static_cast<T>(~v.y), static_cast<T>(~v.z)};
     } else {
-        return R{~v.x, ~v.y, ~v.z, ~v.w};
+        return R{static_cast<T>(~v.x), static_cast<T>(~v.y), static_cast<T>(~v.z), static_cast<T>(~v.w)};
     }
 }
 
@@ -577,6 +642,11 @@ LUISA_MAKE_TYPE_N(bool)
 LUISA_MAKE_TYPE_N(float)
 LUISA_MAKE_TYPE_N(int)
 LUISA_MAKE_TYPE_N(uint)
+LUISA_MAKE_TYPE_N(half)
+LUISA_MAKE_TYPE_N(short)
+LUISA_MAKE_TYPE_N(ushort)
+LUISA_MAKE_TYPE_N(byte)
+LUISA_MAKE_TYPE_N(ubyte)
 #undef LUISA_MAKE_TYPE_N
 
 // make float2x2
@@ -687,6 +757,47 @@ LUISA_MAKE_TYPE_N(uint)
     return m;
 }
 
+// Storage-only types, laid out without padding in buffers and host arrays.
+// Kernels load and store them as the compute types (see dsl/storage.h).
+
+#define LUISA_MAKE_PACKED_VECTOR3(type)                                        \
+    struct packed_##type##3 {                                                  \
+        type x;                                                                \
+        type y;                                                                \
+        type z;                                                                \
+    };                                                                         \
+    static_assert(sizeof(packed_##type##3) == 3u * sizeof(type));              \
+    [[nodiscard]] constexpr auto make_packed_##type##3(type##3 v) noexcept {   \
+        return packed_##type##3{v.x, v.y, v.z};                                \
+    }                                                                          \
+    [[nodiscard]] constexpr auto make_##type##3(packed_##type##3 v) noexcept { \
+        return type##3{v.x, v.y, v.z};                                         \
+    }
+
+LUISA_MAKE_PACKED_VECTOR3(float)
+LUISA_MAKE_PACKED_VECTOR3(int)
+LUISA_MAKE_PACKED_VECTOR3(uint)
+
+#undef LUISA_MAKE_PACKED_VECTOR3
+
+// affine transform as the first 3 rows of a float4x4, whose last row is (0, 0, 0, 1)
+struct float3x4 {
+    float4 rows[3];
+};
+
+[[nodiscard]] constexpr auto make_float3x4(float4x4 m) noexcept {
+    return float3x4{float4{m[0].x, m[1].x, m[2].x, m[3].x},
+                    float4{m[0].y, m[1].y, m[2].y, m[3].y},
+                    float4{m[0].z, m[1].z, m[2].z, m[3].z}};
+}
+
+[[nodiscard]] constexpr auto make_float4x4(float3x4 m) noexcept {
+    return float4x4{float4{m.rows[0].x, m.rows[1].x, m.rows[2].x, 0.0f},
+                    float4{m.rows[0].y, m.rows[1].y, m.rows[2].y, 0.0f},
+                    float4{m.rows[0].z, m.rows[1].z, m.rows[2].z, 0.0f},
+                    float4{m.rows[0].w, m.rows[1].w, m.rows[2].w, 1.0f}};
+}
+
 }// namespace luisa
 
 //template<size_t N>
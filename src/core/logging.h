@@ -43,14 +43,40 @@ void log_level_error() noexcept;
 
 }// namespace luisa
 
+// Compile-time log threshold: messages below LUISA_LOG_COMPILE_LEVEL are removed
+// by the preprocessor (arguments are not evaluated) instead of being filtered by
+// spdlog at runtime. Override with e.g. -DLUISA_LOG_COMPILE_LEVEL=LUISA_LOG_LEVEL_WARNING.
+#define LUISA_LOG_LEVEL_VERBOSE 0
+#define LUISA_LOG_LEVEL_INFO 1
+#define LUISA_LOG_LEVEL_WARNING 2
+#define LUISA_LOG_LEVEL_ERROR 3
+
+#ifndef LUISA_LOG_COMPILE_LEVEL
 #ifndef NDEBUG
+#define LUISA_LOG_COMPILE_LEVEL LUISA_LOG_LEVEL_VERBOSE
+#else
+#define LUISA_LOG_COMPILE_LEVEL LUISA_LOG_LEVEL_INFO
+#endif
+#endif
+
+#if LUISA_LOG_COMPILE_LEVEL <= LUISA_LOG_LEVEL_VERBOSE
 #define LUISA_VERBOSE(fmt, ...) ::luisa::log_verbose(FMT_STRING(std::string_view{fmt}), ##__VA_ARGS__)
 #else
 #define LUISA_VERBOSE(...)
 #endif
 
+#if LUISA_LOG_COMPILE_LEVEL <= LUISA_LOG_LEVEL_INFO
 #define LUISA_INFO(fmt, ...) ::luisa::log_info(FMT_STRING(std::string_view{fmt}) __VA_OPT__(, ) __VA_ARGS__)
+#else
+#define LUISA_INFO(...)
+#endif
+
+#if LUISA_LOG_COMPILE_LEVEL <= LUISA_LOG_LEVEL_WARNING
 #define LUISA_WARNING(fmt, ...) ::luisa::log_warning(FMT_STRING(std::string_view{fmt}), ##__VA_ARGS__)
+#else
+#define LUISA_WARNING(...)
+#endif
+
 #define LUISA_ERROR(fmt, ...) ::luisa::log_error(FMT_STRING(std::string_view{fmt}), ##__VA_ARGS__)
 
 #define LUISA_VERBOSE_WITH_LOCATION(fmt, ...) \
@@ -58,6 +58,43 @@ size_t pagesize() noexcept {
     return page_size;
 }
 
+std::span<const std::byte> memory_map_file(const std::filesystem::path &path) noexcept {
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to open file '{}' for mapping, reason: {}.",
+            path.string(), detail::win32_last_error_message());
+        return {};
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) [[unlikely]] {
+        CloseHandle(file);
+        return {};
+    }
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to map file '{}', reason: {}.",
+            path.string(), detail::win32_last_error_message());
+        return {};
+    }
+    auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);// the view keeps the mapping alive
+    if (data == nullptr) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to map file '{}', reason: {}.",
+            path.string(), detail::win32_last_error_message());
+        return {};
+    }
+    return {static_cast<const std::byte *>(data), static_cast<size_t>(size.QuadPart)};
+}
+
+void memory_unmap_file(std::span<const std::byte> mapping) noexcept {
+    if (!mapping.empty()) { UnmapViewOfFile(mapping.data()); }
+}
+
 void *dynamic_module_load(const std::filesystem::path &path) noexcept {
     if (!std::filesystem::exists(path)) [[unlikely]] {
         LUISA_ERROR_WITH_LOCATION("Dynamic module not found: {}.", path.string());
@@ -146,7 +183,12 @@ std::vector<TraceItem> backtrace() noexcept {
 
 #elif defined(LUISA_PLATFORM_UNIX)
 
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <dlfcn.h>
 #include <execinfo.h>
 #include <cxxabi.h>
@@ -161,6 +203,37 @@ size_t pagesize() noexcept {
     return page_size;
 }
 
+std::span<const std::byte> memory_map_file(const std::filesystem::path &path) noexcept {
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to open file '{}' for mapping, reason: {}.",
+            path.string(), strerror(errno));
+        return {};
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) [[unlikely]] {
+        close(fd);
+        return {};
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);// the mapping keeps the file alive
+    if (data == MAP_FAILED) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to map file '{}', reason: {}.",
+            path.string(), strerror(errno));
+        return {};
+    }
+    return {static_cast<const std::byte *>(data), size};
+}
+
+void memory_unmap_file(std::span<const std::byte> mapping) noexcept {
+    if (!mapping.empty()) {
+        munmap(const_cast<std::byte *>(mapping.data()), mapping.size());
+    }
+}
+
 void *dynamic_module_load(const std::filesystem::path &path) noexcept {
     if (!std::filesystem::exists(path)) [[unlikely]] {
         LUISA_ERROR_WITH_LOCATION("Dynamic module not found: {}.", path.string());
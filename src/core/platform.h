@@ -20,8 +20,10 @@
 #define LUISA_PLATFORM_UNIX
 #endif
 
+#include <span>
 #include <string>
 #include <vector>
+#include <cstddef>
 #include <string_view>
 #include <filesystem>
 
@@ -31,6 +33,10 @@ namespace luisa {
 void aligned_free(void *p) noexcept;
 [[nodiscard]] size_t pagesize() noexcept;
 
+// read-only file mapping; returns an empty span on failure
+[[nodiscard]] std::span<const std::byte> memory_map_file(const std::filesystem::path &path) noexcept;
+void memory_unmap_file(std::span<const std::byte> mapping) noexcept;
+
 [[nodiscard]] std::string_view dynamic_module_prefix() noexcept;
 [[nodiscard]] std::string_view dynamic_module_extension() noexcept;
 [[nodiscard]] void *dynamic_module_load(const std::filesystem::path &path) noexcept;
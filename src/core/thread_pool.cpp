@@ -0,0 +1,64 @@
+//
+// Created by Mike Smith on 2021/7/6.
+//
+
+#include <core/logging.h>
+#include <core/thread_pool.h>
+
+namespace luisa {
+
+ThreadPool::ThreadPool(size_t num_threads) noexcept {
+    _threads.reserve(num_threads);
+    for (auto i = 0u; i < num_threads; i++) {
+        _threads.emplace_back([this] {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock{_mutex};
+                    _cv.wait(lock, [this] { return _should_stop || !_tasks.empty(); });
+                    if (_tasks.empty()) { break; }// stopping
+                    task = std::move(_tasks.front());
+                    _tasks.pop_front();
+                }
+                task();
+            }
+        });
+    }
+    LUISA_INFO("Created thread pool with {} worker(s).", num_threads);
+}
+
+ThreadPool::~ThreadPool() noexcept {
+    {
+        std::scoped_lock lock{_mutex};
+        _should_stop = true;
+    }
+    _cv.notify_all();
+    for (auto &&t : _threads) { t.join(); }
+}
+
+ThreadPool &ThreadPool::global() noexcept {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::dispatch(std::function<void()> task) noexcept {
+    {
+        std::scoped_lock lock{_mutex};
+        _tasks.emplace_back(std::move(task));
+    }
+    _cv.notify_one();
+}
+
+bool ThreadPool::_run_one() noexcept {
+    std::function<void()> task;
+    {
+        std::scoped_lock lock{_mutex};
+        if (_tasks.empty()) { return false; }
+        task = std::move(_tasks.front());
+        _tasks.pop_front();
+    }
+    task();
+    return true;
+}
+
+}// namespace luisa
@@ -0,0 +1,100 @@
+//
+// Created by Mike Smith on 2021/7/6.
+//
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include <core/concepts.h>
+
+namespace luisa {
+
+class TaskGroup;
+
+// A fixed set of worker threads with a shared FIFO task queue. Threads that
+// wait for a TaskGroup run queued tasks in the meantime, so tasks may spawn
+// and wait for sub-tasks (e.g. recursive builds) without deadlocking, and a
+// pool without workers simply runs everything on the waiting thread.
+class ThreadPool : concepts::Noncopyable {
+
+private:
+    std::vector<std::thread> _threads;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _should_stop{false};
+
+private:
+    friend class TaskGroup;
+    [[nodiscard]] bool _run_one() noexcept;
+
+public:
+    // by default one worker per hardware thread, minus the calling thread
+    explicit ThreadPool(size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u) - 1u) noexcept;
+    ~ThreadPool() noexcept;
+    [[nodiscard]] static ThreadPool &global() noexcept;
+    [[nodiscard]] auto size() const noexcept { return _threads.size(); }
+    void dispatch(std::function<void()> task) noexcept;
+
+    // invokes body(i) for i in [0, count), blocks until all are done
+    template<typename F>
+    void parallel_for(size_t count, F &&body, size_t grain = 1u) noexcept;
+};
+
+class TaskGroup : concepts::Noncopyable {
+
+private:
+    ThreadPool &_pool;
+    std::atomic<size_t> _pending{0u};
+
+public:
+    explicit TaskGroup(ThreadPool &pool = ThreadPool::global()) noexcept : _pool{pool} {}
+    ~TaskGroup() noexcept { wait(); }
+
+    template<typename F>
+    void run(F &&f) noexcept {
+        _pending.fetch_add(1u, std::memory_order::relaxed);
+        _pool.dispatch([this, f = std::forward<F>(f)]() mutable noexcept {
+            f();
+            _pending.fetch_sub(1u, std::memory_order::release);
+        });
+    }
+
+    void wait() noexcept {
+        while (_pending.load(std::memory_order::acquire) != 0u) {
+            if (!_pool._run_one()) { std::this_thread::yield(); }
+        }
+    }
+};
+
+template<typename F>
+void ThreadPool::parallel_for(size_t count, F &&body, size_t grain) noexcept {
+    auto chunk_count = std::min((count + grain - 1u) / grain, (size() + 1u) * 4u);
+    if (chunk_count <= 1u) {
+        for (auto i = 0u; i < count; i++) { body(i); }
+        return;
+    }
+    std::atomic<size_t> next_chunk{0u};
+    auto work = [&]() noexcept {
+        for (auto c = next_chunk.fetch_add(1u, std::memory_order::relaxed);
+             c < chunk_count;
+             c = next_chunk.fetch_add(1u, std::memory_order::relaxed)) {
+            auto end = (c + 1u) * count / chunk_count;
+            for (auto i = c * count / chunk_count; i < end; i++) { body(i); }
+        }
+    };
+    TaskGroup group{*this};
+    for (auto i = 1u; i < std::min(chunk_count, size() + 1u); i++) { group.run(work); }
+    work();
+    group.wait();
+}
+
+}// namespace luisa
@@ -0,0 +1,96 @@
+//
+// Created by Mike Smith on 2021/7/1.
+//
+
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <core/spin_mutex.h>
+#include <core/trace.h>
+
+namespace luisa {
+
+void TraceRing::snapshot(std::vector<TraceRecord> &records) const noexcept {
+    auto head = _head.load(std::memory_order::acquire);
+    auto first = head > capacity ? head - capacity : 0u;
+    auto offset = records.size();
+    for (auto i = first; i < head; i++) {
+        records.emplace_back(_records[i & (capacity - 1u)]);
+    }
+    // the owner keeps pushing while we copy; anything older than
+    // the new window may have been overwritten and is discarded, as
+    // is the slot of a push in flight at new_head, which is written
+    // before the head is published
+    std::atomic_thread_fence(std::memory_order::acquire);
+    auto new_head = _head.load(std::memory_order::relaxed);
+    auto valid_first = new_head + 1u > capacity ? new_head + 1u - capacity : 0u;
+    if (valid_first > first) {
+        auto torn = std::min(valid_first - first, head - first);
+        records.erase(records.begin() + static_cast<ptrdiff_t>(offset),
+                      records.begin() + static_cast<ptrdiff_t>(offset + torn));
+    }
+}
+
+namespace detail {
+
+struct TraceRegistry {
+    spin_mutex mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+};
+
+[[nodiscard]] static auto &trace_registry() noexcept {
+    static TraceRegistry registry;
+    return registry;
+}
+
+}// namespace detail
+
+TraceRing &trace_ring() noexcept {
+    static thread_local auto ring = [] {
+        auto &&registry = detail::trace_registry();
+        std::scoped_lock lock{registry.mutex};
+        auto thread = static_cast<uint32_t>(registry.rings.size());
+        // rings outlive their threads so that late dumps still see them
+        return registry.rings.emplace_back(std::make_unique<TraceRing>(thread)).get();
+    }();
+    return *ring;
+}
+
+std::vector<TraceRecord> trace_snapshot() noexcept {
+    std::vector<TraceRecord> records;
+    auto &&registry = detail::trace_registry();
+    {
+        std::scoped_lock lock{registry.mutex};
+        records.reserve(registry.rings.size() * TraceRing::capacity);
+        for (auto &&ring : registry.rings) { ring->snapshot(records); }
+    }
+    std::stable_sort(records.begin(), records.end(), [](auto lhs, auto rhs) noexcept {
+        return lhs.timestamp < rhs.timestamp;
+    });
+    return records;
+}
+
+void trace_dump(const std::filesystem::path &path) noexcept {
+    auto records = trace_snapshot();
+    std::ofstream file{path, std::ios::binary};
+    if (!file) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to open file '{}' for trace dump.",
+            path.string());
+        return;
+    }
+    static constexpr std::array<char, 8u> magic{'L', 'C', 'T', 'R', 'A', 'C', 'E', '\0'};
+    static constexpr auto version = 1u;
+    auto count = static_cast<uint32_t>(records.size());
+    file.write(magic.data(), magic.size());
+    file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char *>(records.data()),
+               static_cast<std::streamsize>(records.size() * sizeof(TraceRecord)));
+    LUISA_INFO("Dumped {} trace record(s) to '{}'.", count, path.string());
+}
+
+}// namespace luisa
@@ -0,0 +1,90 @@
+//
+// Created by Mike Smith on 2021/7/1.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include <core/platform.h>
+
+namespace luisa {
+
+struct TraceRecord {
+    uint64_t timestamp;// nanoseconds, steady clock
+    uint32_t event;
+    uint32_t thread;
+    uint64_t payload;
+};
+
+static_assert(sizeof(TraceRecord) == 24u);
+
+// Single-producer ring of the most recent trace records of one thread.
+// Pushing is wait-free (a few plain stores and one release store), and
+// readers on other threads snapshot it without ever blocking the owner.
+class TraceRing {
+
+public:
+    static constexpr auto capacity = 4096u;
+    static_assert((capacity & (capacity - 1u)) == 0u);
+
+private:
+    std::array<TraceRecord, capacity> _records{};
+    std::atomic<uint64_t> _head{0u};
+    uint32_t _thread;
+
+public:
+    explicit TraceRing(uint32_t thread) noexcept : _thread{thread} {}
+    TraceRing(TraceRing &&) noexcept = delete;
+    TraceRing &operator=(TraceRing &&) noexcept = delete;
+
+    [[nodiscard]] auto thread() const noexcept { return _thread; }
+
+    LUISA_FORCE_INLINE void push(uint32_t event, uint64_t payload) noexcept {
+        auto head = _head.load(std::memory_order::relaxed);
+        auto &&r = _records[head & (capacity - 1u)];
+        r.timestamp = static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+        r.event = event;
+        r.thread = _thread;
+        r.payload = payload;
+        _head.store(head + 1u, std::memory_order::release);
+    }
+
+    // Appends the records currently held to `records`, oldest first. Records
+    // the owner thread may have overwritten during the copy are dropped, so
+    // at most capacity - 1 records are returned.
+    void snapshot(std::vector<TraceRecord> &records) const noexcept;
+};
+
+// Ring of the calling thread, created and registered on first use.
+[[nodiscard]] TraceRing &trace_ring() noexcept;
+
+// Stable event ids derived from names, e.g. trace_event_id("stream::dispatch").
+[[nodiscard]] constexpr auto trace_event_id(std::string_view name) noexcept {
+    auto h = 2166136261u;// FNV-1a
+    for (auto c : name) { h = (h ^ static_cast<uint8_t>(c)) * 16777619u; }
+    return static_cast<uint32_t>(h);
+}
+
+// Records of all threads (including exited ones) sorted by timestamp.
+[[nodiscard]] std::vector<TraceRecord> trace_snapshot() noexcept;
+
+// Writes trace_snapshot() as a binary file: "LCTRACE\0", uint32 version,
+// uint32 record count, followed by the raw TraceRecord array.
+void trace_dump(const std::filesystem::path &path) noexcept;
+
+}// namespace luisa
+
+#ifndef LUISA_DISABLE_TRACE
+#define LUISA_TRACE(event, payload) \
+    ::luisa::trace_ring().push(event, static_cast<uint64_t>(payload))
+#else
+#define LUISA_TRACE(...)
+#endif
@@ -80,7 +80,9 @@ template<typename Dest, typename Src>
 }
 
 [[nodiscard]] inline auto block_size() noexcept {
-    return detail::FunctionBuilder::current()->block_size();
+    auto f = detail::FunctionBuilder::current();
+    f->mark_block_size_used();
+    return f->block_size();
 }
 
 [[nodiscard]] inline auto block_size_x() noexcept {
@@ -1459,4 +1461,68 @@ inline void device_memory_barrier() noexcept {
         CallOp::DEVICE_MEMORY_BARRIER, {});
 }
 
+// warp (SIMD group) operations, over the active lanes of the calling warp;
+// ballots are uint4 masks, with lane i at bit (i % 32) of component i / 32
+[[nodiscard]] inline auto warp_size() noexcept {
+    return detail::Expr<uint>{
+        detail::FunctionBuilder::current()->call(
+            Type::of<uint>(), CallOp::WARP_SIZE, {})};
+}
+
+[[nodiscard]] inline auto warp_lane_id() noexcept {
+    return detail::Expr<uint>{
+        detail::FunctionBuilder::current()->call(
+            Type::of<uint>(), CallOp::WARP_LANE_ID, {})};
+}
+
+[[nodiscard]] inline auto warp_ballot(detail::Expr<bool> pred) noexcept {
+    return detail::Expr<uint4>{
+        detail::FunctionBuilder::current()->call(
+            Type::of<uint4>(), CallOp::WARP_BALLOT, {pred.expression()})};
+}
+
+[[nodiscard]] inline auto warp_any(detail::Expr<bool> pred) noexcept {
+    return detail::Expr<bool>{
+        detail::FunctionBuilder::current()->call(
+            Type::of<bool>(), CallOp::WARP_ANY, {pred.expression()})};
+}
+
+[[nodiscard]] inline auto warp_all(detail::Expr<bool> pred) noexcept {
+    return detail::Expr<bool>{
+        detail::FunctionBuilder::current()->call(
+            Type::of<bool>(), CallOp::WARP_ALL, {pred.expression()})};
+}
+
+// value of x in the given lane, which must be the same for all active lanes
+template<typename T>
+requires concepts::scalar<T> || concepts::vector<T>
+[[nodiscard]] inline auto warp_broadcast(detail::Expr<T> x, detail::Expr<uint> lane) noexcept {
+    return detail::Expr<T>{
+        detail::FunctionBuilder::current()->call(
+            Type::of<T>(), CallOp::WARP_BROADCAST, {x.expression(), lane.expression()})};
+}
+
+// value of x in the given lane, which may differ among lanes
+template<typename T>
+requires concepts::scalar<T> || concepts::vector<T>
+[[nodiscard]] inline auto warp_shuffle(detail::Expr<T> x, detail::Expr<uint> lane) noexcept {
+    return detail::Expr<T>{
+        detail::FunctionBuilder::current()->call(
+            Type::of<T>(), CallOp::WARP_SHUFFLE, {x.expression(), lane.expression()})};
+}
+
+#define LUISA_MAKE_WARP_REDUCTION(func, tag)                                   \
+    template<typename T>                                                       \
+    requires concepts::scalar<T> || concepts::vector<T>                        \
+    [[nodiscard]] inline auto func(detail::Expr<T> x) noexcept {               \
+        return detail::Expr<T>{                                                \
+            detail::FunctionBuilder::current()->call(                          \
+                Type::of<T>(), CallOp::tag, {x.expression()})};                \
+    }
+LUISA_MAKE_WARP_REDUCTION(warp_reduce_sum, WARP_REDUCE_SUM)
+LUISA_MAKE_WARP_REDUCTION(warp_reduce_min, WARP_REDUCE_MIN)
+LUISA_MAKE_WARP_REDUCTION(warp_reduce_max, WARP_REDUCE_MAX)
+LUISA_MAKE_WARP_REDUCTION(warp_prefix_sum, WARP_PREFIX_SUM)// exclusive
+#undef LUISA_MAKE_WARP_REDUCTION
+
 }// namespace luisa::compute
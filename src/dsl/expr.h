@@ -5,11 +5,13 @@
 #pragma once
 
 #include <array>
+#include <vector>
 #include <string_view>
 
 #include <runtime/image.h>
 #include <runtime/volume.h>
 #include <runtime/buffer.h>
+#include <runtime/soa_buffer.h>
 #include <runtime/texture_heap.h>
 #include <ast/function_builder.h>
 
@@ -248,6 +250,51 @@ struct Expr<BufferView<T>> : public Expr<Buffer<T>> {
     using Expr<Buffer<T>>::Expr;
 };
 
+// Element of a SoABuffer<T>, defined by LUISA_STRUCT (see dsl/struct.h):
+// its members are reads and writes of the member arrays, and it converts
+// to and from Expr<T> by gathering and scattering all the members.
+template<typename T>
+struct SoARef;
+
+// One buffer expression per member of T, either kernel arguments (see
+// Var<SoABuffer<T>>) or bindings of the member arrays of a captured buffer.
+template<typename T>
+struct Expr<SoABuffer<T>> {
+
+public:
+    using ValueType = SoABuffer<T>;
+
+private:
+    std::vector<const RefExpr *> _members;
+
+public:
+    explicit Expr(std::vector<const RefExpr *> members) noexcept
+        : _members{std::move(members)} {}
+    explicit Expr(const SoABuffer<T> &buffer) noexcept {
+        auto types = Type::of<T>()->members();
+        auto handles = buffer.member_handles();
+        _members.reserve(handles.size());
+        for (auto i = 0u; i < handles.size(); i++) {
+            _members.emplace_back(FunctionBuilder::current()->buffer_binding(
+                SoABuffer<T>::member_buffer_type(types[i]), handles[i], 0u));
+        }
+    }
+
+    [[nodiscard]] auto members() const noexcept { return std::span{_members}; }
+
+    [[nodiscard]] auto operator[](Expr<uint> i) const noexcept {
+        return SoARef<T>{_members, i.expression()};
+    };
+
+    [[nodiscard]] auto operator[](Expr<int> i) const noexcept {
+        return SoARef<T>{_members, i.expression()};
+    };
+};
+
+// Atomic operations on buffer and shared elements. Besides int and uint,
+// float elements support the arithmetic operations and float2/float4
+// elements fetch_add/sub/min/max, component by component (each component
+// is updated atomically, the vector as a whole is not).
 template<typename T>
 class AtomicRef {
 
@@ -258,22 +305,22 @@ public:
     explicit AtomicRef(const AccessExpr *expr) noexcept
         : _expression{expr} {}
 
-    void store(Expr<T> value) const noexcept {
+    void store(Expr<T> value) const noexcept requires is_scalar_v<T> {
         FunctionBuilder::current()->call(CallOp::ATOMIC_STORE, {this->_expression, value.expression()});
     }
 
-    [[nodiscard]] auto load() const noexcept {
+    [[nodiscard]] auto load() const noexcept requires is_scalar_v<T> {
         auto expr = FunctionBuilder::current()->call(Type::of<T>(), CallOp::ATOMIC_LOAD, {this->_expression});
         return Expr<T>{expr};
     };
 
-    [[nodiscard]] auto exchange(Expr<T> desired) const noexcept {
+    [[nodiscard]] auto exchange(Expr<T> desired) const noexcept requires is_scalar_v<T> {
         auto expr = FunctionBuilder::current()->call(Type::of<T>(), CallOp::ATOMIC_EXCHANGE, {this->_expression, desired.expression()});
         return Expr<T>{expr};
     }
 
     // stores old == compare ? val : old, returns old
-    [[nodiscard]] auto compare_exchange(Expr<T> expected, Expr<T> desired) const noexcept {
+    [[nodiscard]] auto compare_exchange(Expr<T> expected, Expr<T> desired) const noexcept requires is_scalar_v<T> {
         auto expr = FunctionBuilder::current()->call(
             Type::of<T>(), CallOp::ATOMIC_COMPARE_EXCHANGE,
             {this->_expression, expected.expression(), desired.expression()});
@@ -290,17 +337,17 @@ public:
         return Expr<T>{expr};
     };
 
-    [[nodiscard]] auto fetch_and(Expr<T> val) const noexcept {
+    [[nodiscard]] auto fetch_and(Expr<T> val) const noexcept requires is_integral_v<T> {
         auto expr = FunctionBuilder::current()->call(Type::of<T>(), CallOp::ATOMIC_FETCH_AND, {this->_expression, val.expression()});
         return Expr<T>{expr};
     };
 
-    [[nodiscard]] auto fetch_or(Expr<T> val) const noexcept {
+    [[nodiscard]] auto fetch_or(Expr<T> val) const noexcept requires is_integral_v<T> {
         auto expr = FunctionBuilder::current()->call(Type::of<T>(), CallOp::ATOMIC_FETCH_OR, {this->_expression, val.expression()});
         return Expr<T>{expr};
     };
 
-    [[nodiscard]] auto fetch_xor(Expr<T> val) const noexcept {
+    [[nodiscard]] auto fetch_xor(Expr<T> val) const noexcept requires is_integral_v<T> {
         auto expr = FunctionBuilder::current()->call(Type::of<T>(), CallOp::ATOMIC_FETCH_XOR, {this->_expression, val.expression()});
         return Expr<T>{expr};
     };
@@ -348,6 +395,39 @@ struct BufferExprAsAtomic<uint> {
     }
 };
 
+template<>
+struct BufferExprAsAtomic<float> {
+    [[nodiscard]] auto atomic(Expr<int> i) const noexcept {
+        return AtomicRef<float>{FunctionBuilder::current()->access(
+            Type::of<float>(),
+            static_cast<const Expr<Buffer<float>> *>(this)->expression(),
+            i.expression())};
+    }
+    [[nodiscard]] auto atomic(Expr<uint> i) const noexcept {
+        return AtomicRef<float>{FunctionBuilder::current()->access(
+            Type::of<float>(),
+            static_cast<const Expr<Buffer<float>> *>(this)->expression(),
+            i.expression())};
+    }
+};
+
+template<size_t N>
+requires(N == 2u || N == 4u) struct BufferExprAsAtomic<Vector<float, N>> {
+    using V = Vector<float, N>;
+    [[nodiscard]] auto atomic(Expr<int> i) const noexcept {
+        return AtomicRef<V>{FunctionBuilder::current()->access(
+            Type::of<V>(),
+            static_cast<const Expr<Buffer<V>> *>(this)->expression(),
+            i.expression())};
+    }
+    [[nodiscard]] auto atomic(Expr<uint> i) const noexcept {
+        return AtomicRef<V>{FunctionBuilder::current()->access(
+            Type::of<V>(),
+            static_cast<const Expr<Buffer<V>> *>(this)->expression(),
+            i.expression())};
+    }
+};
+
 template<typename T>
 struct Expr<Image<T>> {
 
@@ -626,6 +706,12 @@ Expr(const Buffer<T> &) -> Expr<Buffer<T>>;
 template<typename T>
 Expr(BufferView<T>) -> Expr<Buffer<T>>;
 
+template<typename T>
+Expr(const SoABuffer<T> &) -> Expr<SoABuffer<T>>;
+
+template<typename T>
+Expr(SoARef<T>) -> Expr<T>;
+
 template<typename T>
 Expr(const Image<T> &) -> Expr<Image<T>>;
 
@@ -661,6 +747,11 @@ struct expr_value_impl<Var<T>> {
     using type = T;
 };
 
+template<typename T>
+struct expr_value_impl<SoARef<T>> {
+    using type = T;
+};
+
 template<typename T>
 using expr_value = expr_value_impl<std::remove_cvref_t<T>>;
 
@@ -217,6 +217,10 @@ class Callable<Ret(Args...)> {
         std::negation_v<std::disjunction<is_atomic<Args>...>>,
         "Callables are not allowed to have atomic arguments.");
 
+    static_assert(
+        std::negation_v<std::disjunction<is_soa_buffer<Args>...>>,
+        "Callables are not allowed to have SoA buffer arguments.");
+
 private:
     const detail::FunctionBuilder *_builder;
 
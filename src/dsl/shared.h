@@ -77,6 +77,39 @@ struct SharedAsAtomic<uint> {
     }
 };
 
+template<>
+struct SharedAsAtomic<float> {
+    [[nodiscard]] auto atomic(Expr<int> i) const noexcept {
+        return AtomicRef<float>{FunctionBuilder::current()->access(
+            Type::of<float>(),
+            static_cast<const Shared<float> *>(this)->expression(),
+            i.expression())};
+    }
+    [[nodiscard]] auto atomic(Expr<uint> i) const noexcept {
+        return AtomicRef<float>{FunctionBuilder::current()->access(
+            Type::of<float>(),
+            static_cast<const Shared<float> *>(this)->expression(),
+            i.expression())};
+    }
+};
+
+template<size_t N>
+requires(N == 2u || N == 4u) struct SharedAsAtomic<Vector<float, N>> {
+    using V = Vector<float, N>;
+    [[nodiscard]] auto atomic(Expr<int> i) const noexcept {
+        return AtomicRef<V>{FunctionBuilder::current()->access(
+            Type::of<V>(),
+            static_cast<const Shared<V> *>(this)->expression(),
+            i.expression())};
+    }
+    [[nodiscard]] auto atomic(Expr<uint> i) const noexcept {
+        return AtomicRef<V>{FunctionBuilder::current()->access(
+            Type::of<V>(),
+            static_cast<const Shared<V> *>(this)->expression(),
+            i.expression())};
+    }
+};
+
 }// namespace detail
 
 }// namespace luisa::compute
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <vector>
+#include <optional>
+
 #include <dsl/var.h>
 
 namespace luisa::compute {
@@ -76,7 +79,12 @@ public:
     void operator%(Body &&body) noexcept {
         if (_body_set) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Invalid WhileStmtBuilder state."); }
         _body_set = true;
-        FunctionBuilder::current()->with(_body, std::forward<Body>(body));
+        FunctionBuilder::current()->with(_body, [&body] {
+            auto f = FunctionBuilder::current();
+            f->push_jump_target(FunctionBuilder::JumpTarget::LOOP);
+            body();
+            f->pop_jump_target(FunctionBuilder::JumpTarget::LOOP);
+        });
     }
 };
 
@@ -94,8 +102,11 @@ public:
     template<typename Body>
     void operator%(Body &&body) noexcept {
         FunctionBuilder::current()->with(_body, [&body] {
+            auto f = FunctionBuilder::current();
+            f->push_jump_target(FunctionBuilder::JumpTarget::SWITCH);
             body();
-            FunctionBuilder::current()->break_();
+            f->break_();
+            f->pop_jump_target(FunctionBuilder::JumpTarget::SWITCH);
         });
     }
 };
@@ -113,8 +124,11 @@ public:
     template<typename Body>
     void operator%(Body &&body) noexcept {
         FunctionBuilder::current()->with(_body, [&body] {
+            auto f = FunctionBuilder::current();
+            f->push_jump_target(FunctionBuilder::JumpTarget::SWITCH);
             body();
-            FunctionBuilder::current()->break_();
+            f->break_();
+            f->pop_jump_target(FunctionBuilder::JumpTarget::SWITCH);
         });
     }
 };
@@ -196,6 +210,7 @@ public:
             _upd = scope->statements().back();
             auto body = f->scope();
             f->push_scope(body);
+            f->push_jump_target(FunctionBuilder::JumpTarget::LOOP);
             _body = body;
             return var;
         }
@@ -203,6 +218,7 @@ public:
         auto &operator++() noexcept {
             if (++_time == 1u) {
                 auto f = FunctionBuilder::current();
+                f->pop_jump_target(FunctionBuilder::JumpTarget::LOOP);
                 f->pop_scope(_body);
                 f->for_(_init, _cond, _upd, _body);
             }
@@ -224,6 +240,90 @@ public:
         : _begin{begin}, _end{end}, _step{step} {}
     [[nodiscard]] auto begin() const noexcept { return ForRangeIter{_begin, _end, _step}; }
     [[nodiscard]] auto end() const noexcept { return ForRangeEnd{}; }
+
+    // the trip values if begin, end and step are literals and there are at
+    // most max_trip_count of them; the loop is kept at runtime otherwise
+    [[nodiscard]] auto unrolled_values(size_t max_trip_count) const noexcept {
+        auto literal = [](Expr<T> e) noexcept -> std::optional<T> {
+            if (e.expression()->tag() != Expression::Tag::LITERAL) { return std::nullopt; }
+            return std::get<T>(static_cast<const LiteralExpr *>(e.expression())->value());
+        };
+        auto begin = literal(_begin);
+        auto end = literal(_end);
+        auto step = literal(_step);
+        std::optional<std::vector<T>> values;
+        if (!begin || !end || !step || *step == 0) { return values; }
+        values.emplace();
+        for (auto v = *begin; *step > 0 ? v < *end : v > *end; v += *step) {
+            if (values->size() == max_trip_count) { return decltype(values){}; }
+            values->emplace_back(v);
+        }
+        return values;
+    }
+};
+
+template<typename T, bool has_begin>
+class UnrolledForRange {
+
+public:
+    struct UnrolledForRangeEnd {};
+
+    class UnrolledForRangeIter {
+    private:
+        const std::vector<T> *_values;
+        size_t _index{0u};
+        std::optional<typename ForRange<T, has_begin>::ForRangeIter> _loop;
+        bool _pushed{false};// whether the body of the current trip is being expanded
+
+        void _pop() noexcept {
+            if (_pushed) {
+                FunctionBuilder::current()->pop_jump_target(
+                    FunctionBuilder::JumpTarget::UNROLLED_LOOP);
+                _pushed = false;
+            }
+        }
+
+    public:
+        UnrolledForRangeIter(const std::vector<T> *values, const ForRange<T, has_begin> &range) noexcept
+            : _values{values} {
+            if (_values == nullptr) { _loop.emplace(range.begin()); }
+        }
+        UnrolledForRangeIter(const UnrolledForRangeIter &) noexcept = delete;
+        UnrolledForRangeIter &operator=(const UnrolledForRangeIter &) noexcept = delete;
+        // the body may be left without advancing, e.g. by a host-side break
+        ~UnrolledForRangeIter() noexcept { _pop(); }
+        [[nodiscard]] Expr<T> operator*() noexcept {
+            if (_loop) { return **_loop; }
+            if (!_pushed) {
+                FunctionBuilder::current()->push_jump_target(
+                    FunctionBuilder::JumpTarget::UNROLLED_LOOP);
+                _pushed = true;
+            }
+            return (*_values)[_index];
+        }
+        auto &operator++() noexcept {
+            if (_loop) {
+                static_cast<void>(++*_loop);
+            } else {
+                _pop();
+                _index++;
+            }
+            return *this;
+        }
+        [[nodiscard]] auto operator!=(UnrolledForRangeEnd) const noexcept {
+            return _loop ? *_loop != typename ForRange<T, has_begin>::ForRangeEnd{} : _index < _values->size();
+        }
+    };
+
+private:
+    ForRange<T, has_begin> _range;
+    std::optional<std::vector<T>> _values;
+
+public:
+    UnrolledForRange(ForRange<T, has_begin> range, size_t max_trip_count) noexcept
+        : _range{range}, _values{range.unrolled_values(max_trip_count)} {}
+    [[nodiscard]] auto begin() const noexcept { return UnrolledForRangeIter{_values ? &*_values : nullptr, _range}; }
+    [[nodiscard]] auto end() const noexcept { return UnrolledForRangeEnd{}; }
 };
 
 }// namespace detail
@@ -273,4 +373,17 @@ template<concepts::integral T>
     return detail::ForRange<T, true>{begin, Var{end}, Var{step}};
 }
 
+// Expands the body of the loop once per trip, with the induction variable
+// as a literal, if the range is made of host constants, e.g. unroll(range(3)),
+// and has at most max_trip_count trips; emits a runtime loop otherwise. As
+// there is no loop left when unrolled, break_() and continue_() directly in
+// the body are rejected; loops and switches nested in the body may use them.
+static constexpr auto default_unroll_max_trip_count = 16u;
+
+template<typename T, bool has_begin>
+[[nodiscard]] inline auto unroll(detail::ForRange<T, has_begin> range,
+                                 size_t max_trip_count = default_unroll_max_trip_count) noexcept {
+    return detail::UnrolledForRange<T, has_begin>{range, max_trip_count};
+}
+
 }// namespace luisa::compute
@@ -0,0 +1,80 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <ast/type_registry.h>
+#include <dsl/var.h>
+#include <dsl/builtin.h>
+
+LUISA_STRUCT_REFLECT(luisa::packed_float3, x, y, z)
+LUISA_STRUCT_REFLECT(luisa::packed_int3, x, y, z)
+LUISA_STRUCT_REFLECT(luisa::packed_uint3, x, y, z)
+LUISA_STRUCT_REFLECT(luisa::float3x4, rows)
+
+namespace luisa::compute::detail {
+
+// Storage-only types are plain structures in Type and buffers. Their
+// expressions convert implicitly to the compute types when loaded, and
+// accept the compute types when stored, e.g.
+//   Float3 p = packed_positions[i];
+//   packed_positions[i] = p + offset;
+//   Float4x4 m = transforms[i];
+
+#define LUISA_MAKE_PACKED_VECTOR3_EXPR(S)                                                              \
+    template<>                                                                                         \
+    struct storage_compute<packed_##S##3> {                                                            \
+        using type = S##3;                                                                             \
+    };                                                                                                 \
+    template<>                                                                                         \
+    struct Expr<packed_##S##3> : public ExprBase<packed_##S##3> {                                      \
+        using ExprBase<packed_##S##3>::ExprBase;                                                       \
+        Expr(Expr &&another) noexcept = default;                                                       \
+        Expr(const Expr &another) noexcept = default;                                                  \
+        void operator=(Expr &&rhs) noexcept { ExprBase<packed_##S##3>::operator=(rhs); }               \
+        void operator=(const Expr &rhs) noexcept { ExprBase<packed_##S##3>::operator=(rhs); }          \
+        Expr<S> x{FunctionBuilder::current()->member(Type::of<S>(), this->expression(), 0u)};          \
+        Expr<S> y{FunctionBuilder::current()->member(Type::of<S>(), this->expression(), 1u)};          \
+        Expr<S> z{FunctionBuilder::current()->member(Type::of<S>(), this->expression(), 2u)};          \
+        [[nodiscard]] operator Expr<S##3>() const noexcept { return make_##S##3(x, y, z); }            \
+        void operator=(Expr<S##3> rhs) noexcept {                                                      \
+            Var v = rhs;                                                                               \
+            x = v.x;                                                                                   \
+            y = v.y;                                                                                   \
+            z = v.z;                                                                                   \
+        }                                                                                              \
+    };
+
+LUISA_MAKE_PACKED_VECTOR3_EXPR(float)
+LUISA_MAKE_PACKED_VECTOR3_EXPR(int)
+LUISA_MAKE_PACKED_VECTOR3_EXPR(uint)
+
+#undef LUISA_MAKE_PACKED_VECTOR3_EXPR
+
+template<>
+struct storage_compute<float3x4> {
+    using type = float4x4;
+};
+
+template<>
+struct Expr<float3x4> : public ExprBase<float3x4> {
+    using ExprBase<float3x4>::ExprBase;
+    Expr(Expr &&another) noexcept = default;
+    Expr(const Expr &another) noexcept = default;
+    void operator=(Expr &&rhs) noexcept { ExprBase<float3x4>::operator=(rhs); }
+    void operator=(const Expr &rhs) noexcept { ExprBase<float3x4>::operator=(rhs); }
+    Expr<float4[3]> rows{FunctionBuilder::current()->member(Type::of<float4[3]>(), this->expression(), 0u)};
+    [[nodiscard]] operator Expr<float4x4>() const noexcept {
+        return transpose(make_float4x4(rows[0u], rows[1u], rows[2u], make_float4(0.0f, 0.0f, 0.0f, 1.0f)));
+    }
+    // the last row of the matrix is dropped
+    void operator=(Expr<float4x4> rhs) noexcept {
+        Var m = transpose(rhs);
+        rows[0u] = m[0u];
+        rows[1u] = m[1u];
+        rows[2u] = m[2u];
+    }
+};
+
+}// namespace luisa::compute::detail
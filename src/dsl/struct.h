@@ -16,24 +16,63 @@ public:                                                                     \
         ExprBase<This>::_expression,                                        \
         _member_index(#m))};
 
-#define LUISA_STRUCT(S, ...)                                                                                     \
-    LUISA_STRUCT_REFLECT(S, __VA_ARGS__)                                                                         \
-    namespace luisa::compute::detail {                                                                           \
-    template<>                                                                                                   \
-    struct Expr<S> : public ExprBase<S> {                                                                        \
-    private:                                                                                                     \
-        using This = S;                                                                                          \
-        [[nodiscard]] static constexpr size_t _member_index(std::string_view name) noexcept {                    \
-            constexpr const std::string_view member_names[]{LUISA_MAP_LIST(LUISA_STRINGIFY, __VA_ARGS__)};       \
-            return std::find(std::begin(member_names), std::end(member_names), name) - std::begin(member_names); \
-        }                                                                                                        \
-                                                                                                                 \
-    public:                                                                                                      \
-        using ExprBase<S>::ExprBase;                                                                             \
-        Expr(Expr &&another) noexcept = default;                                                                 \
-        Expr(const Expr &another) noexcept = default;                                                            \
-        void operator=(Expr &&rhs) noexcept { ExprBase<S>::operator=(rhs); }                                     \
-        void operator=(const Expr &rhs) noexcept { ExprBase<S>::operator=(rhs); }                                \
-        LUISA_MAP(LUISA_STRUCT_MAKE_MEMBER_EXPR, __VA_ARGS__)                                                    \
-    };                                                                                                           \
+#define LUISA_STRUCT_MAKE_MEMBER_SOA_REF(m)                                 \
+private:                                                                    \
+    using Type_##m = std::remove_cvref_t<decltype(std::declval<This>().m)>; \
+                                                                            \
+public:                                                                     \
+    Expr<Type_##m> m{_member<Type_##m>(Expr<This>::_member_index(#m))};
+
+#define LUISA_STRUCT_GATHER_MEMBER(m) _element.m = m;
+#define LUISA_STRUCT_SCATTER_MEMBER(m) m = _element.m;
+
+#define LUISA_STRUCT(S, ...)                                                                                      \
+    LUISA_STRUCT_REFLECT(S, __VA_ARGS__)                                                                          \
+    namespace luisa::compute::detail {                                                                            \
+    template<>                                                                                                    \
+    struct Expr<S> : public ExprBase<S> {                                                                         \
+    private:                                                                                                      \
+        using This = S;                                                                                           \
+        friend struct SoARef<S>;                                                                                  \
+        [[nodiscard]] static constexpr size_t _member_index(std::string_view name) noexcept {                     \
+            constexpr const std::string_view member_names[]{LUISA_MAP_LIST(LUISA_STRINGIFY, __VA_ARGS__)};        \
+            return std::find(std::begin(member_names), std::end(member_names), name) - std::begin(member_names);  \
+        }                                                                                                         \
+                                                                                                                  \
+    public:                                                                                                       \
+        using ExprBase<S>::ExprBase;                                                                              \
+        Expr(Expr &&another) noexcept = default;                                                                  \
+        Expr(const Expr &another) noexcept = default;                                                             \
+        void operator=(Expr &&rhs) noexcept { ExprBase<S>::operator=(rhs); }                                      \
+        void operator=(const Expr &rhs) noexcept { ExprBase<S>::operator=(rhs); }                                 \
+        LUISA_MAP(LUISA_STRUCT_MAKE_MEMBER_EXPR, __VA_ARGS__)                                                     \
+    };                                                                                                            \
+    template<>                                                                                                    \
+    struct SoARef<S> {                                                                                            \
+    private:                                                                                                      \
+        using This = S;                                                                                           \
+        std::vector<const RefExpr *> _buffers;                                                                    \
+        const Expression *_index;                                                                                 \
+        template<typename M>                                                                                      \
+        [[nodiscard]] Expr<M> _member(size_t index) const noexcept {                                              \
+            return Expr<M>{FunctionBuilder::current()->access(Type::of<M>(), _buffers[index], _index)};           \
+        }                                                                                                         \
+                                                                                                                  \
+    public:                                                                                                       \
+        SoARef(std::span<const RefExpr *const> buffers, const Expression *index) noexcept                         \
+            : _buffers{buffers.begin(), buffers.end()}, _index{index} {}                                          \
+        SoARef(SoARef &&) noexcept = default;                                                                     \
+        SoARef(const SoARef &) noexcept = default;                                                                \
+        LUISA_MAP(LUISA_STRUCT_MAKE_MEMBER_SOA_REF, __VA_ARGS__)                                                  \
+        [[nodiscard]] operator Expr<S>() const noexcept {                                                         \
+            Var<S> _element;                                                                                      \
+            LUISA_MAP(LUISA_STRUCT_GATHER_MEMBER, __VA_ARGS__)                                                    \
+            return _element;                                                                                      \
+        }                                                                                                         \
+        void operator=(Expr<S> rhs) noexcept {                                                                    \
+            Var _element = rhs;                                                                                   \
+            LUISA_MAP(LUISA_STRUCT_SCATTER_MEMBER, __VA_ARGS__)                                                   \
+        }                                                                                                         \
+        void operator=(const SoARef &rhs) noexcept { *this = Expr<S>{rhs}; }                                      \
+    };                                                                                                            \
     }
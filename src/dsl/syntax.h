@@ -8,6 +8,7 @@
 #include <dsl/constant.h>
 #include <dsl/shared.h>
 #include <dsl/struct.h>
+#include <dsl/storage.h>
 #include <dsl/stmt.h>
 #include <dsl/expr.h>
 #include <dsl/var.h>
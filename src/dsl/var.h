@@ -9,6 +9,17 @@
 
 namespace luisa::compute {
 
+namespace detail {
+
+// compute type of storage-only types, specialized in dsl/storage.h
+template<typename T>
+struct storage_compute {};
+
+template<typename T>
+using storage_compute_t = typename storage_compute<T>::type;
+
+}// namespace detail
+
 template<typename T>
 struct Var : public detail::Expr<T> {
 
@@ -23,6 +34,12 @@ struct Var : public detail::Expr<T> {
             Type::of<T>(),
             {detail::extract_expression(std::forward<Args>(args))...})} {}
 
+    // from storage-only types, e.g. Float3 p = packed_positions[i];
+    template<typename S>
+    requires std::same_as<detail::storage_compute_t<S>, T>
+    Var(const detail::Expr<S> &s) noexcept
+        : Var{static_cast<detail::Expr<T>>(s)} {}
+
     // for internal use only...
     explicit Var(detail::ArgumentCreation) noexcept
         : detail::Expr<T>{detail::FunctionBuilder::current()->argument(Type::of<T>())} {}
@@ -55,6 +72,26 @@ struct Var<BufferView<T>> : public detail::Expr<Buffer<T>> {
     Var &operator=(const Var &) noexcept = delete;
 };
 
+template<typename T>
+struct Var<SoABuffer<T>> : public detail::Expr<SoABuffer<T>> {
+    explicit Var(detail::ArgumentCreation) noexcept
+        : detail::Expr<SoABuffer<T>>{_create_members()} {}
+    Var(Var &&) noexcept = default;
+    Var(const Var &) noexcept = delete;
+    Var &operator=(Var &&) noexcept = delete;
+    Var &operator=(const Var &) noexcept = delete;
+
+private:
+    [[nodiscard]] static auto _create_members() noexcept {
+        std::vector<const RefExpr *> members;
+        for (auto m : Type::of<T>()->members()) {
+            members.emplace_back(detail::FunctionBuilder::current()->buffer(
+                SoABuffer<T>::member_buffer_type(m)));
+        }
+        return members;
+    }
+};
+
 template<typename T>
 struct Var<Image<T>> : public detail::Expr<Image<T>> {
     explicit Var(detail::ArgumentCreation) noexcept
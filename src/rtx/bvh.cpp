@@ -0,0 +1,729 @@
+//
+// Created by Mike Smith on 2021/7/6.
+//
+
+#include <array>
+#include <cmath>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/mathematics.h>
+#include <core/thread_pool.h>
+#include <rtx/bvh.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+struct AABB {
+
+    float3 min{std::numeric_limits<float>::max()};
+    float3 max{-std::numeric_limits<float>::max()};
+
+    void extend(float3 p) noexcept {
+        min = luisa::min(min, p);
+        max = luisa::max(max, p);
+    }
+
+    void extend(const AABB &b) noexcept {
+        min = luisa::min(min, b.min);
+        max = luisa::max(max, b.max);
+    }
+
+    [[nodiscard]] auto surface_area() const noexcept {
+        auto d = max - min;
+        return d.x < 0.0f ? 0.0f : 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+[[nodiscard]] auto node_bounds(const BVHNode &node) noexcept {
+    AABB bounds;
+    bounds.min = luisa::make_float3(node.min[0], node.min[1], node.min[2]);
+    bounds.max = luisa::make_float3(node.max[0], node.max[1], node.max[2]);
+    return bounds;
+}
+
+void set_bounds(BVHNode &node, const AABB &bounds) noexcept {
+    node.min[0] = bounds.min.x, node.min[1] = bounds.min.y, node.min[2] = bounds.min.z;
+    node.max[0] = bounds.max.x, node.max[1] = bounds.max.y, node.max[2] = bounds.max.z;
+}
+
+class BVHBuilder {
+
+private:
+    struct Bin {
+        AABB bounds;
+        uint32_t count{0u};
+    };
+
+private:
+    const BVH::Config &_config;
+    std::span<BVHNode> _nodes;
+    std::span<uint32_t> _primitives;
+    std::vector<AABB> _primitive_bounds;
+    std::vector<float3> _centroids;
+    std::atomic<uint32_t> _node_count{1u};
+    TaskGroup _tasks;
+
+private:
+    void _make_node(uint32_t node_index, const AABB &bounds, uint32_t index, uint32_t count) noexcept {
+        auto &&node = _nodes[node_index];
+        set_bounds(node, bounds);
+        node.index = index;
+        node.count = count;
+    }
+
+    // returns the partition point, or end to make a leaf
+    [[nodiscard]] uint32_t _split(uint32_t begin, uint32_t end, const AABB &bounds, const AABB &centroid_bounds) noexcept {
+
+        auto count = end - begin;
+        auto bin_count = std::clamp(_config.bin_count, 2u, BVH::max_bin_count);
+        auto best_cost = std::numeric_limits<float>::max();
+        auto best_axis = -1;
+        auto best_split = 0u;
+        for (auto axis = 0; axis < 3; axis++) {
+            auto lo = centroid_bounds.min[axis];
+            auto extent = centroid_bounds.max[axis] - lo;
+            if (!(extent > 0.0f)) { continue; }
+            auto scale = static_cast<float>(bin_count) / extent;
+            std::array<Bin, BVH::max_bin_count> bins{};
+            for (auto i = begin; i < end; i++) {
+                auto p = _primitives[i];
+                auto b = std::min(static_cast<uint32_t>((_centroids[p][axis] - lo) * scale), bin_count - 1u);
+                bins[b].bounds.extend(_primitive_bounds[p]);
+                bins[b].count++;
+            }
+            // sweep from the right to get the cost of the right halves
+            std::array<float, BVH::max_bin_count> right_costs{};
+            AABB right;
+            auto right_count = 0u;
+            for (auto b = bin_count - 1u; b > 0u; b--) {
+                right.extend(bins[b].bounds);
+                right_count += bins[b].count;
+                right_costs[b] = right.surface_area() * static_cast<float>(right_count);
+            }
+            AABB left;
+            auto left_count = 0u;
+            for (auto b = 1u; b < bin_count; b++) {
+                left.extend(bins[b - 1u].bounds);
+                left_count += bins[b - 1u].count;
+                if (left_count == 0u || left_count == count) { continue; }
+                auto cost = left.surface_area() * static_cast<float>(left_count) + right_costs[b];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_split = b;
+                }
+            }
+        }
+
+        if (best_axis < 0) {// all centroids coincide
+            return count <= _config.max_leaf_size ? end : begin + count / 2u;
+        }
+        auto leaf_cost = _config.intersection_cost * static_cast<float>(count);
+        auto split_cost = _config.traversal_cost +
+                          _config.intersection_cost * best_cost / std::max(bounds.surface_area(), std::numeric_limits<float>::min());
+        if (count <= _config.max_leaf_size && leaf_cost <= split_cost) { return end; }
+
+        auto lo = centroid_bounds.min[best_axis];
+        auto scale = static_cast<float>(bin_count) / (centroid_bounds.max[best_axis] - lo);
+        auto mid = std::partition(
+            _primitives.begin() + begin, _primitives.begin() + end,
+            [&](auto p) noexcept {
+                auto b = std::min(static_cast<uint32_t>((_centroids[p][best_axis] - lo) * scale), bin_count - 1u);
+                return b < best_split;
+            });
+        return static_cast<uint32_t>(mid - _primitives.begin());
+    }
+
+    void _build(uint32_t node_index, uint32_t begin, uint32_t end) noexcept {
+        for (;;) {
+            AABB bounds;
+            AABB centroid_bounds;
+            for (auto i = begin; i < end; i++) {
+                auto p = _primitives[i];
+                bounds.extend(_primitive_bounds[p]);
+                centroid_bounds.extend(_centroids[p]);
+            }
+            auto mid = end - begin <= 1u ? end : _split(begin, end, bounds, centroid_bounds);
+            if (mid == end) {
+                _make_node(node_index, bounds, begin, end - begin);
+                return;
+            }
+            auto left = _node_count.fetch_add(2u, std::memory_order::relaxed);
+            _make_node(node_index, bounds, left, 0u);
+            if (mid - begin >= BVH::parallel_threshold) {
+                _tasks.run([this, left, begin, mid]() noexcept { _build(left, begin, mid); });
+            } else {
+                _build(left, begin, mid);
+            }
+            node_index = left + 1u;
+            begin = mid;
+        }
+    }
+
+public:
+    BVHBuilder(const BVH::Config &config, std::span<BVHNode> nodes,
+               std::span<uint32_t> primitives, std::vector<AABB> primitive_bounds) noexcept
+        : _config{config}, _nodes{nodes}, _primitives{primitives},
+          _primitive_bounds{std::move(primitive_bounds)}, _centroids(_primitive_bounds.size()) {
+        ThreadPool::global().parallel_for(_primitive_bounds.size(), [this](size_t i) noexcept {
+            auto &&bounds = _primitive_bounds[i];
+            _centroids[i] = 0.5f * (bounds.min + bounds.max);
+            _primitives[i] = static_cast<uint32_t>(i);
+        }, 1024u);
+    }
+
+    [[nodiscard]] auto build() noexcept {
+        _build(0u, 0u, static_cast<uint32_t>(_primitives.size()));
+        _tasks.wait();
+        return _node_count.load();
+    }
+};
+
+// builds over the given primitive bounds into nodes and primitives
+void build_bvh(const BVH::Config &config, std::vector<AABB> bounds,
+               std::vector<BVHNode> &nodes, std::vector<uint32_t> &primitives) noexcept {
+    if (bounds.size() >= std::numeric_limits<uint32_t>::max() / 2u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Too many primitives ({}) for BVH.",
+            bounds.size());
+    }
+    // a binary tree with n leaves has 2n - 1 nodes
+    nodes.resize(bounds.size() * 2u - 1u);
+    primitives.resize(bounds.size());
+    BVHBuilder builder{config, nodes, primitives, std::move(bounds)};
+    nodes.resize(builder.build());
+    nodes.shrink_to_fit();
+}
+
+void set_lane_bounds(WideBVHNode &wide_node, uint32_t lane, const BVHNode &node) noexcept {
+    wide_node.min_x[lane] = node.min[0], wide_node.min_y[lane] = node.min[1], wide_node.min_z[lane] = node.min[2];
+    wide_node.max_x[lane] = node.max[0], wide_node.max_y[lane] = node.max[1], wide_node.max_z[lane] = node.max[2];
+}
+
+// the up to width descendants replacing the node in a wide BVH, found by
+// opening the interior child with the largest surface area until all lanes are used
+template<uint32_t width>
+[[nodiscard]] auto open_children(std::span<const BVHNode> nodes, uint32_t node_index) noexcept {
+    std::array<uint32_t, width> children{};
+    auto child_count = 0u;
+    if (auto &&node = nodes[node_index]; node.is_leaf()) {
+        children[child_count++] = node_index;
+    } else {
+        children[child_count++] = node.index;
+        children[child_count++] = node.index + 1u;
+    }
+    while (child_count < width) {
+        auto largest = width;
+        auto largest_area = -1.0f;
+        for (auto i = 0u; i < child_count; i++) {
+            if (auto &&child = nodes[children[i]]; !child.is_leaf()) {
+                if (auto area = node_bounds(child).surface_area(); area > largest_area) {
+                    largest = i;
+                    largest_area = area;
+                }
+            }
+        }
+        if (largest == width) { break; }
+        auto left = nodes[children[largest]].index;
+        children[largest] = left;
+        children[child_count++] = left + 1u;
+    }
+    return std::make_pair(children, child_count);
+}
+
+uint32_t collapse_node(std::span<const BVHNode> nodes, std::vector<WideBVHNode> &wide_nodes,
+                       std::vector<uint32_t> &sources, uint32_t node_index) noexcept {
+    static constexpr auto width = WideBVHNode::width;
+    auto [children, child_count] = open_children<width>(nodes, node_index);
+    auto wide_index = static_cast<uint32_t>(wide_nodes.size());
+    auto &&wide_node = wide_nodes.emplace_back();
+    sources.resize(sources.size() + width, ~0u);
+    for (auto lane = 0u; lane < width; lane++) {
+        wide_node.min_x[lane] = wide_node.min_y[lane] = wide_node.min_z[lane] = std::numeric_limits<float>::max();
+        wide_node.max_x[lane] = wide_node.max_y[lane] = wide_node.max_z[lane] = -std::numeric_limits<float>::max();
+        wide_node.index[lane] = 0u;
+        wide_node.count[lane] = 0u;
+    }
+    for (auto lane = 0u; lane < child_count; lane++) {
+        auto &&child = nodes[children[lane]];
+        set_lane_bounds(wide_node, lane, child);
+        sources[wide_index * width + lane] = children[lane];
+        if (child.is_leaf()) {
+            wide_node.index[lane] = child.index;
+            wide_node.count[lane] = child.count;
+        }
+    }
+    // recursion may reallocate wide_nodes, so index it again afterwards
+    for (auto lane = 0u; lane < child_count; lane++) {
+        if (!nodes[children[lane]].is_leaf()) {
+            auto child_wide_index = collapse_node(nodes, wide_nodes, sources, children[lane]);
+            wide_nodes[wide_index].index[lane] = child_wide_index;
+        }
+    }
+    return wide_index;
+}
+
+// collapses the binary nodes into wide nodes in depth-first order; sources
+// maps every wide lane to its binary node, so refits only copy the bounds
+void collapse_bvh(std::span<const BVHNode> nodes, std::vector<WideBVHNode> &wide_nodes, std::vector<uint32_t> &sources) noexcept {
+    wide_nodes.clear();
+    sources.clear();
+    if (nodes.empty()) { return; }
+    wide_nodes.reserve(nodes.size() / 3u + 1u);
+    sources.reserve(wide_nodes.capacity() * WideBVHNode::width);
+    static_cast<void>(collapse_node(nodes, wide_nodes, sources, 0u));
+    wide_nodes.shrink_to_fit();
+    sources.shrink_to_fit();
+}
+
+void refit_wide_bvh(std::span<const BVHNode> nodes, std::span<WideBVHNode> wide_nodes, std::span<const uint32_t> sources) noexcept {
+    ThreadPool::global().parallel_for(wide_nodes.size(), [&](size_t i) noexcept {
+        for (auto lane = 0u; lane < WideBVHNode::width; lane++) {
+            if (auto source = sources[i * WideBVHNode::width + lane]; source != ~0u) {
+                set_lane_bounds(wide_nodes[i], lane, nodes[source]);
+            }
+        }
+    }, 256u);
+}
+
+// quantizes the bounds of the non-empty lanes into the node, outwards
+void quantize_node(CompressedBVHNode &node, const std::array<AABB, CompressedBVHNode::width> &bounds) noexcept {
+    static constexpr auto width = CompressedBVHNode::width;
+    AABB total;
+    for (auto lane = 0u; lane < width; lane++) {
+        if (node.meta[lane] != 0u) { total.extend(bounds[lane]); }
+    }
+    for (auto axis = 0u; axis < 3u; axis++) {
+        auto lo = total.min[axis];
+        auto extent = total.max[axis] - lo;
+        auto exponent = extent > 0.0f ? static_cast<int>(std::ceil(std::log2(extent / 255.0f))) : -126;
+        exponent = std::clamp(exponent, -126, 127);
+        while (exponent < 127 && lo + 255.0f * CompressedBVHNode::scale(exponent) < total.max[axis]) { exponent++; }
+        node.origin[axis] = lo;
+        node.exponent[axis] = static_cast<int8_t>(exponent);
+    }
+    std::array<uint8_t *, 3> lo_planes{node.lo_x, node.lo_y, node.lo_z};
+    std::array<uint8_t *, 3> hi_planes{node.hi_x, node.hi_y, node.hi_z};
+    for (auto lane = 0u; lane < width; lane++) {
+        for (auto axis = 0u; axis < 3u; axis++) {
+            if (node.meta[lane] == 0u) {
+                lo_planes[axis][lane] = 0u;
+                hi_planes[axis][lane] = 0u;
+                continue;
+            }
+            auto origin = node.origin[axis];
+            auto scale = CompressedBVHNode::scale(node.exponent[axis]);
+            auto lo = std::clamp(std::floor((bounds[lane].min[axis] - origin) / scale), 0.0f, 255.0f);
+            while (lo > 0.0f && origin + lo * scale > bounds[lane].min[axis]) { lo -= 1.0f; }
+            auto hi = std::clamp(std::ceil((bounds[lane].max[axis] - origin) / scale), 0.0f, 255.0f);
+            while (hi < 255.0f && origin + hi * scale < bounds[lane].max[axis]) { hi += 1.0f; }
+            lo_planes[axis][lane] = static_cast<uint8_t>(lo);
+            hi_planes[axis][lane] = static_cast<uint8_t>(hi);
+        }
+    }
+}
+
+void compress_node(std::span<const BVHNode> nodes, std::span<const uint32_t> primitives,
+                   std::vector<CompressedBVHNode> &compressed_nodes, std::vector<uint32_t> &compressed_primitives,
+                   uint32_t node_index, uint32_t compressed_index) noexcept {
+    static constexpr auto width = CompressedBVHNode::width;
+    auto [children, child_count] = open_children<width>(nodes, node_index);
+    CompressedBVHNode node{};
+    node.child_base = static_cast<uint32_t>(compressed_nodes.size());
+    node.primitive_base = static_cast<uint32_t>(compressed_primitives.size());
+    std::array<AABB, width> bounds{};
+    auto interior_count = 0u;
+    for (auto lane = 0u; lane < child_count; lane++) {
+        auto &&child = nodes[children[lane]];
+        bounds[lane] = node_bounds(child);
+        if (child.is_leaf()) {
+            node.meta[lane] = static_cast<uint8_t>(child.count);
+            compressed_primitives.insert(
+                compressed_primitives.end(),
+                primitives.begin() + child.index,
+                primitives.begin() + child.index + child.count);
+        } else {
+            node.meta[lane] = static_cast<uint8_t>(CompressedBVHNode::interior_flag | interior_count++);
+        }
+    }
+    quantize_node(node, bounds);
+    compressed_nodes.resize(compressed_nodes.size() + interior_count);
+    compressed_nodes[compressed_index] = node;
+    for (auto lane = 0u; lane < child_count; lane++) {
+        if (auto m = node.meta[lane]; m & CompressedBVHNode::interior_flag) {
+            compress_node(nodes, primitives, compressed_nodes, compressed_primitives, children[lane],
+                          node.child_base + (m & ~CompressedBVHNode::interior_flag));
+        }
+    }
+}
+
+// compresses the binary nodes, reordering the primitives so that leaf
+// children of a compressed node are contiguous
+void compress_bvh(std::span<const BVHNode> nodes, std::vector<uint32_t> &primitives,
+                  std::vector<CompressedBVHNode> &compressed_nodes) noexcept {
+    compressed_nodes.clear();
+    if (nodes.empty()) { return; }
+    std::vector<uint32_t> compressed_primitives;
+    compressed_primitives.reserve(primitives.size());
+    compressed_nodes.reserve(nodes.size() / 7u + 1u);
+    compressed_nodes.emplace_back();
+    compress_node(nodes, primitives, compressed_nodes, compressed_primitives, 0u, 0u);
+    compressed_nodes.shrink_to_fit();
+    primitives = std::move(compressed_primitives);
+}
+
+// the SAH cost of a node without its subtree, not yet divided by the root area
+[[nodiscard]] auto node_cost(const BVH::Config &config, const BVHNode &node, const AABB &bounds) noexcept {
+    return bounds.surface_area() * (node.is_leaf() ? config.intersection_cost * static_cast<float>(node.count) : config.traversal_cost);
+}
+
+[[nodiscard]] float normalize_cost(double cost, const BVHNode &root) noexcept {
+    auto root_area = std::max(node_bounds(root).surface_area(), std::numeric_limits<float>::min());
+    return static_cast<float>(cost / root_area);
+}
+
+[[nodiscard]] float sah_cost(const BVH::Config &config, std::span<const BVHNode> nodes) noexcept {
+    if (nodes.empty()) { return 0.0f; }
+    auto cost = 0.0;
+    for (auto &&node : nodes) { cost += node_cost(config, node, node_bounds(node)); }
+    return normalize_cost(cost, nodes.front());
+}
+
+// recomputes the bounds of the subtree bottom-up and returns its unnormalized SAH cost
+template<typename PrimitiveBounds>
+double refit_bvh(const BVH::Config &config, std::span<BVHNode> nodes, std::span<const uint32_t> primitives,
+                 const PrimitiveBounds &primitive_bounds, uint32_t node_index, uint32_t depth) noexcept {
+    auto &&node = nodes[node_index];
+    AABB bounds;
+    auto cost = 0.0;
+    if (node.is_leaf()) {
+        for (auto i = node.index; i < node.index + node.count; i++) {
+            bounds.extend(primitive_bounds(primitives[i]));
+        }
+    } else {
+        auto left_cost = 0.0;
+        auto left = node.index;
+        if (depth < BVH::refit_parallel_depth) {
+            TaskGroup group;
+            group.run([&, left, depth]() noexcept {
+                left_cost = refit_bvh(config, nodes, primitives, primitive_bounds, left, depth + 1u);
+            });
+            cost = refit_bvh(config, nodes, primitives, primitive_bounds, left + 1u, depth + 1u);
+            group.wait();
+        } else {
+            left_cost = refit_bvh(config, nodes, primitives, primitive_bounds, left, depth + 1u);
+            cost = refit_bvh(config, nodes, primitives, primitive_bounds, left + 1u, depth + 1u);
+        }
+        cost += left_cost;
+        bounds = node_bounds(nodes[left]);
+        bounds.extend(node_bounds(nodes[left + 1u]));
+    }
+    set_bounds(node, bounds);
+    return cost + node_cost(config, node, bounds);
+}
+
+template<typename PrimitiveBounds>
+[[nodiscard]] float refit_bvh(const BVH::Config &config, std::span<BVHNode> nodes, std::span<const uint32_t> primitives,
+                              const PrimitiveBounds &primitive_bounds) noexcept {
+    if (nodes.empty()) { return 0.0f; }
+    auto cost = refit_bvh(config, nodes, primitives, primitive_bounds, 0u, 0u);
+    return normalize_cost(cost, nodes.front());
+}
+
+// refits the compressed subtree bottom-up, accumulating its unnormalized SAH cost (excluding the node itself)
+template<typename PrimitiveBounds>
+AABB refit_compressed_bvh(const BVH::Config &config, std::span<CompressedBVHNode> nodes, std::span<const uint32_t> primitives,
+                          const PrimitiveBounds &primitive_bounds, uint32_t node_index, uint32_t depth, double &cost) noexcept {
+    static constexpr auto width = CompressedBVHNode::width;
+    auto &&node = nodes[node_index];
+    std::array<AABB, width> bounds{};
+    std::array<double, width> child_costs{};
+    auto refit_lanes = [&](auto &&refit_interior) noexcept {
+        auto primitive_offset = node.primitive_base;
+        for (auto lane = 0u; lane < width; lane++) {
+            auto m = node.meta[lane];
+            if (m == 0u) { continue; }
+            if (m & CompressedBVHNode::interior_flag) {
+                auto child = node.child_base + (m & ~CompressedBVHNode::interior_flag);
+                refit_interior([&, lane, child]() noexcept {
+                    bounds[lane] = refit_compressed_bvh(config, nodes, primitives, primitive_bounds, child, depth + 1u, child_costs[lane]);
+                });
+            } else {
+                for (auto i = primitive_offset; i < primitive_offset + m; i++) {
+                    bounds[lane].extend(primitive_bounds(primitives[i]));
+                }
+                primitive_offset += m;
+            }
+        }
+    };
+    if (depth < BVH::compressed_refit_parallel_depth) {
+        TaskGroup group;
+        refit_lanes([&group](auto &&refit_child) noexcept { group.run(refit_child); });
+        group.wait();
+    } else {
+        refit_lanes([](auto &&refit_child) noexcept { refit_child(); });
+    }
+    quantize_node(node, bounds);
+    AABB node_bounds;
+    cost = 0.0;
+    for (auto lane = 0u; lane < width; lane++) {
+        auto m = node.meta[lane];
+        if (m == 0u) { continue; }
+        node_bounds.extend(bounds[lane]);
+        auto lane_cost = (m & CompressedBVHNode::interior_flag) ? config.traversal_cost : config.intersection_cost * static_cast<float>(m);
+        cost += child_costs[lane] + bounds[lane].surface_area() * lane_cost;
+    }
+    return node_bounds;
+}
+
+[[nodiscard]] auto triangle_bounds(const MeshView &mesh, size_t i) noexcept {
+    auto t = mesh.triangle(i);
+    auto n = mesh.vertex_count();
+    if (t.i[0] >= n || t.i[1] >= n || t.i[2] >= n) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Triangle #{} ({}, {}, {}) references vertices "
+            "out of range (vertex count = {}).",
+            i, t.i[0], t.i[1], t.i[2], n);
+    }
+    AABB bounds;
+    bounds.extend(mesh.vertex(t.i[0]));
+    bounds.extend(mesh.vertex(t.i[1]));
+    bounds.extend(mesh.vertex(t.i[2]));
+    return bounds;
+}
+
+// world-space bounds of the instances from the root bounds of their meshes
+[[nodiscard]] auto instance_bounds(std::span<const TopLevelBVH::Instance> instances) noexcept {
+    std::vector<AABB> bounds(instances.size());
+    ThreadPool::global().parallel_for(instances.size(), [&](size_t i) noexcept {
+        auto &&instance = instances[i];
+        if (instance.mesh == nullptr || instance.mesh->empty()) { return; }
+        auto lo = instance.mesh->bounds_min();
+        auto hi = instance.mesh->bounds_max();
+        for (auto corner = 0u; corner < 8u; corner++) {
+            auto p = luisa::make_float4(
+                (corner & 1u) ? hi.x : lo.x,
+                (corner & 2u) ? hi.y : lo.y,
+                (corner & 4u) ? hi.z : lo.z, 1.0f);
+            bounds[i].extend(luisa::make_float3(instance.transform * p));
+        }
+    }, 256u);
+    return bounds;
+}
+
+}// namespace detail
+
+void BVH::build(const MeshView &mesh, BVH::Config config) noexcept {
+    _nodes.clear();
+    _primitives.clear();
+    _wide_nodes.clear();
+    _wide_sources.clear();
+    _packed_triangles.clear();
+    _compressed_nodes.clear();
+    _mesh = {};
+    if (config.layout == AccelLayout::COMPACT && config.max_leaf_size > max_compact_leaf_size) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Clamping max leaf size {} to {} for compact BVH.",
+            config.max_leaf_size, max_compact_leaf_size);
+        config.max_leaf_size = max_compact_leaf_size;
+    }
+    _config = config;
+    _built_sah_cost = 0.0f;
+    _sah_cost = 0.0f;
+    if (mesh.triangle_count() == 0u) { return; }
+    Clock clock;
+    std::vector<detail::AABB> bounds(mesh.triangle_count());
+    ThreadPool::global().parallel_for(bounds.size(), [&](size_t i) noexcept {
+        bounds[i] = detail::triangle_bounds(mesh, i);
+    }, 1024u);
+    detail::build_bvh(config, std::move(bounds), _nodes, _primitives);
+    if (config.layout == AccelLayout::COMPACT) {
+        detail::compress_bvh(_nodes, _primitives, _compressed_nodes);
+        _nodes.clear();
+        _nodes.shrink_to_fit();
+        // the refit tightens the quantized bounds from the triangles and measures the cost
+        refit(mesh);
+    } else {
+        detail::collapse_bvh(_nodes, _wide_nodes, _wide_sources);
+        _pack_triangles(mesh);
+        _sah_cost = detail::sah_cost(config, _nodes);
+        _bounds_min = luisa::make_float3(_nodes.front().min[0], _nodes.front().min[1], _nodes.front().min[2]);
+        _bounds_max = luisa::make_float3(_nodes.front().max[0], _nodes.front().max[1], _nodes.front().max[2]);
+    }
+    _built_sah_cost = _sah_cost;
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Built {} BVH over {} triangle(s) in {} ms "
+        "(SAH cost = {}, memory usage = {} bytes).",
+        config.layout == AccelLayout::COMPACT ? "compact" : "fast-trace",
+        mesh.triangle_count(), clock.toc(), _sah_cost, memory_usage());
+}
+
+void BVH::refit(const MeshView &mesh) noexcept {
+    if (mesh.triangle_count() != _primitives.size()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Cannot refit BVH over {} triangle(s) to {} triangle(s).",
+            _primitives.size(), mesh.triangle_count());
+    }
+    if (_primitives.empty()) { return; }
+    Clock clock;
+    auto primitive_bounds = [&](uint32_t p) noexcept {
+        return detail::triangle_bounds(mesh, p);
+    };
+    if (_config.layout == AccelLayout::COMPACT) {
+        _mesh = mesh;
+        auto cost = 0.0;
+        auto bounds = detail::refit_compressed_bvh(_config, _compressed_nodes, _primitives, primitive_bounds, 0u, 0u, cost);
+        auto root_area = std::max(bounds.surface_area(), std::numeric_limits<float>::min());
+        _sah_cost = static_cast<float>((cost + root_area * _config.traversal_cost) / root_area);
+        _bounds_min = bounds.min;
+        _bounds_max = bounds.max;
+    } else {
+        _sah_cost = detail::refit_bvh(_config, _nodes, _primitives, primitive_bounds);
+        detail::refit_wide_bvh(_nodes, _wide_nodes, _wide_sources);
+        _pack_triangles(mesh);
+        _bounds_min = luisa::make_float3(_nodes.front().min[0], _nodes.front().min[1], _nodes.front().min[2]);
+        _bounds_max = luisa::make_float3(_nodes.front().max[0], _nodes.front().max[1], _nodes.front().max[2]);
+    }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Refit BVH over {} triangle(s) in {} ms (SAH cost = {}, degradation = {}).",
+        _primitives.size(), clock.toc(), _sah_cost, sah_degradation());
+}
+
+size_t BVH::memory_usage() const noexcept {
+    return _nodes.capacity() * sizeof(BVHNode) +
+           _primitives.capacity() * sizeof(uint32_t) +
+           _wide_nodes.capacity() * sizeof(WideBVHNode) +
+           _wide_sources.capacity() * sizeof(uint32_t) +
+           _packed_triangles.capacity() * sizeof(PackedTriangle) +
+           _compressed_nodes.capacity() * sizeof(CompressedBVHNode);
+}
+
+size_t TopLevelBVH::memory_usage() const noexcept {
+    return _nodes.capacity() * sizeof(BVHNode) +
+           _primitives.capacity() * sizeof(uint32_t) +
+           _instances.capacity() * sizeof(Instance) +
+           _wide_nodes.capacity() * sizeof(WideBVHNode) +
+           _wide_sources.capacity() * sizeof(uint32_t);
+}
+
+void BVH::_pack_triangles(const MeshView &mesh) noexcept {
+    _packed_triangles.resize(_primitives.size());
+    ThreadPool::global().parallel_for(_primitives.size(), [&](size_t i) noexcept {
+        auto t = mesh.triangle(_primitives[i]);
+        auto v0 = mesh.vertex(t.i[0]);
+        auto v1 = mesh.vertex(t.i[1]);
+        auto v2 = mesh.vertex(t.i[2]);
+        auto &&packed = _packed_triangles[i];
+        for (auto axis = 0u; axis < 3u; axis++) {
+            packed.v0[axis] = v0[axis];
+            packed.v1[axis] = v1[axis];
+            packed.v2[axis] = v2[axis];
+        }
+    }, 1024u);
+}
+
+bool BVH::update(const MeshView &mesh) noexcept {
+    refit(mesh);
+    if (sah_degradation() <= _config.rebuild_threshold) { return false; }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Rebuilding BVH with SAH cost degraded by {} (threshold = {}).",
+        sah_degradation(), _config.rebuild_threshold);
+    build(mesh, _config);
+    return true;
+}
+
+void TopLevelBVH::build(std::span<const BVH *const> meshes, std::span<const float3x4> transforms, BVH::Config config) noexcept {
+    if (meshes.size() != transforms.size()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Mismatched instance mesh count ({}) and transform count ({}).",
+            meshes.size(), transforms.size());
+    }
+    _nodes.clear();
+    _primitives.clear();
+    _wide_nodes.clear();
+    _wide_sources.clear();
+    _config = config;
+    _built_sah_cost = 0.0f;
+    _sah_cost = 0.0f;
+    _instances.resize(meshes.size());
+    for (auto i = 0u; i < meshes.size(); i++) {
+        _instances[i].mesh = meshes[i];
+        _instances[i].transform = luisa::make_float4x4(transforms[i]);
+        _instances[i].inverse_transform = inverse(_instances[i].transform);
+    }
+    if (_instances.empty()) { return; }
+    Clock clock;
+    detail::build_bvh(config, detail::instance_bounds(_instances), _nodes, _primitives);
+    detail::collapse_bvh(_nodes, _wide_nodes, _wide_sources);
+    _built_sah_cost = _sah_cost = detail::sah_cost(config, _nodes);
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Built top-level BVH with {} node(s) over {} instance(s) in {} ms (SAH cost = {}).",
+        _nodes.size(), _instances.size(), clock.toc(), _sah_cost);
+}
+
+bool TopLevelBVH::update(std::span<const float3x4> transforms) noexcept {
+    if (transforms.size() != _instances.size()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid transform count {} for {} instance(s).",
+            transforms.size(), _instances.size());
+    }
+    Clock clock;
+    for (auto i = 0u; i < _instances.size(); i++) {
+        _instances[i].transform = luisa::make_float4x4(transforms[i]);
+        _instances[i].inverse_transform = inverse(_instances[i].transform);
+    }
+    auto bounds = detail::instance_bounds(_instances);
+    _sah_cost = detail::refit_bvh(_config, _nodes, _primitives, [&bounds](uint32_t p) noexcept {
+        return bounds[p];
+    });
+    if (sah_degradation() <= _config.rebuild_threshold) {
+        detail::refit_wide_bvh(_nodes, _wide_nodes, _wide_sources);
+        LUISA_VERBOSE_WITH_LOCATION(
+            "Refit top-level BVH with {} node(s) in {} ms (SAH cost = {}, degradation = {}).",
+            _nodes.size(), clock.toc(), _sah_cost, sah_degradation());
+        return false;
+    }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Rebuilding top-level BVH with SAH cost degraded by {} (threshold = {}).",
+        sah_degradation(), _config.rebuild_threshold);
+    detail::build_bvh(_config, std::move(bounds), _nodes, _primitives);
+    detail::collapse_bvh(_nodes, _wide_nodes, _wide_sources);
+    _built_sah_cost = _sah_cost = detail::sah_cost(_config, _nodes);
+    return true;
+}
+
+void build_host_mesh(BVH &bvh, const MeshBuildCommand *command, BVH::Config config) noexcept {
+    config.layout = command->layout();
+    bvh.build(MeshView{reinterpret_cast<const std::byte *>(command->vertex_buffer() + command->vertex_buffer_offset()),
+                       command->vertex_count(),
+                       reinterpret_cast<const std::byte *>(command->triangle_buffer() + command->triangle_buffer_offset()),
+                       command->triangle_count(), command->format()},
+              config);
+}
+
+bool update_host_mesh(BVH &bvh, const MeshUpdateCommand *command) noexcept {
+    return bvh.update(MeshView{reinterpret_cast<const std::byte *>(command->vertex_buffer() + command->vertex_buffer_offset()),
+                               command->vertex_count(),
+                               reinterpret_cast<const std::byte *>(command->triangle_buffer() + command->triangle_buffer_offset()),
+                               command->triangle_count(), command->format()});
+}
+
+void build_host_accel(TopLevelBVH &accel, const AccelBuildCommand *command, BVH::Config config) noexcept {
+    auto handles = command->mesh_handles();
+    std::vector<const BVH *> meshes(handles.size());
+    std::transform(handles.begin(), handles.end(), meshes.begin(), [](auto handle) noexcept {
+        return reinterpret_cast<const BVH *>(handle);
+    });
+    accel.build(meshes, command->transforms(), config);
+}
+
+bool update_host_accel(TopLevelBVH &accel, const AccelUpdateCommand *command) noexcept {
+    return accel.update(command->transforms());
+}
+
+}// namespace luisa::compute
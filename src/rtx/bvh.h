@@ -0,0 +1,278 @@
+//
+// Created by Mike Smith on 2021/7/6.
+//
+
+#pragma once
+
+#include <bit>
+#include <span>
+#include <vector>
+#include <cstring>
+
+#include <core/basic_types.h>
+#include <runtime/command.h>
+#include <rtx/geometry.h>
+#include <rtx/intersection.h>
+
+namespace luisa::compute {
+
+// Flattened binary BVH node. The two children of an interior node are
+// stored next to each other, so that a traversal step fetches both from
+// one cache line pair.
+struct alignas(32) BVHNode {
+    float min[3];
+    uint32_t index;// interior: index of the left child (right = index + 1); leaf: first primitive
+    float max[3];
+    uint32_t count;// number of primitives in the leaf; 0 for interior nodes
+    [[nodiscard]] auto is_leaf() const noexcept { return count != 0u; }
+};
+
+static_assert(sizeof(BVHNode) == 32u);
+
+// 4-wide node collapsed from the binary nodes for traversal, with the child
+// bounds in SoA layout so that a ray is tested against all children at once
+// (the per-lane loops are auto-vectorized to SSE/AVX/NEON). Empty lanes have
+// inverted bounds and are never entered.
+struct alignas(64) WideBVHNode {
+    static constexpr auto width = 4u;
+    float min_x[width];
+    float min_y[width];
+    float min_z[width];
+    float max_x[width];
+    float max_y[width];
+    float max_z[width];
+    uint32_t index[width];// interior child: index of its wide node; leaf child: first primitive
+    uint32_t count[width];// number of primitives in a leaf child; 0 otherwise
+};
+
+static_assert(sizeof(WideBVHNode) == 128u);
+
+// 8-wide node of the AccelLayout::COMPACT layout, 80 bytes in place of the
+// seven binary nodes (224 bytes) it may replace. Child bounds are quantized
+// to 8 bits per plane relative to the origin with a power-of-two scale per
+// axis, rounded outwards so that they stay conservative. Interior children
+// are stored contiguously from child_base, and the primitives of leaf
+// children contiguously from primitive_base in lane order.
+struct alignas(16) CompressedBVHNode {
+    static constexpr auto width = 8u;
+    static constexpr auto interior_flag = 0x80u;
+    float origin[3];
+    int8_t exponent[3];
+    uint8_t padding;
+    uint32_t child_base;
+    uint32_t primitive_base;
+    uint8_t meta[width];// 0: empty; interior_flag | i: the i-th interior child; otherwise: primitive count of the leaf
+    uint8_t lo_x[width];
+    uint8_t lo_y[width];
+    uint8_t lo_z[width];
+    uint8_t hi_x[width];
+    uint8_t hi_y[width];
+    uint8_t hi_z[width];
+    // 2^exponent for exponent in [-126, 127]
+    [[nodiscard]] static auto scale(int exponent) noexcept {
+        return std::bit_cast<float>(static_cast<uint32_t>(exponent + 127) << 23u);
+    }
+};
+
+static_assert(sizeof(CompressedBVHNode) == 80u);
+
+// Host view of the vertex and index buffers of a mesh in any MeshFormat.
+// Vertices and triangles are decoded on access, so builds, refits and
+// COMPACT traversal read compact mesh buffers directly.
+class MeshView {
+
+private:
+    const std::byte *_vertices{nullptr};
+    const std::byte *_triangles{nullptr};
+    size_t _vertex_count{0u};
+    size_t _triangle_count{0u};
+    MeshFormat _format;
+
+public:
+    MeshView() noexcept = default;
+    MeshView(const void *vertices, size_t vertex_count, const void *triangles, size_t triangle_count, MeshFormat format) noexcept
+        : _vertices{static_cast<const std::byte *>(vertices)},
+          _triangles{static_cast<const std::byte *>(triangles)},
+          _vertex_count{vertex_count},
+          _triangle_count{triangle_count},
+          _format{format} {}
+    MeshView(std::span<const float3> vertices, std::span<const Triangle> triangles) noexcept
+        : MeshView{vertices.data(), vertices.size(), triangles.data(), triangles.size(), MeshFormat{}} {}
+    [[nodiscard]] auto vertex_count() const noexcept { return _vertex_count; }
+    [[nodiscard]] auto triangle_count() const noexcept { return _triangle_count; }
+    [[nodiscard]] const auto &format() const noexcept { return _format; }
+    [[nodiscard]] auto size_bytes() const noexcept {
+        return _vertex_count * _format.vertex_stride() + _triangle_count * _format.triangle_stride();
+    }
+    [[nodiscard]] float3 vertex(uint32_t i) const noexcept {
+        if (_format.vertex == VertexFormat::FLOAT3) { return reinterpret_cast<const float3 *>(_vertices)[i]; }
+        if (_format.vertex == VertexFormat::PACKED_FLOAT3) {
+            float v[3];
+            std::memcpy(v, _vertices + i * sizeof(v), sizeof(v));
+            return luisa::make_float3(v[0], v[1], v[2]);
+        }
+        uint16_t q[3];
+        std::memcpy(q, _vertices + i * sizeof(q), sizeof(q));
+        return _format.offset + _format.scale * luisa::make_float3(q[0], q[1], q[2]);
+    }
+    [[nodiscard]] Triangle triangle(size_t i) const noexcept {
+        if (_format.index == IndexFormat::UINT32) { return reinterpret_cast<const Triangle *>(_triangles)[i]; }
+        uint16_t t[3];
+        std::memcpy(t, _triangles + i * sizeof(t), sizeof(t));
+        return Triangle{{t[0], t[1], t[2]}};
+    }
+};
+
+// Host bottom-level BVH over the triangles of a mesh, built with binned SAH.
+// Subtrees above parallel_threshold primitives are built as separate tasks
+// on the global ThreadPool.
+//
+// With AccelLayout::FAST_TRACE the binary nodes are kept and collapsed into
+// wide nodes, and the triangles are packed in leaf order. AccelLayout::COMPACT
+// keeps only compressed nodes and the primitive indices, and references the
+// mesh passed to build() and refit(), which must outlive the BVH (on host
+// backends they are the mesh buffers).
+//
+// Deforming meshes with unchanged triangles are updated by refitting: the
+// bounds are recomputed bottom-up in O(n), with the subtrees below the top
+// refit_parallel_depth levels (compressed_refit_parallel_depth for COMPACT)
+// as separate tasks. The SAH cost (expected traversal cost of a random ray,
+// relative to the root) is measured on every build and refit; update() falls
+// back to a full rebuild once the refitted cost exceeds
+// Config::rebuild_threshold times the cost of the last build.
+class BVH {
+
+public:
+    struct Config {
+        uint32_t max_leaf_size{4u};
+        uint32_t bin_count{16u};// at most max_bin_count
+        float traversal_cost{1.0f};
+        float intersection_cost{1.0f};
+        float rebuild_threshold{1.5f};// infinity to always refit
+        AccelLayout layout{AccelLayout::FAST_TRACE};// COMPACT limits max_leaf_size to max_compact_leaf_size
+    };
+
+    static constexpr auto max_bin_count = 32u;
+    static constexpr auto max_compact_leaf_size = CompressedBVHNode::interior_flag - 1u;
+    static constexpr auto parallel_threshold = 4096u;
+    static constexpr auto refit_parallel_depth = 6u;
+    // the same for the 8-wide nodes of AccelLayout::COMPACT, i.e. up to 64 tasks
+    static constexpr auto compressed_refit_parallel_depth = 2u;
+
+private:
+    std::vector<BVHNode> _nodes;
+    std::vector<uint32_t> _primitives;
+    std::vector<WideBVHNode> _wide_nodes;
+    std::vector<uint32_t> _wide_sources;// binary node of each wide lane
+    std::vector<PackedTriangle> _packed_triangles;
+    std::vector<CompressedBVHNode> _compressed_nodes;
+    MeshView _mesh;
+    float3 _bounds_min;
+    float3 _bounds_max;
+    Config _config;
+    float _built_sah_cost{0.0f};
+    float _sah_cost{0.0f};
+
+private:
+    void _pack_triangles(const MeshView &mesh) noexcept;
+
+public:
+    void build(const MeshView &mesh, Config config) noexcept;
+    void build(std::span<const float3> vertices, std::span<const Triangle> triangles, Config config) noexcept {
+        build(MeshView{vertices, triangles}, config);
+    }
+    void build(std::span<const float3> vertices, std::span<const Triangle> triangles) noexcept {
+        build(MeshView{vertices, triangles}, Config{});
+    }
+    // recomputes the bounds for moved vertices, keeping the tree topology
+    void refit(const MeshView &mesh) noexcept;
+    void refit(std::span<const float3> vertices, std::span<const Triangle> triangles) noexcept {
+        refit(MeshView{vertices, triangles});
+    }
+    // refits, or rebuilds with config() if that degrades the SAH cost past
+    // the threshold; returns whether the BVH was rebuilt
+    bool update(const MeshView &mesh) noexcept;
+    bool update(std::span<const float3> vertices, std::span<const Triangle> triangles) noexcept {
+        return update(MeshView{vertices, triangles});
+    }
+    [[nodiscard]] auto empty() const noexcept { return _primitives.empty(); }
+    [[nodiscard]] auto bounds_min() const noexcept { return _bounds_min; }
+    [[nodiscard]] auto bounds_max() const noexcept { return _bounds_max; }
+    // triangle indices in leaf order, referenced by the leaves of either layout
+    [[nodiscard]] std::span<const uint32_t> primitives() const noexcept { return _primitives; }
+    // FAST_TRACE layout
+    [[nodiscard]] std::span<const BVHNode> nodes() const noexcept { return _nodes; }
+    [[nodiscard]] std::span<const WideBVHNode> wide_nodes() const noexcept { return _wide_nodes; }
+    // vertices of primitives()[i] at index i
+    [[nodiscard]] std::span<const PackedTriangle> packed_triangles() const noexcept { return _packed_triangles; }
+    // COMPACT layout
+    [[nodiscard]] std::span<const CompressedBVHNode> compressed_nodes() const noexcept { return _compressed_nodes; }
+    [[nodiscard]] const auto &mesh() const noexcept { return _mesh; }
+    // bytes held by the BVH, excluding the referenced mesh
+    [[nodiscard]] size_t memory_usage() const noexcept;
+    [[nodiscard]] const auto &config() const noexcept { return _config; }
+    [[nodiscard]] auto sah_cost() const noexcept { return _sah_cost; }
+    // SAH cost relative to that of the last build, 1 right after a build
+    [[nodiscard]] auto sah_degradation() const noexcept {
+        return _built_sah_cost > 0.0f ? _sah_cost / _built_sah_cost : 1.0f;
+    }
+};
+
+// Host top-level BVH over instances of mesh BVHs. Instances are bounded in
+// world space by their transformed mesh root bounds, so updating transforms
+// or refitting meshes only touches the top level, which is refit or rebuilt
+// under the same SAH threshold as mesh BVHs. The top level always uses the
+// FAST_TRACE layout.
+class TopLevelBVH {
+
+public:
+    struct Instance {
+        const BVH *mesh;
+        float4x4 transform;
+        float4x4 inverse_transform;
+    };
+
+private:
+    std::vector<BVHNode> _nodes;
+    std::vector<uint32_t> _primitives;
+    std::vector<Instance> _instances;
+    std::vector<WideBVHNode> _wide_nodes;
+    std::vector<uint32_t> _wide_sources;
+    BVH::Config _config;
+    float _built_sah_cost{0.0f};
+    float _sah_cost{0.0f};
+
+public:
+    void build(std::span<const BVH *const> meshes, std::span<const float3x4> transforms, BVH::Config config) noexcept;
+    void build(std::span<const BVH *const> meshes, std::span<const float3x4> transforms) noexcept {
+        build(meshes, transforms, BVH::Config{});
+    }
+    // refits to the new transforms and current mesh bounds, or rebuilds with
+    // config() past the threshold; returns whether the top level was rebuilt
+    bool update(std::span<const float3x4> transforms) noexcept;
+    [[nodiscard]] auto empty() const noexcept { return _nodes.empty(); }
+    [[nodiscard]] std::span<const BVHNode> nodes() const noexcept { return _nodes; }
+    // instance indices in leaf order, referenced by BVHNode::index of leaves
+    [[nodiscard]] std::span<const uint32_t> primitives() const noexcept { return _primitives; }
+    [[nodiscard]] std::span<const Instance> instances() const noexcept { return _instances; }
+    [[nodiscard]] std::span<const WideBVHNode> wide_nodes() const noexcept { return _wide_nodes; }
+    // bytes held by the top level, excluding the meshes
+    [[nodiscard]] size_t memory_usage() const noexcept;
+    [[nodiscard]] const auto &config() const noexcept { return _config; }
+    [[nodiscard]] auto sah_cost() const noexcept { return _sah_cost; }
+    [[nodiscard]] auto sah_degradation() const noexcept {
+        return _built_sah_cost > 0.0f ? _sah_cost / _built_sah_cost : 1.0f;
+    }
+};
+
+// The following build host BVHs from commands on backends whose buffer
+// handles are host addresses and whose mesh handles are the addresses of
+// their BVHs, e.g. in their CommandVisitor implementation. Mesh builds take
+// the layout and mesh format from the command, and updates return whether
+// they fell back to a rebuild.
+void build_host_mesh(BVH &bvh, const MeshBuildCommand *command, BVH::Config config = {}) noexcept;
+bool update_host_mesh(BVH &bvh, const MeshUpdateCommand *command) noexcept;
+void build_host_accel(TopLevelBVH &accel, const AccelBuildCommand *command, BVH::Config config = {}) noexcept;
+bool update_host_accel(TopLevelBVH &accel, const AccelUpdateCommand *command) noexcept;
+
+}// namespace luisa::compute
@@ -6,57 +6,163 @@
 #include <rtx/geometry.h>
 
 namespace luisa::compute {
-/*
-detail::Expr<Hit> Accel::trace_closest(detail::Expr<Ray> ray) const noexcept {
-//    auto f = FunctionBuilder::current();
-//    f->mark_raytracing();
-//    return detail::Expr<Hit>{
-//        f->call(Type::of<Hit>(), CallOp::TRACE_CLOSEST,
-//                {detail::extract_expression(_handle), ray.expression()})};
-}
-
-detail::Expr<bool> Accel::trace_any(detail::Expr<Ray> ray) const noexcept {
-//    auto f = FunctionBuilder::current();
-//    f->mark_raytracing();
-//    return detail::Expr<bool>{
-//        f->call(Type::of<bool>(), CallOp::TRACE_ANY,
-//                {detail::extract_expression(_handle), ray.expression()})};
-}
-*/
+
+detail::Expr<Hit> Geometry::trace_closest(detail::Expr<Ray> ray) const noexcept {
+    auto f = detail::FunctionBuilder::current();
+    f->mark_raytracing();
+    return detail::Expr<Hit>{
+        f->call(Type::of<Hit>(), CallOp::TRACE_CLOSEST,
+                {f->accel_binding(_handle), ray.expression()})};
+}
+
+detail::Expr<bool> Geometry::trace_any(detail::Expr<Ray> ray) const noexcept {
+    auto f = detail::FunctionBuilder::current();
+    f->mark_raytracing();
+    return detail::Expr<bool>{
+        f->call(Type::of<bool>(), CallOp::TRACE_ANY,
+                {f->accel_binding(_handle), ray.expression()})};
+}
+
+namespace detail {
+
+// ray or hit buffer of a trace command, with the member buffers for SoA
+template<size_t member_count>
+struct TraceBuffer {
+    uint64_t handle;
+    size_t offset_bytes;
+    size_t size;
+    std::array<uint64_t, member_count> members{};
+};
+
+template<size_t member_count, typename T>
+[[nodiscard]] auto trace_buffer(BufferView<T> buffer) noexcept {
+    return TraceBuffer<member_count>{buffer.handle(), buffer.offset_bytes(), buffer.size()};
+}
+
+template<size_t member_count, typename T>
+[[nodiscard]] auto trace_buffer(const SoABuffer<T> &buffer) noexcept {
+    TraceBuffer<member_count> b{AccelTraceCommand::no_buffer, 0u, buffer.size()};
+    std::copy_n(buffer.member_handles().begin(), member_count, b.members.begin());
+    return b;
+}
+
+template<typename Cmd, typename RayBuffer, typename HitBuffer>
+[[nodiscard]] auto make_trace_command(uint64_t accel, const RayBuffer &ray_buffer, const BufferView<uint32_t> *indices,
+                                      const HitBuffer &hit_buffer, const BufferView<uint> *ray_count) noexcept {
+    auto rays = trace_buffer<Cmd::ray_member_count>(ray_buffer);
+    auto hits = trace_buffer<Cmd::hit_member_count>(hit_buffer);
+    if (hits.size < rays.size) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Hit buffer ({} element(s)) is smaller than ray buffer ({} element(s)) "
+            "when tracing geometry #{}.",
+            hits.size, rays.size, accel);
+    }
+    return Cmd::create(
+        accel, rays.handle, rays.offset_bytes,
+        indices == nullptr ? Cmd::no_buffer : indices->handle(),
+        indices == nullptr ? 0u : indices->offset_bytes(),
+        hits.handle, hits.offset_bytes,
+        ray_count == nullptr ? Cmd::no_buffer : ray_count->handle(),
+        ray_count == nullptr ? 0u : ray_count->offset_bytes(),
+        indices == nullptr ? rays.size : indices->size(),
+        rays.members, hits.members);
+}
+
+}// namespace detail
+
 Command *Geometry::trace_closest(BufferView<Ray> rays, BufferView<Hit> hits) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceClosestCommand>(_handle, rays, nullptr, hits, nullptr);
 }
+
 Command *Geometry::trace_closest(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<Hit> hits) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceClosestCommand>(_handle, rays, &indices, hits, nullptr);
 }
 
 Command *Geometry::trace_closest(BufferView<Ray> rays, BufferView<Hit> hits, BufferView<uint> ray_count) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceClosestCommand>(_handle, rays, nullptr, hits, &ray_count);
 }
 
 Command *Geometry::trace_closest(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<Hit> hits, BufferView<uint> ray_count) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceClosestCommand>(_handle, rays, &indices, hits, &ray_count);
+}
+
+Command *Geometry::trace_closest(const SoABuffer<Ray> &rays, const SoABuffer<Hit> &hits) const noexcept {
+    return detail::make_trace_command<AccelTraceClosestCommand>(_handle, rays, nullptr, hits, nullptr);
+}
+
+Command *Geometry::trace_closest(const SoABuffer<Ray> &rays, BufferView<uint32_t> indices, const SoABuffer<Hit> &hits, BufferView<uint> ray_count) const noexcept {
+    return detail::make_trace_command<AccelTraceClosestCommand>(_handle, rays, &indices, hits, &ray_count);
 }
 
 Command *Geometry::trace_any(BufferView<Ray> rays, BufferView<bool> hits) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceAnyCommand>(_handle, rays, nullptr, hits, nullptr);
 }
 
 Command *Geometry::trace_any(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<bool> hits) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceAnyCommand>(_handle, rays, &indices, hits, nullptr);
 }
 
 Command *Geometry::trace_any(BufferView<Ray> rays, BufferView<bool> hits, BufferView<uint> ray_count) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceAnyCommand>(_handle, rays, nullptr, hits, &ray_count);
 }
 
 Command *Geometry::trace_any(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<bool> hits, BufferView<uint> ray_count) const noexcept {
-    return nullptr;
+    return detail::make_trace_command<AccelTraceAnyCommand>(_handle, rays, &indices, hits, &ray_count);
+}
+
+Command *Geometry::trace_any(const SoABuffer<Ray> &rays, BufferView<bool> hits) const noexcept {
+    return detail::make_trace_command<AccelTraceAnyCommand>(_handle, rays, nullptr, hits, nullptr);
+}
+
+Command *Geometry::trace_any(const SoABuffer<Ray> &rays, BufferView<uint32_t> indices, BufferView<bool> hits, BufferView<uint> ray_count) const noexcept {
+    return detail::make_trace_command<AccelTraceAnyCommand>(_handle, rays, &indices, hits, &ray_count);
+}
+
+Geometry::Geometry(const Device &device) noexcept
+    : _device{device.impl()},
+      _handle{_device->create_accel()} {}
+
+Geometry::~Geometry() noexcept {
+    for (auto mesh : _mesh_handles) { _device->destroy_mesh(mesh); }
+    _device->destroy_accel(_handle);
+}
+
+detail::Mesh Geometry::add_mesh(VertexBufferView vertices, IndexBufferView triangles, AccelLayout layout) noexcept {
+    auto index = static_cast<uint>(_meshes.size());
+    _mesh_handles.emplace_back(_device->create_mesh());
+    _mesh_built.emplace_back(false);
+    return _meshes.emplace_back(this, index, vertices, triangles, layout);
+}
+
+uint Geometry::add_instance(const detail::Mesh &mesh, float4x4 transform) noexcept {
+    auto index = static_cast<uint>(_instance_transforms.size());
+    _instance_mesh_handles.emplace_back(mesh.handle());
+    _instance_transforms.emplace_back(luisa::make_float3x4(transform));
+    _built = false;
+    return index;
+}
+
+void Geometry::set_transform(uint instance_index, float4x4 transform) noexcept {
+    if (instance_index >= _instance_transforms.size()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid instance index {} in geometry #{} with {} instance(s).",
+            instance_index, _handle, _instance_transforms.size());
+    }
+    _instance_transforms[instance_index] = luisa::make_float3x4(transform);
+    _mark_dirty();
 }
 
 Command *Geometry::update() noexcept {
+    if (!_built) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Geometry #{} is not built; building it instead of updating.",
+            _handle);
+        return build();
+    }
+    // nothing moved since the last build or update
+    if (!_dirty) { return nullptr; }
     _dirty = false;
-    return nullptr;
+    return AccelUpdateCommand::create(_handle, _instance_transforms);
 }
 
 Command *Geometry::build() noexcept {
@@ -67,10 +173,24 @@ Command *Geometry::build() noexcept {
             LUISA_WARNING_WITH_LOCATION(
                 "Mesh #{} at index {} in geometry #{} is not built; building it first.",
                 _mesh_handles[i], i, _handle);
-            // TODO...
+            auto mesh_build = _meshes[i].build();
+            if (command == nullptr) {
+                command = mesh_build;
+                tail = mesh_build;
+            } else {
+                tail = tail->set_next(mesh_build);
+            }
         }
     }
-    return nullptr;
+    auto accel_build = AccelBuildCommand::create(_handle, _instance_mesh_handles, _instance_transforms);
+    if (command == nullptr) {
+        command = accel_build;
+    } else {
+        tail->set_next(accel_build);
+    }
+    _built = true;
+    _dirty = false;
+    return command;
 }
 
 void Geometry::_mark_mesh_built(uint mesh_index) noexcept {
@@ -83,12 +203,68 @@ void Geometry::_mark_dirty() noexcept {
 
 Command *detail::Mesh::build() const noexcept {
     _geometry->_mark_mesh_built(_index);
-    return nullptr;
+    _geometry->_mark_dirty();
+    return MeshBuildCommand::create(
+        handle(),
+        _vertices.handle(), _vertices.offset_bytes(), _vertices.size(),
+        _triangles.handle(), _triangles.offset_bytes(), _triangles.size(),
+        _layout, format());
 }
 
 Command *detail::Mesh::update() const noexcept {
+    if (!_geometry->_mesh_built[_index]) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Mesh #{} is not built; building it instead of updating.",
+            handle());
+        return build();
+    }
     _geometry->_mark_dirty();
-    return nullptr;
+    return MeshUpdateCommand::create(
+        handle(),
+        _vertices.handle(), _vertices.offset_bytes(), _vertices.size(),
+        _triangles.handle(), _triangles.offset_bytes(), _triangles.size(),
+        format());
+}
+
+MeshFormat detail::Mesh::format() const noexcept {
+    MeshFormat format;
+    format.vertex = _vertices.format();
+    format.index = _triangles.format();
+    format.scale = _vertices.scale();
+    format.offset = _vertices.offset();
+    return format;
+}
+
+VertexBufferView VertexBufferView::packed(BufferView<float> vertices) noexcept {
+    if (vertices.size() % 3u != 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid packed vertex buffer with {} element(s).",
+            vertices.size());
+    }
+    return VertexBufferView{
+        vertices.handle(), vertices.offset_bytes(), vertices.size() / 3u,
+        VertexFormat::PACKED_FLOAT3, luisa::make_float3(1.0f), luisa::make_float3(0.0f)};
+}
+
+VertexBufferView VertexBufferView::unorm16(BufferView<uint16_t> vertices, float3 scale, float3 offset) noexcept {
+    if (vertices.size() % 3u != 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid quantized vertex buffer with {} element(s).",
+            vertices.size());
+    }
+    return VertexBufferView{
+        vertices.handle(), vertices.offset_bytes(), vertices.size() / 3u,
+        VertexFormat::UNORM16, scale, offset};
+}
+
+IndexBufferView::IndexBufferView(BufferView<uint16_t> indices) noexcept
+    : _handle{indices.handle()}, _offset_bytes{indices.offset_bytes()},
+      _count{indices.size() / 3u}, _format{IndexFormat::UINT16} {
+    if (indices.size() % 3u != 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid 16-bit index buffer with {} element(s).",
+            indices.size());
+    }
 }
 
 uint64_t detail::Mesh::handle() const noexcept {
@@ -6,6 +6,7 @@
 
 #include <runtime/device.h>
 #include <runtime/buffer.h>
+#include <runtime/soa_buffer.h>
 #include <rtx/ray.h>
 #include <rtx/hit.h>
 
@@ -15,6 +16,60 @@ struct Triangle {
     uint i[3];
 };
 
+// Vertex buffer of a mesh in any VertexFormat. Views of float3 convert
+// implicitly; packed and quantized vertices store 3 elements per vertex.
+class VertexBufferView {
+
+private:
+    uint64_t _handle;
+    size_t _offset_bytes;
+    size_t _count;
+    VertexFormat _format;
+    float3 _scale;
+    float3 _offset;
+
+private:
+    VertexBufferView(uint64_t handle, size_t offset_bytes, size_t count,
+                     VertexFormat format, float3 scale, float3 offset) noexcept
+        : _handle{handle}, _offset_bytes{offset_bytes}, _count{count},
+          _format{format}, _scale{scale}, _offset{offset} {}
+
+public:
+    VertexBufferView(BufferView<float3> vertices) noexcept
+        : VertexBufferView{vertices.handle(), vertices.offset_bytes(), vertices.size(),
+                           VertexFormat::FLOAT3, luisa::make_float3(1.0f), luisa::make_float3(0.0f)} {}
+    [[nodiscard]] static VertexBufferView packed(BufferView<float> vertices) noexcept;
+    // vertex q decodes to offset + q * scale, see MeshFormat::unorm16()
+    [[nodiscard]] static VertexBufferView unorm16(BufferView<uint16_t> vertices, float3 scale, float3 offset) noexcept;
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] auto offset_bytes() const noexcept { return _offset_bytes; }
+    [[nodiscard]] auto size() const noexcept { return _count; }
+    [[nodiscard]] auto format() const noexcept { return _format; }
+    [[nodiscard]] auto scale() const noexcept { return _scale; }
+    [[nodiscard]] auto offset() const noexcept { return _offset; }
+};
+
+// Index buffer of a mesh in any IndexFormat; 16-bit indices store 3
+// elements per triangle.
+class IndexBufferView {
+
+private:
+    uint64_t _handle;
+    size_t _offset_bytes;
+    size_t _count;
+    IndexFormat _format;
+
+public:
+    IndexBufferView(BufferView<Triangle> triangles) noexcept
+        : _handle{triangles.handle()}, _offset_bytes{triangles.offset_bytes()},
+          _count{triangles.size()}, _format{IndexFormat::UINT32} {}
+    IndexBufferView(BufferView<uint16_t> indices) noexcept;
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] auto offset_bytes() const noexcept { return _offset_bytes; }
+    [[nodiscard]] auto size() const noexcept { return _count; }
+    [[nodiscard]] auto format() const noexcept { return _format; }
+};
+
 class Geometry;
 
 namespace detail {
@@ -24,29 +79,36 @@ class Mesh {
 private:
     Geometry *_geometry;
     uint _index;
-    BufferView<float3> _vertices;
-    BufferView<Triangle> _triangles;
+    VertexBufferView _vertices;
+    IndexBufferView _triangles;
+    AccelLayout _layout;
 
 public:
-    Mesh(Geometry *geom, uint index, BufferView<float3> vertices, BufferView<Triangle> triangles) noexcept
-        : _geometry{geom}, _index{index}, _vertices{vertices}, _triangles{triangles} {}
+    Mesh(Geometry *geom, uint index, VertexBufferView vertices, IndexBufferView triangles, AccelLayout layout) noexcept
+        : _geometry{geom}, _index{index}, _vertices{vertices}, _triangles{triangles}, _layout{layout} {}
     [[nodiscard]] Command *build() const noexcept;
     [[nodiscard]] Command *update() const noexcept;
     [[nodiscard]] uint64_t handle() const noexcept;
     [[nodiscard]] auto vertex_buffer() const noexcept { return _vertices; }
     [[nodiscard]] auto triangle_buffer() const noexcept { return _triangles; }
+    [[nodiscard]] auto layout() const noexcept { return _layout; }
+    [[nodiscard]] MeshFormat format() const noexcept;
 };
 
 }
 
+// Two-level acceleration structure: meshes (bottom level) are instanced
+// with per-instance transforms under one top-level structure, so a mesh is
+// stored once no matter how many times it is instanced.
 class Geometry : concepts::Noncopyable {
 
 private:
     Device::Interface *_device;
     uint64_t _handle;
     std::vector<uint64_t> _mesh_handles;
+    std::vector<detail::Mesh> _meshes;
     std::vector<uint64_t> _instance_mesh_handles;
-    std::vector<float4x4> _instance_transforms;
+    std::vector<float3x4> _instance_transforms;
     std::vector<bool> _mesh_built;
     bool _built{false};
     bool _dirty{false};
@@ -57,17 +119,38 @@ private:
     void _mark_dirty() noexcept;
 
 public:
-    ~Geometry() noexcept { _device->destroy_accel(_handle); }
+    explicit Geometry(const Device &device) noexcept;
+    ~Geometry() noexcept;
     [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] detail::Mesh add_mesh(VertexBufferView vertices, IndexBufferView triangles,
+                                        AccelLayout layout = AccelLayout::FAST_TRACE) noexcept;
+    // returns the index of the new instance
+    uint add_instance(const detail::Mesh &mesh, float4x4 transform = luisa::make_float4x4(1.0f)) noexcept;
+    void set_transform(uint instance_index, float4x4 transform) noexcept;
+    [[nodiscard]] auto mesh_count() const noexcept { return _meshes.size(); }
+    [[nodiscard]] auto instance_count() const noexcept { return _instance_transforms.size(); }
+    [[nodiscard]] auto instance_transform(uint instance_index) const noexcept { return luisa::make_float4x4(_instance_transforms[instance_index]); }
     [[nodiscard]] Command *trace_closest(BufferView<Ray> rays, BufferView<Hit> hits) const noexcept;
     [[nodiscard]] Command *trace_closest(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<Hit> hits) const noexcept;
     [[nodiscard]] Command *trace_closest(BufferView<Ray> rays, BufferView<Hit> hits, BufferView<uint> ray_count) const noexcept;
     [[nodiscard]] Command *trace_closest(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<Hit> hits, BufferView<uint> ray_count) const noexcept;
+    [[nodiscard]] Command *trace_closest(const SoABuffer<Ray> &rays, const SoABuffer<Hit> &hits) const noexcept;
+    [[nodiscard]] Command *trace_closest(const SoABuffer<Ray> &rays, BufferView<uint32_t> indices, const SoABuffer<Hit> &hits, BufferView<uint> ray_count) const noexcept;
     [[nodiscard]] Command *trace_any(BufferView<Ray> rays, BufferView<bool> hits) const noexcept;
     [[nodiscard]] Command *trace_any(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<bool> hits) const noexcept;
     [[nodiscard]] Command *trace_any(BufferView<Ray> rays, BufferView<bool> hits, BufferView<uint> ray_count) const noexcept;
     [[nodiscard]] Command *trace_any(BufferView<Ray> rays, BufferView<uint32_t> indices, BufferView<bool> hits, BufferView<uint> ray_count) const noexcept;
+    [[nodiscard]] Command *trace_any(const SoABuffer<Ray> &rays, BufferView<bool> hits) const noexcept;
+    [[nodiscard]] Command *trace_any(const SoABuffer<Ray> &rays, BufferView<uint32_t> indices, BufferView<bool> hits, BufferView<uint> ray_count) const noexcept;
+    // in-kernel ray queries, capturing the geometry as a kernel binding; the
+    // geometry must be built before the kernel is dispatched
+    [[nodiscard]] detail::Expr<Hit> trace_closest(detail::Expr<Ray> ray) const noexcept;
+    [[nodiscard]] detail::Expr<bool> trace_any(detail::Expr<Ray> ray) const noexcept;
+    // refits the top level to the current instance transforms and mesh bounds;
+    // returns nullptr (which streams and command buffers skip) if no transform
+    // is set and no mesh is built or updated since the last build or update
     [[nodiscard]] Command *update() noexcept;
+    // builds the meshes that are not built yet, followed by the top level
     [[nodiscard]] Command *build() noexcept;
 };
 
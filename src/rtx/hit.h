@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <runtime/buffer.h>
+#include <runtime/soa_buffer.h>
 #include <dsl/syntax.h>
 
 namespace luisa::compute {
@@ -19,6 +21,15 @@ struct alignas(16) Hit {
 [[nodiscard]] detail::Expr<float2> interpolate(detail::Expr<Hit> hit, detail::Expr<float2> a, detail::Expr<float2> b, detail::Expr<float2> c) noexcept;
 [[nodiscard]] detail::Expr<float3> interpolate(detail::Expr<Hit> hit, detail::Expr<float3> a, detail::Expr<float3> b, detail::Expr<float3> c) noexcept;
 
-}
+}// namespace luisa::compute
 
 LUISA_STRUCT(luisa::compute::Hit, prim, inst, uv)
+
+namespace luisa::compute {
+
+// Hits stored as structure of arrays, one array per member of Hit, which
+// the closest-hit trace commands of Geometry accept in place of
+// BufferView<Hit>.
+using HitSoA = SoABuffer<Hit>;
+
+}// namespace luisa::compute
@@ -0,0 +1,68 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <rtx/intersection.h>
+
+namespace luisa::compute {
+
+detail::Expr<TriangleHit> intersect_triangle(
+    detail::Expr<Ray> ray, detail::Expr<float3> v0,
+    detail::Expr<float3> v1, detail::Expr<float3> v2) noexcept {
+    static Callable _intersect_triangle = [](Var<Ray> ray, Float3 v0, Float3 v1, Float3 v2) noexcept {
+        Var o = origin(ray);
+        Var d = direction(ray);
+        Var ad = abs(d);
+        Var kz = select(select(2u, 1u, ad.y > ad.z), select(2u, 0u, ad.x > ad.z), ad.x > ad.y);
+        Var kx = (kz + 1u) % 3u;
+        Var ky = (kx + 1u) % 3u;
+        if_(d[kz] < 0.0f, [&] {// keep the winding
+            Var k = kx;
+            kx = ky;
+            ky = k;
+        });
+        Var sx = d[kx] / d[kz];
+        Var sy = d[ky] / d[kz];
+        Var sz = 1.0f / d[kz];
+        Var a = v0 - o;
+        Var b = v1 - o;
+        Var c = v2 - o;
+        Var sax = a[kx] - sx * a[kz];
+        Var say = a[ky] - sy * a[kz];
+        Var sbx = b[kx] - sx * b[kz];
+        Var sby = b[ky] - sy * b[kz];
+        Var scx = c[kx] - sx * c[kz];
+        Var scy = c[ky] - sy * c[kz];
+        Var u = scx * sby - scy * sbx;
+        Var v = sax * scy - say * scx;
+        Var w = sbx * say - sby * sax;
+        Var det = u + v + w;
+        Var t = sz * (u * a[kz] + v * b[kz] + w * c[kz]) / det;
+        Var inside = (u >= 0.0f && v >= 0.0f && w >= 0.0f) ||
+                     (u <= 0.0f && v <= 0.0f && w <= 0.0f);
+        Var<TriangleHit> hit;
+        hit.lane = select(~0u, 0u, inside && det != 0.0f && t > ray.t_min && t < ray.t_max);
+        hit.t = t;
+        hit.u = v / det;
+        hit.v = w / det;
+        return hit;
+    };
+    return _intersect_triangle(ray, v0, v1, v2);
+}
+
+detail::Expr<float2> intersect_box(detail::Expr<Ray> ray, detail::Expr<float3> box_min, detail::Expr<float3> box_max) noexcept {
+    static Callable _intersect_box = [](Var<Ray> ray, Float3 box_min, Float3 box_max) noexcept {
+        Var o = origin(ray);
+        Var inv_d = 1.0f / direction(ray);
+        Var t0 = (box_min - o) * inv_d;
+        Var t1 = (box_max - o) * inv_d;
+        Var t_lo = min(t0, t1);
+        Var t_hi = max(t0, t1);
+        Var t_near = max(max(ray.t_min, t_lo.x), max(t_lo.y, t_lo.z));
+        Var t_far = min(min(ray.t_max, t_hi.x), min(t_hi.y, t_hi.z));
+        return make_float2(t_near, t_far * detail::slab_far_scale);
+    };
+    return _intersect_box(ray, box_min, box_max);
+}
+
+}// namespace luisa::compute
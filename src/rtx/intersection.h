@@ -0,0 +1,232 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <limits>
+#include <algorithm>
+
+#include <core/mathematics.h>
+#include <dsl/syntax.h>
+#include <rtx/ray.h>
+
+namespace luisa::compute {
+
+// triangle vertices copied in leaf order, so that leaves are intersected
+// without going through the index and vertex buffers
+struct PackedTriangle {
+    float v0[3];
+    float v1[3];
+    float v2[3];
+};
+
+// Result of ray/triangle tests. lane is the index of the hit triangle (or
+// ray) among the tested ones and ~0u for misses; u and v weigh the second
+// and third vertices, as in Hit::uv.
+struct TriangleHit {
+    uint lane;
+    float t;
+    float u;
+    float v;
+};
+
+// Ray set up for repeated tests: the reciprocal direction of the slab test
+// and the shear constants of the watertight test of Woop et al. [2013].
+struct IntersectionRay {
+    float3 origin;
+    float3 inv_direction;
+    float t_min;
+    bool negative[3];
+    uint32_t kx, ky, kz;
+    float sx, sy, sz;
+};
+
+[[nodiscard]] inline auto make_intersection_ray(float3 origin, float3 direction, float t_min) noexcept {
+    IntersectionRay ray{};
+    ray.origin = origin;
+    ray.inv_direction = 1.0f / direction;
+    ray.t_min = t_min;
+    for (auto axis = 0u; axis < 3u; axis++) { ray.negative[axis] = ray.inv_direction[axis] < 0.0f; }
+    auto d = luisa::abs(direction);
+    ray.kz = d.x > d.y ? (d.x > d.z ? 0u : 2u) : (d.y > d.z ? 1u : 2u);
+    ray.kx = (ray.kz + 1u) % 3u;
+    ray.ky = (ray.kx + 1u) % 3u;
+    if (direction[ray.kz] < 0.0f) { std::swap(ray.kx, ray.ky); }// keep the winding
+    ray.sx = direction[ray.kx] / direction[ray.kz];
+    ray.sy = direction[ray.ky] / direction[ray.kz];
+    ray.sz = 1.0f / direction[ray.kz];
+    return ray;
+}
+
+[[nodiscard]] inline auto make_intersection_ray(const Ray &ray) noexcept {
+    return make_intersection_ray(
+        luisa::make_float3(ray.origin[0], ray.origin[1], ray.origin[2]),
+        luisa::make_float3(ray.direction[0], ray.direction[1], ray.direction[2]),
+        ray.t_min);
+}
+
+namespace detail {
+
+// conservative far distances (Ize [2013]), so that rounding never culls a hit box
+static constexpr auto slab_far_scale = 1.0f + 6.0f * std::numeric_limits<float>::epsilon();
+
+// watertight test of a triangle with vertices a, b and c relative to the
+// ray origin, already permuted to (kx, ky, kz); edges through the origin are
+// decided exactly in double precision
+[[nodiscard]] inline auto watertight_triangle(
+    const IntersectionRay &ray,
+    float ax, float ay, float az,
+    float bx, float by, float bz,
+    float cx, float cy, float cz,
+    float t_max) noexcept {
+    auto sax = ax - ray.sx * az, say = ay - ray.sy * az;
+    auto sbx = bx - ray.sx * bz, sby = by - ray.sy * bz;
+    auto scx = cx - ray.sx * cz, scy = cy - ray.sy * cz;
+    auto u = scx * sby - scy * sbx;
+    auto v = sax * scy - say * scx;
+    auto w = sbx * say - sby * sax;
+    if (u == 0.0f || v == 0.0f || w == 0.0f) [[unlikely]] {
+        u = static_cast<float>(static_cast<double>(scx) * sby - static_cast<double>(scy) * sbx);
+        v = static_cast<float>(static_cast<double>(sax) * scy - static_cast<double>(say) * scx);
+        w = static_cast<float>(static_cast<double>(sbx) * say - static_cast<double>(sby) * sax);
+    }
+    auto det = u + v + w;
+    auto t = ray.sz * (u * az + v * bz + w * cz) / det;
+    auto inside = (u >= 0.0f && v >= 0.0f && w >= 0.0f) ||
+                  (u <= 0.0f && v <= 0.0f && w <= 0.0f);
+    TriangleHit hit{~0u, t, v / det, w / det};
+    if (inside && det != 0.0f && t > ray.t_min && t < t_max) { hit.lane = 0u; }
+    return hit;
+}
+
+}// namespace detail
+
+// Host tests, inlined into the traversal loops. Tests of several boxes,
+// triangles or rays run lane by lane over arrays, so that the compiler
+// vectorizes them to the width of the target.
+
+// returns the overlap [t_near, t_far] of the ray in [t_min, t_max] with the
+// box, empty (t_near > t_far) for misses; slab planes through the origin of
+// axis-parallel rays give NaN (0 * inf), which are ignored
+[[nodiscard]] inline auto intersect_box(const IntersectionRay &ray, float3 box_min, float3 box_max, float t_max) noexcept {
+    auto t_near = ray.t_min;
+    auto t_far = t_max;
+    for (auto axis = 0u; axis < 3u; axis++) {
+        auto t0 = ((ray.negative[axis] ? box_max : box_min)[axis] - ray.origin[axis]) * ray.inv_direction[axis];
+        auto t1 = ((ray.negative[axis] ? box_min : box_max)[axis] - ray.origin[axis]) * ray.inv_direction[axis];
+        t_near = std::max(t_near, t0);
+        t_far = std::min(t_far, t1);
+    }
+    return luisa::make_float2(t_near, t_far * detail::slab_far_scale);
+}
+
+// 1 ray x N boxes given by their planes; returns the mask of the overlapped
+// boxes and their near distances
+template<uint N>
+[[nodiscard]] inline auto intersect_boxes(
+    const IntersectionRay &ray,
+    const float *min_x, const float *min_y, const float *min_z,
+    const float *max_x, const float *max_y, const float *max_z,
+    float t_max, float *t_near) noexcept {
+    auto near_x = ray.negative[0] ? max_x : min_x;
+    auto near_y = ray.negative[1] ? max_y : min_y;
+    auto near_z = ray.negative[2] ? max_z : min_z;
+    auto far_x = ray.negative[0] ? min_x : max_x;
+    auto far_y = ray.negative[1] ? min_y : max_y;
+    auto far_z = ray.negative[2] ? min_z : max_z;
+    float t_far[N];
+    for (auto i = 0u; i < N; i++) {
+        auto tx0 = (near_x[i] - ray.origin.x) * ray.inv_direction.x;
+        auto ty0 = (near_y[i] - ray.origin.y) * ray.inv_direction.y;
+        auto tz0 = (near_z[i] - ray.origin.z) * ray.inv_direction.z;
+        auto tx1 = (far_x[i] - ray.origin.x) * ray.inv_direction.x;
+        auto ty1 = (far_y[i] - ray.origin.y) * ray.inv_direction.y;
+        auto tz1 = (far_z[i] - ray.origin.z) * ray.inv_direction.z;
+        t_near[i] = std::max(std::max(std::max(ray.t_min, tx0), ty0), tz0);
+        t_far[i] = std::min(std::min(std::min(t_max, tx1), ty1), tz1) * detail::slab_far_scale;
+    }
+    auto mask = 0u;
+    for (auto i = 0u; i < N; i++) { mask |= static_cast<uint32_t>(t_near[i] <= t_far[i]) << i; }
+    return mask;
+}
+
+// 1 ray x count (at most N) triangles; returns the closest hit in (t_min, t_max)
+template<uint N>
+[[nodiscard]] inline auto intersect_triangles(
+    const IntersectionRay &ray, const PackedTriangle *triangles,
+    uint count, float t_max) noexcept {
+    float ax[N], ay[N], az[N], bx[N], by[N], bz[N], cx[N], cy[N], cz[N];
+    auto o = ray.origin;
+    for (auto i = 0u; i < N; i++) {// gather, padding with the last triangle
+        auto &&t = triangles[std::min(i, count - 1u)];
+        ax[i] = t.v0[ray.kx] - o[ray.kx], ay[i] = t.v0[ray.ky] - o[ray.ky], az[i] = t.v0[ray.kz] - o[ray.kz];
+        bx[i] = t.v1[ray.kx] - o[ray.kx], by[i] = t.v1[ray.ky] - o[ray.ky], bz[i] = t.v1[ray.kz] - o[ray.kz];
+        cx[i] = t.v2[ray.kx] - o[ray.kx], cy[i] = t.v2[ray.ky] - o[ray.ky], cz[i] = t.v2[ray.kz] - o[ray.kz];
+    }
+    TriangleHit hits[N];
+    for (auto i = 0u; i < N; i++) {
+        hits[i] = detail::watertight_triangle(
+            ray, ax[i], ay[i], az[i], bx[i], by[i], bz[i], cx[i], cy[i], cz[i], t_max);
+    }
+    TriangleHit hit{~0u, t_max, 0.0f, 0.0f};
+    for (auto i = 0u; i < count; i++) {
+        if (hits[i].lane == 0u && hits[i].t < hit.t) {
+            hit = hits[i];
+            hit.lane = i;
+        }
+    }
+    return hit;
+}
+
+[[nodiscard]] inline auto intersect_triangle(const IntersectionRay &ray, const PackedTriangle &triangle, float t_max) noexcept {
+    return intersect_triangles<1u>(ray, &triangle, 1u, t_max);
+}
+
+// N rays x 1 triangle, e.g. ray packets against a leaf; writes the hit of
+// each ray in (t_min, t_max[i]) to hits[i], and returns the mask of the hits
+template<uint N>
+[[nodiscard]] inline auto intersect_rays(
+    const IntersectionRay *rays, const PackedTriangle &triangle,
+    const float *t_max, TriangleHit *hits) noexcept {
+    auto mask = 0u;
+    for (auto i = 0u; i < N; i++) {
+        auto &&ray = rays[i];
+        auto o = ray.origin;
+        auto &&t = triangle;
+        hits[i] = detail::watertight_triangle(
+            ray,
+            t.v0[ray.kx] - o[ray.kx], t.v0[ray.ky] - o[ray.ky], t.v0[ray.kz] - o[ray.kz],
+            t.v1[ray.kx] - o[ray.kx], t.v1[ray.ky] - o[ray.ky], t.v1[ray.kz] - o[ray.kz],
+            t.v2[ray.kx] - o[ray.kx], t.v2[ray.ky] - o[ray.ky], t.v2[ray.kz] - o[ray.kz],
+            t_max[i]);
+        if (hits[i].lane == 0u) {
+            hits[i].lane = i;
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+}// namespace luisa::compute
+
+LUISA_STRUCT(luisa::compute::TriangleHit, lane, t, u, v)
+
+namespace luisa::compute {
+
+// Kernel versions of the tests, with the same conventions as the host ones
+// above, so that kernels and host traversal agree on the hits. Kernels test
+// one ray at a time, as rays are already spread over threads, and leave
+// edges through the ray origin to single precision.
+[[nodiscard]] detail::Expr<TriangleHit> intersect_triangle(
+    detail::Expr<Ray> ray,
+    detail::Expr<float3> v0,
+    detail::Expr<float3> v1,
+    detail::Expr<float3> v2) noexcept;
+
+[[nodiscard]] detail::Expr<float2> intersect_box(
+    detail::Expr<Ray> ray,
+    detail::Expr<float3> box_min,
+    detail::Expr<float3> box_max) noexcept;
+
+}// namespace luisa::compute
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <runtime/buffer.h>
+#include <runtime/soa_buffer.h>
 #include <dsl/struct.h>
 #include <dsl/syntax.h>
 
@@ -51,4 +53,10 @@ void set_direction(detail::Expr<Ray> ray, detail::Expr<float3> direction) noexce
     detail::Expr<float3> ng,
     detail::Expr<float3> direction) noexcept;
 
+// Rays stored as structure of arrays, one array per member of Ray, which
+// the trace commands of Geometry accept in place of BufferView<Ray>. Kernels
+// access them like a Buffer<Ray>, e.g. rays[i].t_max, loading only the
+// members they touch, and take them as arguments as well.
+using RaySoA = SoABuffer<Ray>;
+
 }// namespace luisa::compute
@@ -0,0 +1,143 @@
+//
+// Created by Mike Smith on 2021/7/9.
+//
+
+#include <algorithms/block.h>
+#include <rtx/ray_queue.h>
+
+namespace luisa::compute {
+
+detail::Expr<uint> ray_sort_key(detail::Expr<Ray> ray, detail::Expr<float3> bounds_min, detail::Expr<float3> bounds_max) noexcept {
+    static Callable _ray_sort_key = [](Var<Ray> ray, Float3 bounds_min, Float3 bounds_max) noexcept {
+        static constexpr auto bits = ray_sort_key_bits / 6u;
+        static constexpr auto cells = static_cast<float>(1u << bits);
+        Var extent = max(bounds_max - bounds_min, 1e-6f);
+        Var o = make_uint3(clamp((origin(ray) - bounds_min) / extent * cells, 0.0f, cells - 1.0f));
+        Var d = make_uint3(clamp((normalize(direction(ray)) * 0.5f + 0.5f) * cells, 0.0f, cells - 1.0f));
+        Var key = 0u;
+        for (auto shift = bits; shift != 0u; shift--) {
+            auto bit = [shift](auto x) noexcept { return (x >> (shift - 1u)) & 1u; };
+            key = (key << 6u) |
+                  (bit(d.x) << 5u) | (bit(d.y) << 4u) | (bit(d.z) << 3u) |
+                  (bit(o.x) << 2u) | (bit(o.y) << 1u) | bit(o.z);
+        }
+        return key;
+    };
+    return _ray_sort_key(ray, bounds_min, bounds_max);
+}
+
+RayQueue::RayQueue(Device &device) noexcept
+    : RayQueue{device, Callable<bool(Ray)>{[](Var<Ray> ray) noexcept {
+                   return ray.t_min < ray.t_max;
+               }}} {}
+
+RayQueue::RayQueue(Device &device, const Callable<bool(Ray)> &active) noexcept
+    : _counter{device.create_buffer<uint>(1u)},
+      _buckets{device.create_buffer<uint>(bucket_count)} {
+
+    Kernel1D clear_kernel = [](BufferUInt buffer) noexcept {
+        buffer[dispatch_x()] = 0u;
+    };
+    _clear = device.compile(clear_kernel);
+
+    auto enqueue = [&active](const BufferVar<Ray> &rays, detail::Expr<uint> index, const BufferUInt &compacted, const BufferUInt &counter) noexcept {
+        if_(active(rays[index]), [&] {
+            compacted[counter.atomic(0u).fetch_add(1u)] = index;
+        });
+    };
+    Kernel1D compact_all_kernel = [&](BufferVar<Ray> rays, BufferUInt compacted, BufferUInt counter) noexcept {
+        enqueue(rays, dispatch_x(), compacted, counter);
+    };
+    Kernel1D compact_kernel = [&](BufferVar<Ray> rays, BufferUInt indices, BufferUInt compacted,
+                                  BufferUInt ray_count, BufferUInt counter) noexcept {
+        auto i = dispatch_x();
+        if_(i < ray_count[0u], [&] {
+            enqueue(rays, indices[i], compacted, counter);
+        });
+    };
+    Kernel1D write_count_kernel = [](BufferUInt counter, BufferUInt ray_count) noexcept {
+        ray_count[0u] = counter[0u];
+    };
+    _compact_all = device.compile(compact_all_kernel);
+    _compact = device.compile(compact_kernel);
+    _write_count = device.compile(write_count_kernel);
+
+    // counting sort over the keys: histogram, exclusive scan, scatter
+    Kernel1D count_keys_kernel = [](BufferVar<Ray> rays, BufferUInt indices, BufferUInt ray_count,
+                                    BufferUInt buckets, Float3 bounds_min, Float3 bounds_max) noexcept {
+        auto i = dispatch_x();
+        if_(i < ray_count[0u], [&] {
+            auto key = ray_sort_key(rays[indices[i]], bounds_min, bounds_max);
+            [[maybe_unused]] Var old = buckets.atomic(key).fetch_add(1u);
+        });
+    };
+    // a single block scans the buckets, each thread a contiguous run of them
+    static_assert(bucket_count % parallel_primitive_block_size == 0u);
+    Kernel1D scan_keys_kernel = [](BufferUInt buckets) noexcept {
+        static constexpr auto run = bucket_count / parallel_primitive_block_size;
+        set_block_size(parallel_primitive_block_size);
+        Shared<uint> temp{parallel_primitive_block_size};
+        Callable<uint(uint, uint)> add = [](UInt lhs, UInt rhs) noexcept { return lhs + rhs; };
+        Var first = thread_x() * run;
+        Var total = 0u;
+        for (auto key : range(run)) { total += buckets[first + key]; }
+        Var offset = detail::block_inclusive_scan(temp, total, add) - total;
+        for (auto key : range(run)) {
+            Var count = buckets[first + key];
+            buckets[first + key] = offset;
+            offset += count;
+        }
+    };
+    Kernel1D scatter_keys_kernel = [](BufferVar<Ray> rays, BufferUInt indices, BufferUInt sorted, BufferUInt ray_count,
+                                      BufferUInt buckets, Float3 bounds_min, Float3 bounds_max) noexcept {
+        auto i = dispatch_x();
+        if_(i < ray_count[0u], [&] {
+            Var index = indices[i];
+            auto key = ray_sort_key(rays[index], bounds_min, bounds_max);
+            sorted[buckets.atomic(key).fetch_add(1u)] = index;
+        });
+    };
+    _count_keys = device.compile(count_keys_kernel);
+    _scan_keys = device.compile(scan_keys_kernel);
+    _scatter_keys = device.compile(scatter_keys_kernel);
+}
+
+namespace detail {
+
+static void check_ray_queue(BufferView<Ray> rays, size_t input_size, BufferView<uint> output, BufferView<uint> ray_count) noexcept {
+    if (output.size() < input_size || ray_count.size() == 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid ray queue (rays = {}, input = {}, output = {}, count = {}).",
+            rays.size(), input_size, output.size(), ray_count.size());
+    }
+}
+
+}// namespace detail
+
+void RayQueue::compact(CommandBuffer &command_buffer, BufferView<Ray> rays,
+                       BufferView<uint> compacted, BufferView<uint> ray_count) noexcept {
+    detail::check_ray_queue(rays, rays.size(), compacted, ray_count);
+    command_buffer << _clear(_counter).dispatch(1u)
+                   << _compact_all(rays, compacted, _counter).dispatch(static_cast<uint>(rays.size()))
+                   << _write_count(_counter, ray_count).dispatch(1u);
+}
+
+void RayQueue::compact(CommandBuffer &command_buffer, BufferView<Ray> rays, BufferView<uint> indices,
+                       BufferView<uint> compacted, BufferView<uint> ray_count) noexcept {
+    detail::check_ray_queue(rays, indices.size(), compacted, ray_count);
+    command_buffer << _clear(_counter).dispatch(1u)
+                   << _compact(rays, indices, compacted, ray_count, _counter).dispatch(static_cast<uint>(indices.size()))
+                   << _write_count(_counter, ray_count).dispatch(1u);
+}
+
+void RayQueue::sort(CommandBuffer &command_buffer, BufferView<Ray> rays, BufferView<uint> indices,
+                    BufferView<uint> sorted, BufferView<uint> ray_count,
+                    float3 bounds_min, float3 bounds_max) noexcept {
+    detail::check_ray_queue(rays, indices.size(), sorted, ray_count);
+    command_buffer << _clear(_buckets).dispatch(bucket_count)
+                   << _count_keys(rays, indices, ray_count, _buckets, bounds_min, bounds_max).dispatch(static_cast<uint>(indices.size()))
+                   << _scan_keys(_buckets).dispatch(parallel_primitive_block_size)
+                   << _scatter_keys(rays, indices, sorted, ray_count, _buckets, bounds_min, bounds_max).dispatch(static_cast<uint>(indices.size()));
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,75 @@
+//
+// Created by Mike Smith on 2021/7/9.
+//
+
+#pragma once
+
+#include <runtime/device.h>
+#include <runtime/buffer.h>
+#include <runtime/shader.h>
+#include <runtime/command_buffer.h>
+#include <dsl/syntax.h>
+#include <rtx/ray.h>
+
+namespace luisa::compute {
+
+// Morton key of a ray, interleaving ray_sort_key_bits / 6 bits of each of
+// its direction and its origin (quantized over [bounds_min, bounds_max]),
+// direction first, so that rays sharing a key travel through similar parts
+// of the scene in similar directions.
+static constexpr auto ray_sort_key_bits = 12u;
+[[nodiscard]] detail::Expr<uint> ray_sort_key(
+    detail::Expr<Ray> ray,
+    detail::Expr<float3> bounds_min,
+    detail::Expr<float3> bounds_max) noexcept;
+
+// Maintains the index lists of wavefront ray queues on the device, as
+// consumed by the trace_closest/trace_any overloads of Geometry taking
+// indices and a ray count:
+// - compact() keeps the queued rays satisfying the predicate the queue is
+//   created with, and writes their number to ray_count;
+// - sort() reorders the queued rays by ray_sort_key() with a counting sort,
+//   so that coherent rays are traced together.
+// Rays keep their slots in the ray buffer, only indices move. Both passes
+// scatter indices with atomics, so the order of the rays within a bucket
+// (or among the kept rays of compact()) differs from run to run; use
+// CompactIf (see algorithms/compact.h) when a stable order is needed.
+// Input and output index lists must not alias. The queue holds scratch
+// buffers, so it must not be used by several streams at the same time.
+class RayQueue : concepts::Noncopyable {
+
+public:
+    static constexpr auto bucket_count = 1u << ray_sort_key_bits;
+
+private:
+    Buffer<uint> _counter;
+    Buffer<uint> _buckets;
+    Shader1D<Buffer<uint>> _clear;
+    Shader1D<Buffer<Ray>, Buffer<uint>, Buffer<uint>> _compact_all;
+    Shader1D<Buffer<Ray>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>> _compact;
+    Shader1D<Buffer<uint>, Buffer<uint>> _write_count;
+    Shader1D<Buffer<Ray>, Buffer<uint>, Buffer<uint>, Buffer<uint>, float3, float3> _count_keys;
+    Shader1D<Buffer<uint>> _scan_keys;
+    Shader1D<Buffer<Ray>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, float3, float3> _scatter_keys;
+
+public:
+    // by default, rays with an empty [t_min, t_max] interval are inactive
+    explicit RayQueue(Device &device) noexcept;
+    RayQueue(Device &device, const Callable<bool(Ray)> &active) noexcept;
+
+    // compacts all rays into a new queue
+    void compact(CommandBuffer &command_buffer, BufferView<Ray> rays,
+                 BufferView<uint> compacted, BufferView<uint> ray_count) noexcept;
+
+    // compacts the first ray_count rays queued in indices
+    void compact(CommandBuffer &command_buffer, BufferView<Ray> rays, BufferView<uint> indices,
+                 BufferView<uint> compacted, BufferView<uint> ray_count) noexcept;
+
+    // sorts the first ray_count rays queued in indices into sorted;
+    // origins are quantized over the bounds of the scene
+    void sort(CommandBuffer &command_buffer, BufferView<Ray> rays, BufferView<uint> indices,
+              BufferView<uint> sorted, BufferView<uint> ray_count,
+              float3 bounds_min, float3 bounds_max) noexcept;
+};
+
+}// namespace luisa::compute
@@ -0,0 +1,319 @@
+//
+// Created by Mike Smith on 2021/7/8.
+//
+
+#include <array>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+#include <core/mathematics.h>
+#include <core/thread_pool.h>
+#include <rtx/traversal.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+static constexpr auto lane_count = WideBVHNode::width;
+static constexpr auto invalid_index = ~0u;
+
+// returns the mask of lanes whose bounds overlap the ray in [t_min, t_max]
+[[nodiscard]] auto intersect_lanes(const WideBVHNode &node, const IntersectionRay &ray, float t_max, float *t_near) noexcept {
+    return intersect_boxes<lane_count>(
+        ray, node.min_x, node.min_y, node.min_z,
+        node.max_x, node.max_y, node.max_z, t_max, t_near);
+}
+
+// dequantizes the lanes of a compressed node for the same slab test, masking out empty lanes
+[[nodiscard]] auto intersect_lanes(const CompressedBVHNode &node, const IntersectionRay &ray, float t_max, float *t_near) noexcept {
+    static constexpr auto width = CompressedBVHNode::width;
+    auto sx = CompressedBVHNode::scale(node.exponent[0]);
+    auto sy = CompressedBVHNode::scale(node.exponent[1]);
+    auto sz = CompressedBVHNode::scale(node.exponent[2]);
+    float min_x[width], min_y[width], min_z[width];
+    float max_x[width], max_y[width], max_z[width];
+    for (auto i = 0u; i < width; i++) {
+        min_x[i] = node.origin[0] + static_cast<float>(node.lo_x[i]) * sx;
+        min_y[i] = node.origin[1] + static_cast<float>(node.lo_y[i]) * sy;
+        min_z[i] = node.origin[2] + static_cast<float>(node.lo_z[i]) * sz;
+        max_x[i] = node.origin[0] + static_cast<float>(node.hi_x[i]) * sx;
+        max_y[i] = node.origin[1] + static_cast<float>(node.hi_y[i]) * sy;
+        max_z[i] = node.origin[2] + static_cast<float>(node.hi_z[i]) * sz;
+    }
+    auto mask = intersect_boxes<width>(ray, min_x, min_y, min_z, max_x, max_y, max_z, t_max, t_near);
+    for (auto i = 0u; i < width; i++) {
+        if (node.meta[i] == 0u) { mask &= ~(1u << i); }
+    }
+    return mask;
+}
+
+struct StackEntry {
+    uint32_t index;
+    uint32_t count;// 0 for wide nodes, otherwise a leaf
+    float t;
+};
+
+// Traversal stack in a fixed-size array on the stack of the calling thread,
+// spilling to the heap only for degenerate trees too deep for the array.
+class TraversalStack {
+
+public:
+    static constexpr auto capacity = 256u;
+
+private:
+    std::array<StackEntry, capacity> _entries;// intentionally left uninitialized
+    uint32_t _size{0u};
+    std::vector<StackEntry> _spilled;
+
+public:
+    [[nodiscard]] auto empty() const noexcept { return _size == 0u; }
+    void push(StackEntry entry) noexcept {
+        if (_size < capacity) [[likely]] {
+            _entries[_size++] = entry;
+        } else {
+            _spilled.emplace_back(entry);
+        }
+    }
+    [[nodiscard]] auto pop() noexcept {
+        if (!_spilled.empty()) [[unlikely]] {
+            auto entry = _spilled.back();
+            _spilled.pop_back();
+            return entry;
+        }
+        return _entries[--_size];
+    }
+};
+
+// pushes the overlapped lanes, insertion-sorted by distance, the nearest last
+template<size_t width>
+void push_sorted(StackEntry (&lanes)[width], uint32_t count, TraversalStack &stack) noexcept {
+    for (auto i = 1u; i < count; i++) {
+        auto entry = lanes[i];
+        auto j = i;
+        for (; j > 0u && lanes[j - 1u].t < entry.t; j--) { lanes[j] = lanes[j - 1u]; }
+        lanes[j] = entry;
+    }
+    for (auto i = 0u; i < count; i++) { stack.push(lanes[i]); }
+}
+
+void push_lanes(const WideBVHNode &node, const IntersectionRay &ray, float t_max, TraversalStack &stack) noexcept {
+    float t_near[lane_count];
+    auto mask = intersect_lanes(node, ray, t_max, t_near);
+    StackEntry lanes[lane_count];
+    auto count = 0u;
+    for (auto i = 0u; i < lane_count; i++) {
+        if (mask & (1u << i)) { lanes[count++] = StackEntry{node.index[i], node.count[i], t_near[i]}; }
+    }
+    push_sorted(lanes, count, stack);
+}
+
+void push_lanes(const CompressedBVHNode &node, const IntersectionRay &ray, float t_max, TraversalStack &stack) noexcept {
+    float t_near[CompressedBVHNode::width];
+    auto mask = intersect_lanes(node, ray, t_max, t_near);
+    StackEntry lanes[CompressedBVHNode::width];
+    auto count = 0u;
+    auto primitive_offset = node.primitive_base;
+    for (auto i = 0u; i < CompressedBVHNode::width; i++) {
+        auto m = node.meta[i];
+        auto interior = (m & CompressedBVHNode::interior_flag) != 0u;
+        if (mask & (1u << i)) {
+            lanes[count++] = interior ?
+                                 StackEntry{node.child_base + (m & ~CompressedBVHNode::interior_flag), 0u, t_near[i]} :
+                                 StackEntry{primitive_offset, m, t_near[i]};
+        }
+        if (!interior) { primitive_offset += m; }
+    }
+    push_sorted(lanes, count, stack);
+}
+
+template<bool any>
+[[nodiscard]] bool traverse_mesh(const BVH &mesh, const IntersectionRay &ray, float &t_max, Hit &hit) noexcept {
+    if (mesh.empty()) { return false; }
+    TraversalStack stack;
+    stack.push(StackEntry{0u, 0u, ray.t_min});
+    auto compact = mesh.config().layout == AccelLayout::COMPACT;
+    auto wide_nodes = mesh.wide_nodes();
+    auto compressed_nodes = mesh.compressed_nodes();
+    auto packed_triangles = mesh.packed_triangles();
+    auto found = false;
+    while (!stack.empty()) {
+        auto entry = stack.pop();
+        if (entry.t > t_max) { continue; }
+        if (entry.count == 0u) {
+            if (compact) {
+                push_lanes(compressed_nodes[entry.index], ray, t_max, stack);
+            } else {
+                push_lanes(wide_nodes[entry.index], ray, t_max, stack);
+            }
+            continue;
+        }
+        for (auto first = entry.index; first < entry.index + entry.count; first += lane_count) {
+            auto count = std::min(entry.index + entry.count - first, lane_count);
+            auto triangles = packed_triangles.data() + first;
+            PackedTriangle gathered[lane_count];
+            if (compact) {// fetch and decode through the index buffer
+                auto &&m = mesh.mesh();
+                for (auto i = 0u; i < count; i++) {
+                    auto t = m.triangle(mesh.primitives()[first + i]);
+                    auto v0 = m.vertex(t.i[0]);
+                    auto v1 = m.vertex(t.i[1]);
+                    auto v2 = m.vertex(t.i[2]);
+                    for (auto axis = 0u; axis < 3u; axis++) {
+                        gathered[i].v0[axis] = v0[axis];
+                        gathered[i].v1[axis] = v1[axis];
+                        gathered[i].v2[axis] = v2[axis];
+                    }
+                }
+                triangles = gathered;
+            }
+            if (auto h = intersect_triangles<lane_count>(ray, triangles, count, t_max); h.lane != invalid_index) {
+                t_max = h.t;
+                hit.prim = mesh.primitives()[first + h.lane];
+                hit.uv = luisa::make_float2(h.u, h.v);
+                found = true;
+                if constexpr (any) { return true; }
+            }
+        }
+    }
+    return found;
+}
+
+template<bool any>
+[[nodiscard]] bool traverse(const TopLevelBVH &accel, const Ray &r, Hit &hit) noexcept {
+    if (accel.empty()) { return false; }
+    auto origin = luisa::make_float3(r.origin[0], r.origin[1], r.origin[2]);
+    auto direction = luisa::make_float3(r.direction[0], r.direction[1], r.direction[2]);
+    auto ray = make_intersection_ray(origin, direction, r.t_min);
+    auto t_max = r.t_max;
+    TraversalStack stack;
+    stack.push(StackEntry{0u, 0u, r.t_min});
+    auto wide_nodes = accel.wide_nodes();
+    auto found = false;
+    while (!stack.empty()) {
+        auto entry = stack.pop();
+        if (entry.t > t_max) { continue; }
+        if (entry.count == 0u) {
+            push_lanes(wide_nodes[entry.index], ray, t_max, stack);
+            continue;
+        }
+        for (auto i = entry.index; i < entry.index + entry.count; i++) {
+            auto instance_index = accel.primitives()[i];
+            auto &&instance = accel.instances()[instance_index];
+            if (instance.mesh == nullptr) { continue; }
+            auto &&m = instance.inverse_transform;
+            auto object_ray = make_intersection_ray(
+                luisa::make_float3(m * luisa::make_float4(origin, 1.0f)),
+                luisa::make_float3(m * luisa::make_float4(direction, 0.0f)),
+                r.t_min);
+            if (traverse_mesh<any>(*instance.mesh, object_ray, t_max, hit)) {
+                hit.inst = instance_index;
+                found = true;
+                if constexpr (any) { return true; }
+            }
+        }
+    }
+    return found;
+}
+
+[[nodiscard]] auto miss_hit() noexcept {
+    Hit hit;
+    hit.prim = invalid_index;
+    hit.inst = invalid_index;
+    hit.uv = luisa::make_float2(0.0f);
+    return hit;
+}
+
+template<typename F>
+void trace_host(const AccelTraceCommand *command, F &&trace) noexcept {
+    auto rays = reinterpret_cast<const Ray *>(command->ray_buffer() + command->ray_buffer_offset());
+    auto &&members = command->ray_members();
+    auto origins = reinterpret_cast<const std::array<float, 3u> *>(members[0]);
+    auto t_mins = reinterpret_cast<const float *>(members[1]);
+    auto directions = reinterpret_cast<const std::array<float, 3u> *>(members[2]);
+    auto t_maxs = reinterpret_cast<const float *>(members[3]);
+    auto load_ray = [&](size_t i) noexcept {
+        if (!command->has_soa_rays()) { return rays[i]; }
+        Ray ray{};
+        std::copy_n(origins[i].cbegin(), 3u, ray.origin);
+        ray.t_min = t_mins[i];
+        std::copy_n(directions[i].cbegin(), 3u, ray.direction);
+        ray.t_max = t_maxs[i];
+        return ray;
+    };
+    auto indices = command->has_index_buffer() ?
+                       reinterpret_cast<const uint32_t *>(command->index_buffer() + command->index_buffer_offset()) :
+                       nullptr;
+    auto ray_count = command->max_ray_count();
+    if (command->has_ray_count_buffer()) {
+        auto queue_size = *reinterpret_cast<const uint *>(command->ray_count_buffer() + command->ray_count_buffer_offset());
+        ray_count = std::min(ray_count, static_cast<size_t>(queue_size));
+    }
+    ThreadPool::global().parallel_for(ray_count, [&](size_t i) noexcept {
+        auto ray_index = indices == nullptr ? i : indices[i];
+        trace(ray_index, load_ray(ray_index));
+    }, 64u);
+}
+
+}// namespace detail
+
+Hit trace_closest(const TopLevelBVH &accel, const Ray &ray) noexcept {
+    auto hit = detail::miss_hit();
+    static_cast<void>(detail::traverse<false>(accel, ray, hit));
+    return hit;
+}
+
+bool trace_any(const TopLevelBVH &accel, const Ray &ray) noexcept {
+    auto hit = detail::miss_hit();
+    return detail::traverse<true>(accel, ray, hit);
+}
+
+Hit trace_closest(const BVH &mesh, const Ray &ray) noexcept {
+    auto hit = detail::miss_hit();
+    auto t_max = ray.t_max;
+    auto traversal_ray = make_intersection_ray(
+        luisa::make_float3(ray.origin[0], ray.origin[1], ray.origin[2]),
+        luisa::make_float3(ray.direction[0], ray.direction[1], ray.direction[2]),
+        ray.t_min);
+    if (detail::traverse_mesh<false>(mesh, traversal_ray, t_max, hit)) { hit.inst = 0u; }
+    return hit;
+}
+
+bool trace_any(const BVH &mesh, const Ray &ray) noexcept {
+    auto hit = detail::miss_hit();
+    auto t_max = ray.t_max;
+    auto traversal_ray = make_intersection_ray(
+        luisa::make_float3(ray.origin[0], ray.origin[1], ray.origin[2]),
+        luisa::make_float3(ray.direction[0], ray.direction[1], ray.direction[2]),
+        ray.t_min);
+    return detail::traverse_mesh<true>(mesh, traversal_ray, t_max, hit);
+}
+
+void trace_host_closest(const TopLevelBVH &accel, const AccelTraceClosestCommand *command) noexcept {
+    auto hits = reinterpret_cast<Hit *>(command->hit_buffer() + command->hit_buffer_offset());
+    if (command->has_soa_hits()) {
+        auto &&members = command->hit_members();
+        auto prims = reinterpret_cast<uint *>(members[0]);
+        auto insts = reinterpret_cast<uint *>(members[1]);
+        auto uvs = reinterpret_cast<float2 *>(members[2]);
+        detail::trace_host(command, [&](size_t index, const Ray &ray) noexcept {
+            auto hit = trace_closest(accel, ray);
+            prims[index] = hit.prim;
+            insts[index] = hit.inst;
+            uvs[index] = hit.uv;
+        });
+        return;
+    }
+    detail::trace_host(command, [&](size_t index, const Ray &ray) noexcept {
+        hits[index] = trace_closest(accel, ray);
+    });
+}
+
+void trace_host_any(const TopLevelBVH &accel, const AccelTraceAnyCommand *command) noexcept {
+    auto hits = reinterpret_cast<bool *>(command->hit_buffer() + command->hit_buffer_offset());
+    detail::trace_host(command, [&](size_t index, const Ray &ray) noexcept {
+        hits[index] = trace_any(accel, ray);
+    });
+}
+
+}// namespace luisa::compute
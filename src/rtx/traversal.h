@@ -0,0 +1,41 @@
+//
+// Created by Mike Smith on 2021/7/8.
+//
+
+#pragma once
+
+#include <rtx/ray.h>
+#include <rtx/hit.h>
+#include <rtx/bvh.h>
+
+namespace luisa::compute {
+
+// Host ray traversal over the wide BVH nodes of either layout. A ray is
+// tested against all lanes of a node at once, and leaves are intersected
+// WideBVHNode::width triangles at a time with the watertight test of Woop
+// et al. [2013], so rays through shared edges and vertices never slip
+// between triangles.
+// Misses have Hit::prim (and Hit::inst) set to ~0u.
+[[nodiscard]] Hit trace_closest(const TopLevelBVH &accel, const Ray &ray) noexcept;
+[[nodiscard]] bool trace_any(const TopLevelBVH &accel, const Ray &ray) noexcept;
+[[nodiscard]] Hit trace_closest(const BVH &mesh, const Ray &ray) noexcept;
+[[nodiscard]] bool trace_any(const BVH &mesh, const Ray &ray) noexcept;
+
+// The following execute the trace commands over their ray queues in
+// parallel, on backends whose buffer handles are host addresses, e.g. in
+// their CommandVisitor implementation.
+void trace_host_closest(const TopLevelBVH &accel, const AccelTraceClosestCommand *command) noexcept;
+void trace_host_any(const TopLevelBVH &accel, const AccelTraceAnyCommand *command) noexcept;
+
+// In-kernel ray queries (CallOp::TRACE_CLOSEST and CallOp::TRACE_ANY) of
+// kernels running on the host, on backends whose accel handles are the
+// addresses of their top levels: the accel arguments of the dispatch are
+// passed as is, and the BVH is traversed inline by the calling thread.
+[[nodiscard]] inline Hit trace_closest(uint64_t accel, const Ray &ray) noexcept {
+    return trace_closest(*reinterpret_cast<const TopLevelBVH *>(accel), ray);
+}
+[[nodiscard]] inline bool trace_any(uint64_t accel, const Ray &ray) noexcept {
+    return trace_any(*reinterpret_cast<const TopLevelBVH *>(accel), ray);
+}
+
+}// namespace luisa::compute
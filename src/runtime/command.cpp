@@ -2,6 +2,8 @@
 // Created by Mike Smith on 2021/3/3.
 //
 
+#include <string_view>
+
 #include <core/logging.h>
 #include <runtime/command.h>
 
@@ -11,6 +13,17 @@ std::span<const Command::Resource> Command::resources() const noexcept {
     return {_resource_slots.data(), _resource_count};
 }
 
+[[nodiscard]] static constexpr std::string_view resource_tag_name(Command::Resource::Tag tag) noexcept {
+    switch (tag) {
+        case Command::Resource::Tag::BUFFER: return "buffer";
+        case Command::Resource::Tag::TEXTURE: return "image";
+        case Command::Resource::Tag::MESH: return "mesh";
+        case Command::Resource::Tag::ACCEL: return "accel";
+        default: break;
+    }
+    return "unknown";
+}
+
 inline void Command::_use_resource(
     uint64_t handle, Command::Resource::Tag tag,
     Usage usage) noexcept {
@@ -27,7 +40,7 @@ inline void Command::_use_resource(
                     })) [[unlikely]] {
         LUISA_ERROR_WITH_LOCATION(
             "Aliasing in {} resource with handle {}.",
-            tag == Resource::Tag::BUFFER ? "buffer" : "image",
+            resource_tag_name(tag),
             handle);
     }
     _resource_slots[_resource_count++] = {handle, tag, usage};
@@ -45,6 +58,29 @@ void Command::_buffer_read_write(uint64_t handle) noexcept {
     _use_resource(handle, Resource::Tag::BUFFER, Usage::READ_WRITE);
 }
 
+void Command::_replace_resource(uint64_t old_handle, uint64_t new_handle, Resource::Tag tag) noexcept {
+    if (old_handle == new_handle) { return; }
+    auto begin = _resource_slots.begin();
+    auto end = _resource_slots.begin() + _resource_count;
+    if (std::any_of(begin, end, [new_handle, tag](auto b) noexcept {
+            return b.tag == tag && b.handle == new_handle;
+        })) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Aliasing in {} resource with handle {}.",
+            resource_tag_name(tag),
+            new_handle);
+    }
+    auto iter = std::find_if(begin, end, [old_handle, tag](auto b) noexcept {
+        return b.tag == tag && b.handle == old_handle;
+    });
+    if (iter == end) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Resource with handle {} is not used by the command.",
+            old_handle);
+    }
+    iter->handle = new_handle;
+}
+
 void Command::_texture_read_only(uint64_t handle) noexcept {
     _use_resource(handle, Resource::Tag::TEXTURE, Usage::READ);
 }
@@ -135,6 +171,16 @@ ShaderDispatchCommand::ShaderDispatchCommand(uint64_t handle, Function kernel) n
     : _handle{handle},
       _kernel{kernel} {}
 
+ShaderDispatchCommand::ShaderDispatchCommand(const ShaderDispatchCommand *prototype) noexcept
+    : Command{prototype->resources()},
+      _handle{prototype->_handle},
+      _kernel{prototype->_kernel},
+      _argument_buffer_size{prototype->_argument_buffer_size},
+      _dispatch_size{prototype->_dispatch_size[0], prototype->_dispatch_size[1], prototype->_dispatch_size[2]},
+      _argument_count{prototype->_argument_count} {
+    std::memcpy(_argument_buffer.data(), prototype->_argument_buffer.data(), _argument_buffer_size);
+}
+
 void ShaderDispatchCommand::encode_texture_heap(uint32_t variable_uid, uint64_t handle) noexcept {
     if (_argument_buffer_size + sizeof(TextureHeapArgument) > _argument_buffer.size()) [[unlikely]] {
         LUISA_ERROR_WITH_LOCATION(
@@ -151,6 +197,85 @@ void ShaderDispatchCommand::encode_texture_heap(uint32_t variable_uid, uint64_t
     _argument_count++;
 }
 
+void ShaderDispatchCommand::encode_accel(uint32_t variable_uid, uint64_t handle) noexcept {
+    if (_argument_buffer_size + sizeof(AccelArgument) > _argument_buffer.size()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to encode accel. "
+            "Shader argument buffer exceeded size limit {}.",
+            _argument_buffer.size());
+    }
+    AccelArgument argument{variable_uid, handle};
+    std::memcpy(
+        _argument_buffer.data() + _argument_buffer_size,
+        &argument, sizeof(AccelArgument));
+    _use_resource(handle, Resource::Tag::ACCEL, Usage::READ);
+    _argument_buffer_size += sizeof(AccelArgument);
+    _argument_count++;
+}
+
+std::byte *ShaderDispatchCommand::_argument(uint32_t variable_uid, Argument::Tag tag) noexcept {
+    auto p = _argument_buffer.data();
+    while (p < _argument_buffer.data() + _argument_buffer_size) {
+        Argument argument{};
+        std::memcpy(&argument, p, sizeof(Argument));
+        if (argument.variable_uid == variable_uid) {
+            if (argument.tag != tag) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Argument with variable uid {} has a different kind.",
+                    variable_uid);
+            }
+            return p;
+        }
+        switch (argument.tag) {
+            case Argument::Tag::BUFFER: p += sizeof(BufferArgument); break;
+            case Argument::Tag::TEXTURE: p += sizeof(TextureArgument); break;
+            case Argument::Tag::TEXTURE_HEAP: p += sizeof(TextureHeapArgument); break;
+            case Argument::Tag::ACCEL: p += sizeof(AccelArgument); break;
+            case Argument::Tag::UNIFORM: {
+                UniformArgument uniform_argument{};
+                std::memcpy(&uniform_argument, p, sizeof(UniformArgument));
+                p += sizeof(UniformArgument) + uniform_argument.size;
+                break;
+            }
+            default: LUISA_ERROR_WITH_LOCATION("Invalid argument.");
+        }
+    }
+    LUISA_ERROR_WITH_LOCATION(
+        "Argument with variable uid {} is not encoded in the command.",
+        variable_uid);
+}
+
+void ShaderDispatchCommand::update_buffer(uint32_t variable_uid, uint64_t handle, size_t offset) noexcept {
+    auto p = _argument(variable_uid, Argument::Tag::BUFFER);
+    BufferArgument argument{};
+    std::memcpy(&argument, p, sizeof(BufferArgument));
+    _replace_resource(argument.handle, handle, Resource::Tag::BUFFER);
+    argument.handle = handle;
+    argument.offset = offset;
+    std::memcpy(p, &argument, sizeof(BufferArgument));
+}
+
+void ShaderDispatchCommand::update_texture(uint32_t variable_uid, uint64_t handle) noexcept {
+    auto p = _argument(variable_uid, Argument::Tag::TEXTURE);
+    TextureArgument argument{};
+    std::memcpy(&argument, p, sizeof(TextureArgument));
+    _replace_resource(argument.handle, handle, Resource::Tag::TEXTURE);
+    argument.handle = handle;
+    std::memcpy(p, &argument, sizeof(TextureArgument));
+}
+
+void ShaderDispatchCommand::update_uniform(uint32_t variable_uid, const void *data, size_t size) noexcept {
+    auto p = _argument(variable_uid, Argument::Tag::UNIFORM);
+    UniformArgument argument{};
+    std::memcpy(&argument, p, sizeof(UniformArgument));
+    if (argument.size != size) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Uniform size mismatch (expected {}, got {}).",
+            argument.size, size);
+    }
+    std::memcpy(p + sizeof(UniformArgument), data, size);
+}
+
 namespace detail {
 
 #define LUISA_MAKE_COMMAND_POOL_IMPL(Cmd)       \
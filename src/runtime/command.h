@@ -11,6 +11,7 @@
 #include <vector>
 #include <array>
 #include <span>
+#include <algorithm>
 
 #include <core/clock.h>
 #include <core/logging.h>
@@ -61,7 +62,8 @@ LUISA_MAP(LUISA_MAKE_COMMAND_POOL_DECL, LUISA_ALL_COMMANDS)
 
 }// namespace detail
 
-#define LUISA_MAKE_COMMAND_COMMON(Cmd)                                           \
+#if LUISA_LOG_COMPILE_LEVEL <= LUISA_LOG_LEVEL_VERBOSE
+#define LUISA_MAKE_COMMAND_CREATE(Cmd)                                           \
     template<typename... Args>                                                   \
     [[nodiscard]] static auto create(Args &&...args) noexcept {                  \
         Clock clock;                                                             \
@@ -69,10 +71,20 @@ LUISA_MAP(LUISA_MAKE_COMMAND_POOL_DECL, LUISA_ALL_COMMANDS)
         LUISA_VERBOSE_WITH_LOCATION(                                             \
             "Created {} in {} ms.", #Cmd, clock.toc());                          \
         return command;                                                          \
-    }                                                                            \
-    void accept(CommandVisitor &visitor) const noexcept override {               \
-        visitor.visit(this);                                                     \
-    }                                                                            \
+    }
+#else
+#define LUISA_MAKE_COMMAND_CREATE(Cmd)                                  \
+    template<typename... Args>                                          \
+    [[nodiscard]] static auto create(Args &&...args) noexcept {         \
+        return detail::pool_##Cmd().create(std::forward<Args>(args)...); \
+    }
+#endif
+
+#define LUISA_MAKE_COMMAND_COMMON(Cmd)                             \
+    LUISA_MAKE_COMMAND_CREATE(Cmd)                                 \
+    void accept(CommandVisitor &visitor) const noexcept override { \
+        visitor.visit(this);                                       \
+    }                                                              \
     void recycle() noexcept override { detail::pool_##Cmd().recycle(this); }
 
 class Command {
@@ -85,9 +97,14 @@ public:
         enum struct Tag : uint32_t {
             NONE,
             BUFFER,
-            TEXTURE
+            TEXTURE,
+            MESH,
+            ACCEL
         };
 
+        // stands for all resources with the tag, e.g. the meshes an accel is built from
+        static constexpr auto any_handle = ~0ull;
+
         uint64_t handle{0u};
         Tag tag{Tag::NONE};
         Usage usage{Usage::NONE};
@@ -110,8 +127,20 @@ protected:
     void _texture_read_only(uint64_t handle) noexcept;
     void _texture_write_only(uint64_t handle) noexcept;
     void _texture_read_write(uint64_t handle) noexcept;
+    void _replace_resource(uint64_t old_handle, uint64_t new_handle, Resource::Tag tag) noexcept;
 
 protected:
+    Command() noexcept = default;
+    // starts with pre-validated resources, e.g. from a shader's dispatch prototype
+    explicit Command(std::span<const Resource> resources) noexcept
+        : _resource_count{resources.size()} {
+        std::copy(resources.begin(), resources.end(), _resource_slots.begin());
+    }
+    // copies do not inherit the link to the next command
+    Command(const Command &another) noexcept
+        : _resource_slots{another._resource_slots},
+          _resource_count{another._resource_count} {}
+    Command &operator=(const Command &) noexcept = delete;
     ~Command() noexcept = default;
 
 public:
@@ -373,7 +402,8 @@ public:
             BUFFER,
             TEXTURE,
             UNIFORM,
-            TEXTURE_HEAP
+            TEXTURE_HEAP,
+            ACCEL
         };
 
         Tag tag;
@@ -420,6 +450,14 @@ public:
               handle{handle} {}
     };
 
+    struct AccelArgument : Argument {
+        uint64_t handle{};
+        AccelArgument() noexcept : Argument{Tag::ACCEL, 0u} {}
+        AccelArgument(uint32_t vid, uint64_t handle) noexcept
+            : Argument{Tag::ACCEL, vid},
+              handle{handle} {}
+    };
+
     struct ArgumentBuffer : std::array<std::byte, 2048u> {};
 
 private:
@@ -428,10 +466,17 @@ private:
     size_t _argument_buffer_size{0u};
     uint _dispatch_size[3]{};
     uint32_t _argument_count{0u};
-    ArgumentBuffer _argument_buffer{};
+    // only the first _argument_buffer_size bytes are meaningful, so the
+    // buffer is intentionally left uninitialized
+    ArgumentBuffer _argument_buffer;
+
+private:
+    [[nodiscard]] std::byte *_argument(uint32_t variable_uid, Argument::Tag tag) noexcept;
 
 public:
     explicit ShaderDispatchCommand(uint64_t handle, Function kernel) noexcept;
+    // copies the encoded arguments and resources of a prototype (see runtime/shader.h)
+    explicit ShaderDispatchCommand(const ShaderDispatchCommand *prototype) noexcept;
     void set_dispatch_size(uint3 launch_size) noexcept;
     [[nodiscard]] auto handle() const noexcept { return _handle; }
     [[nodiscard]] auto kernel() const noexcept { return _kernel; }
@@ -442,11 +487,18 @@ public:
     //   1. captured buffers
     //   2. captured textures
     //   3. captured texture heaps
-    //   4. arguments
+    //   4. captured accels
+    //   5. arguments
     void encode_buffer(uint32_t variable_uid, uint64_t handle, size_t offset, Usage usage) noexcept;
     void encode_texture(uint32_t variable_uid, uint64_t handle, Usage usage) noexcept;
     void encode_uniform(uint32_t variable_uid, const void *data, size_t size, size_t alignment) noexcept;
     void encode_texture_heap(uint32_t variable_uid, uint64_t handle) noexcept;
+    void encode_accel(uint32_t variable_uid, uint64_t handle) noexcept;
+
+    // in-place patching of encoded arguments, e.g. for replaying command graphs
+    void update_buffer(uint32_t variable_uid, uint64_t handle, size_t offset) noexcept;
+    void update_texture(uint32_t variable_uid, uint64_t handle) noexcept;
+    void update_uniform(uint32_t variable_uid, const void *data, size_t size) noexcept;
 
     template<typename Visit>
     void decode(Visit &&visit) const noexcept {
@@ -485,6 +537,13 @@ public:
                     p += sizeof(TextureHeapArgument);
                     break;
                 }
+                case Argument::Tag::ACCEL: {
+                    AccelArgument arg;
+                    std::memcpy(&arg, p, sizeof(AccelArgument));
+                    visit(argument.variable_uid, arg);
+                    p += sizeof(AccelArgument);
+                    break;
+                }
                 default: {
                     LUISA_ERROR_WITH_LOCATION("Invalid argument.");
                     break;
@@ -495,44 +554,318 @@ public:
     LUISA_MAKE_COMMAND_COMMON(ShaderDispatchCommand)
 };
 
+// trade-off between trace performance and memory of mesh acceleration structures
+enum struct AccelLayout : uint8_t {
+    FAST_TRACE,// full-precision nodes, geometry copied in traversal order
+    COMPACT    // quantized nodes referencing the mesh buffers
+};
+
+enum struct VertexFormat : uint8_t {
+    FLOAT3,       // float3, 16 bytes per vertex
+    PACKED_FLOAT3,// 3 floats, 12 bytes per vertex
+    UNORM16       // 3 uint16_t q, 6 bytes per vertex, decoded to offset + q * scale
+};
+
+enum struct IndexFormat : uint8_t {
+    UINT32,// Triangle, 12 bytes per triangle
+    UINT16 // 3 uint16_t, 6 bytes per triangle
+};
+
+// storage of the vertex and index buffers of a mesh
+struct MeshFormat {
+    VertexFormat vertex{VertexFormat::FLOAT3};
+    IndexFormat index{IndexFormat::UINT32};
+    float3 scale{1.0f};// VertexFormat::UNORM16 only
+    float3 offset{0.0f};
+
+    // UNORM16 quantization covering [bounds_min, bounds_max] evenly
+    [[nodiscard]] static auto unorm16(float3 bounds_min, float3 bounds_max) noexcept {
+        MeshFormat format;
+        format.vertex = VertexFormat::UNORM16;
+        format.scale = (bounds_max - bounds_min) / 65535.0f;
+        format.offset = bounds_min;
+        return format;
+    }
+    [[nodiscard]] auto vertex_stride() const noexcept {
+        switch (vertex) {
+            case VertexFormat::FLOAT3: return sizeof(float3);
+            case VertexFormat::PACKED_FLOAT3: return sizeof(float) * 3u;
+            case VertexFormat::UNORM16: return sizeof(uint16_t) * 3u;
+        }
+        return sizeof(float3);
+    }
+    [[nodiscard]] auto triangle_stride() const noexcept {
+        return index == IndexFormat::UINT16 ? sizeof(uint16_t) * 3u : sizeof(uint32_t) * 3u;
+    }
+};
+
 class MeshBuildCommand : public Command {
 
 private:
+    uint64_t _handle;
+    uint64_t _vertex_buffer_handle;
+    size_t _vertex_buffer_offset;
+    size_t _vertex_count;
+    uint64_t _triangle_buffer_handle;
+    size_t _triangle_buffer_offset;
+    size_t _triangle_count;
+    AccelLayout _layout;
+    MeshFormat _format;
+
 public:
+    MeshBuildCommand(uint64_t handle,
+                     uint64_t vertex_buffer, size_t vertex_buffer_offset, size_t vertex_count,
+                     uint64_t triangle_buffer, size_t triangle_buffer_offset, size_t triangle_count,
+                     AccelLayout layout = AccelLayout::FAST_TRACE, MeshFormat format = {}) noexcept
+        : _handle{handle},
+          _vertex_buffer_handle{vertex_buffer},
+          _vertex_buffer_offset{vertex_buffer_offset},
+          _vertex_count{vertex_count},
+          _triangle_buffer_handle{triangle_buffer},
+          _triangle_buffer_offset{triangle_buffer_offset},
+          _triangle_count{triangle_count},
+          _layout{layout},
+          _format{format} {
+        _use_resource(_handle, Resource::Tag::MESH, Usage::WRITE);
+        _buffer_read_only(_vertex_buffer_handle);
+        _buffer_read_only(_triangle_buffer_handle);
+    }
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] auto vertex_buffer() const noexcept { return _vertex_buffer_handle; }
+    [[nodiscard]] auto vertex_buffer_offset() const noexcept { return _vertex_buffer_offset; }
+    [[nodiscard]] auto vertex_count() const noexcept { return _vertex_count; }
+    [[nodiscard]] auto triangle_buffer() const noexcept { return _triangle_buffer_handle; }
+    [[nodiscard]] auto triangle_buffer_offset() const noexcept { return _triangle_buffer_offset; }
+    [[nodiscard]] auto triangle_count() const noexcept { return _triangle_count; }
+    [[nodiscard]] auto layout() const noexcept { return _layout; }
+    [[nodiscard]] const auto &format() const noexcept { return _format; }
     LUISA_MAKE_COMMAND_COMMON(MeshBuildCommand)
 };
 
+// Refits a built mesh to moved vertices; the triangles (topology) must be
+// the same as in the last MeshBuildCommand.
 class MeshUpdateCommand : public Command {
 
+private:
+    uint64_t _handle;
+    uint64_t _vertex_buffer_handle;
+    size_t _vertex_buffer_offset;
+    size_t _vertex_count;
+    uint64_t _triangle_buffer_handle;
+    size_t _triangle_buffer_offset;
+    size_t _triangle_count;
+    MeshFormat _format;
+
 public:
+    MeshUpdateCommand(uint64_t handle,
+                      uint64_t vertex_buffer, size_t vertex_buffer_offset, size_t vertex_count,
+                      uint64_t triangle_buffer, size_t triangle_buffer_offset, size_t triangle_count,
+                      MeshFormat format = {}) noexcept
+        : _handle{handle},
+          _vertex_buffer_handle{vertex_buffer},
+          _vertex_buffer_offset{vertex_buffer_offset},
+          _vertex_count{vertex_count},
+          _triangle_buffer_handle{triangle_buffer},
+          _triangle_buffer_offset{triangle_buffer_offset},
+          _triangle_count{triangle_count},
+          _format{format} {
+        _use_resource(_handle, Resource::Tag::MESH, Usage::READ_WRITE);
+        _buffer_read_only(_vertex_buffer_handle);
+        _buffer_read_only(_triangle_buffer_handle);
+    }
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] auto vertex_buffer() const noexcept { return _vertex_buffer_handle; }
+    [[nodiscard]] auto vertex_buffer_offset() const noexcept { return _vertex_buffer_offset; }
+    [[nodiscard]] auto vertex_count() const noexcept { return _vertex_count; }
+    [[nodiscard]] auto triangle_buffer() const noexcept { return _triangle_buffer_handle; }
+    [[nodiscard]] auto triangle_buffer_offset() const noexcept { return _triangle_buffer_offset; }
+    [[nodiscard]] auto triangle_count() const noexcept { return _triangle_count; }
+    [[nodiscard]] const auto &format() const noexcept { return _format; }
     LUISA_MAKE_COMMAND_COMMON(MeshUpdateCommand)
 };
 
+// Note: like uploads, accel commands reference host memory (the instance
+// mesh handles and transforms), which must stay valid until they complete.
+// Instance transforms are affine, stored as the first 3 rows (see float3x4).
+// As instances may reference any number of meshes, builds are ordered after
+// all preceding mesh commands (see Resource::any_handle).
 class AccelBuildCommand : public Command {
 
 private:
+    uint64_t _handle;
+    const uint64_t *_mesh_handles;
+    const float3x4 *_transforms;
+    size_t _instance_count;
+
 public:
+    AccelBuildCommand(uint64_t handle, std::span<const uint64_t> mesh_handles, std::span<const float3x4> transforms) noexcept
+        : _handle{handle},
+          _mesh_handles{mesh_handles.data()},
+          _transforms{transforms.data()},
+          _instance_count{mesh_handles.size()} {
+        if (mesh_handles.size() != transforms.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Mismatched instance mesh count ({}) and transform count ({}).",
+                mesh_handles.size(), transforms.size());
+        }
+        _use_resource(_handle, Resource::Tag::ACCEL, Usage::WRITE);
+        _use_resource(Resource::any_handle, Resource::Tag::MESH, Usage::READ);
+    }
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] auto mesh_handles() const noexcept { return std::span{_mesh_handles, _instance_count}; }
+    [[nodiscard]] auto transforms() const noexcept { return std::span{_transforms, _instance_count}; }
     LUISA_MAKE_COMMAND_COMMON(AccelBuildCommand)
 };
 
+// updates the instance transforms of a built accel
 class AccelUpdateCommand : public Command {
 
+private:
+    uint64_t _handle;
+    const float3x4 *_transforms;
+    size_t _instance_count;
+
 public:
+    AccelUpdateCommand(uint64_t handle, std::span<const float3x4> transforms) noexcept
+        : _handle{handle},
+          _transforms{transforms.data()},
+          _instance_count{transforms.size()} {
+        _use_resource(_handle, Resource::Tag::ACCEL, Usage::READ_WRITE);
+    }
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] auto transforms() const noexcept { return std::span{_transforms, _instance_count}; }
     LUISA_MAKE_COMMAND_COMMON(AccelUpdateCommand)
 };
 
-class AccelTraceClosestCommand : public Command {
+namespace detail {
+
+// Common part of the wavefront trace commands. Ray i of the queue is
+// rays[indices[i]] with an index buffer and rays[i] otherwise, and its
+// result goes to the same position in the hit buffer. The queue holds
+// max_ray_count rays, or the uint in the ray count buffer if there is one
+// (e.g. written by a preceding compaction), clamped to max_ray_count.
+// Rays and hits stored as structure of arrays, i.e. SoABuffer<Ray> and
+// SoABuffer<Hit>, come as their member buffers instead, with no_buffer as
+// the ray or hit buffer.
+class AccelTraceCommand : public Command {
+
+public:
+    static constexpr auto no_buffer = ~0ull;
+    // origin, t_min, direction and t_max
+    static constexpr auto ray_member_count = 4u;
+    // prim, inst and uv
+    static constexpr auto hit_member_count = 3u;
+    using RayMembers = std::array<uint64_t, ray_member_count>;
+    using HitMembers = std::array<uint64_t, hit_member_count>;
+
+private:
+    uint64_t _handle;
+    uint64_t _ray_buffer_handle;
+    size_t _ray_buffer_offset;
+    uint64_t _index_buffer_handle;
+    size_t _index_buffer_offset;
+    uint64_t _hit_buffer_handle;
+    size_t _hit_buffer_offset;
+    uint64_t _ray_count_buffer_handle;
+    size_t _ray_count_buffer_offset;
+    size_t _max_ray_count;
+    RayMembers _ray_members;
+    HitMembers _hit_members;
+
+protected:
+    AccelTraceCommand(uint64_t handle,
+                      uint64_t ray_buffer, size_t ray_buffer_offset,
+                      uint64_t index_buffer, size_t index_buffer_offset,
+                      uint64_t hit_buffer, size_t hit_buffer_offset,
+                      uint64_t ray_count_buffer, size_t ray_count_buffer_offset,
+                      size_t max_ray_count, RayMembers ray_members, HitMembers hit_members) noexcept
+        : _handle{handle},
+          _ray_buffer_handle{ray_buffer},
+          _ray_buffer_offset{ray_buffer_offset},
+          _index_buffer_handle{index_buffer},
+          _index_buffer_offset{index_buffer_offset},
+          _hit_buffer_handle{hit_buffer},
+          _hit_buffer_offset{hit_buffer_offset},
+          _ray_count_buffer_handle{ray_count_buffer},
+          _ray_count_buffer_offset{ray_count_buffer_offset},
+          _max_ray_count{max_ray_count},
+          _ray_members{ray_members},
+          _hit_members{hit_members} {
+        _use_resource(_handle, Resource::Tag::ACCEL, Usage::READ);
+        if (has_soa_rays()) {
+            for (auto m : _ray_members) { _buffer_read_only(m); }
+        } else {
+            _buffer_read_only(_ray_buffer_handle);
+        }
+        if (has_index_buffer()) { _buffer_read_only(_index_buffer_handle); }
+        if (has_soa_hits()) {
+            for (auto m : _hit_members) { _buffer_write_only(m); }
+        } else {
+            _buffer_write_only(_hit_buffer_handle);
+        }
+        if (has_ray_count_buffer()) { _buffer_read_only(_ray_count_buffer_handle); }
+    }
+
+public:
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+    [[nodiscard]] auto ray_buffer() const noexcept { return _ray_buffer_handle; }
+    [[nodiscard]] auto ray_buffer_offset() const noexcept { return _ray_buffer_offset; }
+    [[nodiscard]] bool has_index_buffer() const noexcept { return _index_buffer_handle != no_buffer; }
+    [[nodiscard]] auto index_buffer() const noexcept { return _index_buffer_handle; }
+    [[nodiscard]] auto index_buffer_offset() const noexcept { return _index_buffer_offset; }
+    [[nodiscard]] auto hit_buffer() const noexcept { return _hit_buffer_handle; }
+    [[nodiscard]] auto hit_buffer_offset() const noexcept { return _hit_buffer_offset; }
+    [[nodiscard]] bool has_ray_count_buffer() const noexcept { return _ray_count_buffer_handle != no_buffer; }
+    [[nodiscard]] auto ray_count_buffer() const noexcept { return _ray_count_buffer_handle; }
+    [[nodiscard]] auto ray_count_buffer_offset() const noexcept { return _ray_count_buffer_offset; }
+    [[nodiscard]] auto max_ray_count() const noexcept { return _max_ray_count; }
+    [[nodiscard]] bool has_soa_rays() const noexcept { return _ray_buffer_handle == no_buffer; }
+    [[nodiscard]] bool has_soa_hits() const noexcept { return _hit_buffer_handle == no_buffer; }
+    [[nodiscard]] const auto &ray_members() const noexcept { return _ray_members; }
+    [[nodiscard]] const auto &hit_members() const noexcept { return _hit_members; }
+};
+
+}// namespace detail
+
+// writes the closest Hit of each ray in the queue
+class AccelTraceClosestCommand : public detail::AccelTraceCommand {
 
 public:
+    AccelTraceClosestCommand(uint64_t handle,
+                             uint64_t ray_buffer, size_t ray_buffer_offset,
+                             uint64_t index_buffer, size_t index_buffer_offset,
+                             uint64_t hit_buffer, size_t hit_buffer_offset,
+                             uint64_t ray_count_buffer, size_t ray_count_buffer_offset,
+                             size_t max_ray_count, RayMembers ray_members = {}, HitMembers hit_members = {}) noexcept
+        : detail::AccelTraceCommand{handle,
+                                    ray_buffer, ray_buffer_offset,
+                                    index_buffer, index_buffer_offset,
+                                    hit_buffer, hit_buffer_offset,
+                                    ray_count_buffer, ray_count_buffer_offset,
+                                    max_ray_count, ray_members, hit_members} {}
     LUISA_MAKE_COMMAND_COMMON(AccelTraceClosestCommand)
 };
 
-class AccelTraceAnyCommand : public Command {
+// writes whether each ray in the queue hits anything, as a bool
+class AccelTraceAnyCommand : public detail::AccelTraceCommand {
 
 public:
+    AccelTraceAnyCommand(uint64_t handle,
+                         uint64_t ray_buffer, size_t ray_buffer_offset,
+                         uint64_t index_buffer, size_t index_buffer_offset,
+                         uint64_t hit_buffer, size_t hit_buffer_offset,
+                         uint64_t ray_count_buffer, size_t ray_count_buffer_offset,
+                         size_t max_ray_count, RayMembers ray_members = {}, HitMembers hit_members = {}) noexcept
+        : detail::AccelTraceCommand{handle,
+                                    ray_buffer, ray_buffer_offset,
+                                    index_buffer, index_buffer_offset,
+                                    hit_buffer, hit_buffer_offset,
+                                    ray_count_buffer, ray_count_buffer_offset,
+                                    max_ray_count, ray_members, hit_members} {}
     LUISA_MAKE_COMMAND_COMMON(AccelTraceAnyCommand)
 };
 
 #undef LUISA_MAKE_COMMAND_COMMON
+#undef LUISA_MAKE_COMMAND_CREATE
 
 }// namespace luisa::compute
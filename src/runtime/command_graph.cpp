@@ -0,0 +1,200 @@
+//
+// Created by Mike Smith on 2021/7/5.
+//
+
+#include <map>
+#include <algorithm>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <runtime/command_graph.h>
+
+namespace luisa::compute {
+
+CommandGraph::CommandGraph(Device::Handle device) noexcept
+    : _device{std::move(device)} {}
+
+CommandGraph::~CommandGraph() noexcept { _destroy(); }
+
+CommandGraph::CommandGraph(CommandGraph &&another) noexcept
+    : _device{std::move(another._device)},
+      _handle{another._handle},
+      _commands{std::move(another._commands)},
+      _nodes{std::move(another._nodes)},
+      _dependency_offsets{std::move(another._dependency_offsets)},
+      _dependencies{std::move(another._dependencies)},
+      _planned{another._planned} { another._handle = Device::Interface::invalid_handle; }
+
+CommandGraph &CommandGraph::operator=(CommandGraph &&rhs) noexcept {
+    if (this != &rhs) {
+        _destroy();
+        _device = std::move(rhs._device);
+        _handle = rhs._handle;
+        _commands = std::move(rhs._commands);
+        _nodes = std::move(rhs._nodes);
+        _dependency_offsets = std::move(rhs._dependency_offsets);
+        _dependencies = std::move(rhs._dependencies);
+        _planned = rhs._planned;
+        rhs._handle = Device::Interface::invalid_handle;
+    }
+    return *this;
+}
+
+void CommandGraph::_destroy() noexcept {
+    if (*this) { _invalidate(); }
+}
+
+void CommandGraph::_invalidate() noexcept {
+    if (_handle != Device::Interface::invalid_handle) {
+        _device->destroy_command_graph(_handle);
+        _handle = Device::Interface::invalid_handle;
+    }
+    _dependency_offsets.clear();
+    _dependencies.clear();
+    _planned = false;
+}
+
+CommandGraph::Node CommandGraph::add(Command *command) noexcept {
+    _invalidate();
+    auto index = _nodes.size();
+    for (auto cmd = command; cmd != nullptr; cmd = cmd->next()) {
+        _nodes.emplace_back(cmd);
+    }
+    _commands.append(command);
+    return index;
+}
+
+std::span<const uint32_t> CommandGraph::dependencies(Node node) const noexcept {
+    if (!_planned) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Command graph is not planned yet.");
+    }
+    return std::span{_dependencies}.subspan(
+        _dependency_offsets[node],
+        _dependency_offsets[node + 1u] - _dependency_offsets[node]);
+}
+
+void CommandGraph::_plan() noexcept {
+
+    Clock clock;
+    for (auto i = 0u; i < _nodes.size(); i++) {
+        if (auto command = dynamic_cast<const ShaderDispatchCommand *>(_nodes[i])) {
+            auto kernel = command->kernel();
+            auto expected_argument_count = kernel.captured_buffers().size() +
+                                           kernel.captured_textures().size() +
+                                           kernel.captured_texture_heaps().size() +
+                                           kernel.captured_accels().size() +
+                                           kernel.arguments().size();
+            if (command->argument_count() != expected_argument_count) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Incomplete shader dispatch at node {} in command graph "
+                    "({} argument(s) encoded, {} expected).",
+                    i, command->argument_count(), expected_argument_count);
+            }
+            if (auto s = command->dispatch_size(); s.x == 0u || s.y == 0u || s.z == 0u) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Empty dispatch size at node {} in command graph.", i);
+            }
+        }
+    }
+
+    // read-after-write, write-after-read and write-after-write hazards
+    struct Access {
+        uint32_t last_writer{~0u};
+        std::vector<uint32_t> readers;
+    };
+    std::map<std::pair<Command::Resource::Tag, uint64_t>, Access> accesses;
+    _dependency_offsets.reserve(_nodes.size() + 1u);
+    _dependency_offsets.emplace_back(0u);
+    for (auto i = 0u; i < _nodes.size(); i++) {
+        auto first = _dependencies.size();
+        for (auto r : _nodes[i]->resources()) {
+            using Resource = Command::Resource;
+            auto any_key = std::make_pair(r.tag, Resource::any_handle);
+            if (r.handle == Resource::any_handle) {
+                // reads all resources with the tag, e.g. meshes of an accel build
+                for (auto iter = accesses.lower_bound(std::make_pair(r.tag, 0ull));
+                     iter != accesses.end() && iter->first.first == r.tag; iter++) {
+                    if (iter->second.last_writer != ~0u) { _dependencies.emplace_back(iter->second.last_writer); }
+                }
+                accesses[any_key].readers.emplace_back(i);
+                continue;
+            }
+            if (to_underlying(r.usage) & to_underlying(Usage::WRITE)) {
+                if (auto iter = accesses.find(any_key); iter != accesses.end()) {
+                    _dependencies.insert(_dependencies.end(), iter->second.readers.cbegin(), iter->second.readers.cend());
+                }
+            }
+            auto &&access = accesses[std::make_pair(r.tag, r.handle)];
+            if (access.last_writer != ~0u) { _dependencies.emplace_back(access.last_writer); }
+            if (to_underlying(r.usage) & to_underlying(Usage::WRITE)) {
+                _dependencies.insert(_dependencies.end(), access.readers.cbegin(), access.readers.cend());
+                access.readers.clear();
+                access.last_writer = i;
+            } else {
+                access.readers.emplace_back(i);
+            }
+        }
+        std::sort(_dependencies.begin() + first, _dependencies.end());
+        _dependencies.erase(std::unique(_dependencies.begin() + first, _dependencies.end()), _dependencies.end());
+        _dependency_offsets.emplace_back(static_cast<uint32_t>(_dependencies.size()));
+    }
+    _planned = true;
+    _handle = _device->create_command_graph(*this);
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Planned command graph with {} node(s) and {} dependency edge(s) in {} ms.",
+        _nodes.size(), _dependencies.size(), clock.toc());
+}
+
+void CommandGraph::_replay(uint64_t stream_handle) noexcept {
+    if (_nodes.empty()) { return; }
+    if (!_planned) { _plan(); }
+    _device->dispatch_command_graph(stream_handle, _handle, *this);
+}
+
+void CommandGraph::_notify_update(Node node) noexcept {
+    if (_handle != Device::Interface::invalid_handle) {
+        _device->update_command_graph(_handle, *this, node);
+    }
+}
+
+ShaderDispatchCommand *CommandGraph::_dispatch_command(Node node) const noexcept {
+    auto command = dynamic_cast<ShaderDispatchCommand *>(_nodes[node]);
+    if (command == nullptr) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Node {} in command graph is not a shader dispatch.", node);
+    }
+    return command;
+}
+
+uint32_t CommandGraph::_argument_uid(Node node, size_t argument_index) const noexcept {
+    auto arguments = _dispatch_command(node)->kernel().arguments();
+    if (argument_index >= arguments.size()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Argument index {} out of range for the kernel at node {} "
+            "with {} argument(s).",
+            argument_index, node, arguments.size());
+    }
+    return arguments[argument_index].uid();
+}
+
+void CommandGraph::set_dispatch_size(Node node, uint3 size) noexcept {
+    if (size.x == 0u || size.y == 0u || size.z == 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Empty dispatch size at node {} in command graph.", node);
+    }
+    _dispatch_command(node)->set_dispatch_size(size);
+    _notify_update(node);
+}
+
+void CommandGraph::_update_uniform(Node node, size_t argument_index, const void *data, size_t size) noexcept {
+    _dispatch_command(node)->update_uniform(_argument_uid(node, argument_index), data, size);
+    _notify_update(node);
+}
+
+void CommandGraph::_update_buffer(Node node, size_t argument_index, uint64_t handle, size_t offset) noexcept {
+    _dispatch_command(node)->update_buffer(_argument_uid(node, argument_index), handle, offset);
+    // dependencies may have changed
+    _invalidate();
+}
+
+}// namespace luisa::compute
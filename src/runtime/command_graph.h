@@ -0,0 +1,95 @@
+//
+// Created by Mike Smith on 2021/7/5.
+//
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <core/concepts.h>
+#include <runtime/command_list.h>
+#include <runtime/device.h>
+#include <runtime/buffer.h>
+
+namespace luisa::compute {
+
+// A recorded sequence of commands that can be replayed on any stream of the
+// device without re-encoding. The graph is validated and planned (resource
+// dependencies between nodes) once before its first replay, after which the
+// backend may pre-bake it into a native representation. Uniforms and dispatch
+// sizes can be patched cheaply between replays; rebinding buffers triggers a
+// re-plan at the next replay. Host pointers of uploads/downloads must stay
+// valid for as long as the graph is replayed.
+class CommandGraph : concepts::Noncopyable {
+
+public:
+    using Node = size_t;
+
+private:
+    Device::Handle _device;
+    uint64_t _handle{Device::Interface::invalid_handle};
+    CommandList _commands;
+    std::vector<Command *> _nodes;
+    std::vector<uint32_t> _dependency_offsets;
+    std::vector<uint32_t> _dependencies;
+    bool _planned{false};
+
+private:
+    friend class Device;
+    friend class Stream;
+    explicit CommandGraph(Device::Handle device) noexcept;
+    void _plan() noexcept;
+    void _invalidate() noexcept;
+    void _replay(uint64_t stream_handle) noexcept;
+    void _destroy() noexcept;
+    void _notify_update(Node node) noexcept;
+    [[nodiscard]] ShaderDispatchCommand *_dispatch_command(Node node) const noexcept;
+    [[nodiscard]] uint32_t _argument_uid(Node node, size_t argument_index) const noexcept;
+    void _update_buffer(Node node, size_t argument_index, uint64_t handle, size_t offset) noexcept;
+    void _update_uniform(Node node, size_t argument_index, const void *data, size_t size) noexcept;
+
+public:
+    CommandGraph() noexcept = default;
+    ~CommandGraph() noexcept;
+    CommandGraph(CommandGraph &&another) noexcept;
+    CommandGraph &operator=(CommandGraph &&rhs) noexcept;
+    [[nodiscard]] explicit operator bool() const noexcept { return _device != nullptr; }
+
+    // recording; returns the index of the (first) appended node
+    Node add(Command *command) noexcept;
+    CommandGraph &operator<<(Command *command) noexcept {
+        add(command);
+        return *this;
+    }
+
+    [[nodiscard]] auto size() const noexcept { return _nodes.size(); }
+    [[nodiscard]] auto empty() const noexcept { return _nodes.empty(); }
+    [[nodiscard]] const Command *node(Node node) const noexcept { return _nodes[node]; }
+    [[nodiscard]] std::span<const Command *const> nodes() const noexcept { return _nodes; }
+    [[nodiscard]] const CommandList &commands() const noexcept { return _commands; }
+    // nodes that must complete before `node` starts; valid once planned
+    [[nodiscard]] std::span<const uint32_t> dependencies(Node node) const noexcept;
+    [[nodiscard]] auto planned() const noexcept { return _planned; }
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+
+    // patching of shader dispatch nodes, effective from the next replay
+    void set_dispatch_size(Node node, uint3 size) noexcept;
+
+    template<typename T>
+    void set_uniform(Node node, size_t argument_index, T value) noexcept {
+        _update_uniform(node, argument_index, &value, sizeof(T));
+    }
+
+    template<typename T>
+    void set_buffer(Node node, size_t argument_index, BufferView<T> buffer) noexcept {
+        _update_buffer(node, argument_index, buffer.handle(), buffer.offset_bytes());
+    }
+
+    template<typename T>
+    void set_buffer(Node node, size_t argument_index, const Buffer<T> &buffer) noexcept {
+        set_buffer(node, argument_index, buffer.view());
+    }
+};
+
+}// namespace luisa::compute
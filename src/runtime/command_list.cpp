@@ -2,11 +2,17 @@
 // Created by Mike Smith on 2021/3/18.
 //
 
+#include <core/logging.h>
 #include <runtime/command_list.h>
 
 namespace luisa::compute {
 
 void CommandList::_recycle() noexcept {
+    if (!_owned) {
+        _head = nullptr;
+        _tail = nullptr;
+        return;
+    }
     while (_head != nullptr) {
         auto cmd = _head;
         _head = _head->next();
@@ -14,16 +20,30 @@ void CommandList::_recycle() noexcept {
     }
 }
 
+CommandList CommandList::borrow(const CommandList &list) noexcept {
+    CommandList borrowed;
+    borrowed._head = list._head;
+    borrowed._tail = list._tail;
+    borrowed._owned = false;
+    return borrowed;
+}
+
 void CommandList::append(Command *cmd) noexcept {
+    if (!_owned) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Cannot append to a borrowed command list.");
+    }
+    if (cmd == nullptr) { return; }
     if (_head == nullptr) { _head = cmd; }
     _tail = _tail == nullptr ? cmd->tail() : _tail->set_next(cmd);
 }
 
 CommandList::CommandList(CommandList &&another) noexcept
     : _head{another._head},
-      _tail{another._tail} {
+      _tail{another._tail},
+      _owned{another._owned} {
     another._head = nullptr;
     another._tail = nullptr;
+    another._owned = true;
 }
 
 CommandList &CommandList::operator=(CommandList &&rhs) noexcept {
@@ -31,8 +51,10 @@ CommandList &CommandList::operator=(CommandList &&rhs) noexcept {
         _recycle();
         _head = rhs._head;
         _tail = rhs._tail;
+        _owned = rhs._owned;
         rhs._head = nullptr;
         rhs._tail = nullptr;
+        rhs._owned = true;
     }
     return *this;
 }
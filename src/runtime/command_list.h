@@ -19,7 +19,7 @@ public:
 
     public:
         explicit Iterator(Command *cmd) noexcept : _command{cmd} {}
-        [[nodiscard]] decltype(auto) operator++() noexcept {
+        decltype(auto) operator++() noexcept {
             _command = _command->next();
             return *this;
         }
@@ -36,11 +36,15 @@ public:
 private:
     Command *_head{nullptr};
     Command *_tail{nullptr};
+    bool _owned{true};
 
     void _recycle() noexcept;
 
 public:
     CommandList() noexcept = default;
+    // iterates over the commands of `list` without taking their ownership,
+    // e.g. to dispatch the commands of a command graph without copying them
+    [[nodiscard]] static CommandList borrow(const CommandList &list) noexcept;
     ~CommandList() noexcept;
     CommandList(CommandList &&) noexcept;
     CommandList &operator=(CommandList &&rhs) noexcept;
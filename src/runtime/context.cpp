@@ -48,7 +48,36 @@ Device Context::create_device(std::string_view backend_name, uint32_t index) noe
         _device_deleters.emplace_back(destroy);
         return std::make_pair(create, destroy);
     }();
-    return Device{Device::Handle{create(*this, index), destroy}};
+    auto device = create(*this, index);
+    device->_backend = backend_name;
+    return Device{Device::Handle{device, destroy}};
+}
+
+bool Context::load_kernel_archive(const std::filesystem::path &path) noexcept {
+    auto archive = KernelArchive::open(path);
+    if (archive == nullptr) { return false; }
+    LUISA_INFO(
+        "Loaded kernel archive '{}' with {} kernel(s) for backend '{}'.",
+        path.string(), archive->size(), archive->backend());
+    if (auto iter = std::find_if(_kernel_archives.begin(), _kernel_archives.end(), [&archive](auto &&a) noexcept {
+            return a->backend() == archive->backend();
+        });
+        iter != _kernel_archives.end()) {
+        LUISA_WARNING_WITH_LOCATION(
+            "Replacing previously loaded kernel archive for backend '{}'.",
+            archive->backend());
+        *iter = std::move(archive);
+    } else {
+        _kernel_archives.emplace_back(std::move(archive));
+    }
+    return true;
+}
+
+const KernelArchive *Context::kernel_archive(std::string_view backend_name) const noexcept {
+    auto iter = std::find_if(_kernel_archives.cbegin(), _kernel_archives.cend(), [backend_name](auto &&a) noexcept {
+        return a->backend() == backend_name;
+    });
+    return iter == _kernel_archives.cend() ? nullptr : iter->get();
 }
 
 }// namespace luisa::compute
@@ -10,6 +10,7 @@
 
 #include <core/dynamic_module.h>
 #include <runtime/device.h>
+#include <runtime/kernel_archive.h>
 
 namespace luisa::compute {
 
@@ -22,12 +23,16 @@ private:
     std::vector<std::string> _device_identifiers;
     std::vector<Device::Creator *> _device_creators;
     std::vector<Device::Deleter *> _device_deleters;
+    std::vector<std::unique_ptr<KernelArchive>> _kernel_archives;
 
 public:
     explicit Context(const std::filesystem::path &program) noexcept;
     [[nodiscard]] const std::filesystem::path &runtime_directory() const noexcept;
     [[nodiscard]] const std::filesystem::path &cache_directory() const noexcept;
     [[nodiscard]] Device create_device(std::string_view backend_name, uint32_t index = 0u) noexcept;
+    // maps a kernel archive so that Device::compile() picks up its precompiled kernels
+    bool load_kernel_archive(const std::filesystem::path &path) noexcept;
+    [[nodiscard]] const KernelArchive *kernel_archive(std::string_view backend_name) const noexcept;
 };
 
 }// namespace luisa::compute
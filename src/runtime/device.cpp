@@ -6,6 +6,7 @@
 #include <runtime/stream.h>
 #include <runtime/texture_heap.h>
 #include <runtime/device.h>
+#include <runtime/command_graph.h>
 
 namespace luisa::compute {
 
@@ -21,4 +22,14 @@ TextureHeap Device::create_texture_heap(size_t size) noexcept {
     return _create<TextureHeap>(size);
 }
 
+CommandGraph Device::create_command_graph() noexcept {
+    return _create<CommandGraph>();
 }
+
+void Device::Interface::dispatch_command_graph(uint64_t stream_handle, uint64_t, const CommandGraph &graph) noexcept {
+    // backends without native graphs encode the pre-validated commands in
+    // place; they are borrowed, so the graph keeps them for later replays
+    dispatch(stream_handle, CommandList::borrow(graph.commands()));
+}
+
+}// namespace luisa::compute
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <span>
+#include <string>
+#include <vector>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -12,6 +15,7 @@
 #include <core/memory.h>
 #include <core/concepts.h>
 #include <ast/function.h>
+#include <ast/compile_options.h>
 #include <runtime/pixel.h>
 #include <runtime/command_list.h>
 #include <runtime/texture_sampler.h>
@@ -23,10 +27,14 @@ class Context;
 class Event;
 class Stream;
 class TextureHeap;
+class CommandGraph;
 
 template<typename T>
 class Buffer;
 
+template<typename T>
+class SoABuffer;
+
 template<typename T>
 class Image;
 
@@ -50,12 +58,20 @@ public:
 
     private:
         const Context &_ctx;
+        std::string _backend;
+
+    private:
+        friend class Context;
+
+    public:
+        static constexpr auto invalid_handle = ~0ull;
 
     public:
         explicit Interface(const Context &ctx) noexcept : _ctx{ctx} {}
         virtual ~Interface() noexcept = default;
 
         [[nodiscard]] const Context &context() const noexcept { return _ctx; }
+        [[nodiscard]] std::string_view backend() const noexcept { return _backend; }
 
         // buffer
         [[nodiscard]] virtual uint64_t create_buffer(size_t size_bytes) noexcept = 0;
@@ -82,10 +98,25 @@ public:
         virtual void synchronize_stream(uint64_t stream_handle) noexcept = 0;
         virtual void dispatch(uint64_t stream_handle, CommandList) noexcept = 0;
 
+        // command graphs (see runtime/command_graph.h); backends may pre-bake a
+        // planned graph into their native representation and return its handle,
+        // or return invalid_handle to have the commands re-dispatched per replay
+        [[nodiscard]] virtual uint64_t create_command_graph(const CommandGraph &) noexcept { return invalid_handle; }
+        virtual void update_command_graph(uint64_t, const CommandGraph &, size_t) noexcept {}
+        virtual void destroy_command_graph(uint64_t) noexcept {}
+        virtual void dispatch_command_graph(uint64_t stream_handle, uint64_t handle, const CommandGraph &graph) noexcept;
+
         // kernel
-        virtual uint64_t create_shader(Function kernel) noexcept = 0;
+        virtual uint64_t create_shader(Function kernel, const CompileOptions &options) noexcept = 0;
         virtual void destroy_shader(uint64_t handle) noexcept = 0;
 
+        // precompiled kernels (see runtime/kernel_archive.h); backends without
+        // binary support return no binary and compile from the AST instead
+        [[nodiscard]] virtual std::vector<std::byte> compile_shader_binary(Function, const CompileOptions &) noexcept { return {}; }
+        [[nodiscard]] virtual uint64_t create_shader_from_binary(Function kernel, const CompileOptions &options, std::span<const std::byte>) noexcept {
+            return create_shader(kernel, options);
+        }
+
         // event
         [[nodiscard]] virtual uint64_t create_event() noexcept = 0;
         virtual void destroy_event(uint64_t handle) noexcept = 0;
@@ -93,21 +124,10 @@ public:
         virtual void wait_event(uint64_t handle, uint64_t stream_handle) noexcept = 0;
         virtual void synchronize_event(uint64_t handle) noexcept = 0;
 
-        virtual uint64_t create_mesh(uint64_t stream_handle,
-                                     uint64_t vertex_buffer_handle,
-                                     size_t vertex_buffer_offset_bytes,
-                                     size_t vertex_count,
-                                     uint64_t index_buffer_handle,
-                                     size_t index_buffer_offset_bytes,
-                                     size_t triangle_count) noexcept = 0;
+        // meshes and accels are filled by Mesh/AccelBuildCommands on streams
+        [[nodiscard]] virtual uint64_t create_mesh() noexcept = 0;
         virtual void destroy_mesh(uint64_t handle) noexcept = 0;
-
-        virtual uint64_t create_accel(uint64_t stream_handle,
-                                      uint64_t mesh_handle_buffer_handle,
-                                      size_t mesh_handle_buffer_offset_bytes,
-                                      uint64_t transform_buffer_handle,
-                                      size_t transform_buffer_offset_bytes,
-                                      size_t mesh_count) noexcept = 0;
+        [[nodiscard]] virtual uint64_t create_accel() noexcept = 0;
         virtual void destroy_accel(uint64_t handle) noexcept = 0;
     };
 
@@ -128,11 +148,13 @@ public:
         : _impl{std::move(handle)} {}
 
     [[nodiscard]] decltype(auto) context() const noexcept { return _impl->context(); }
+    [[nodiscard]] auto impl() const noexcept { return _impl.get(); }
 
 
     [[nodiscard]] Stream create_stream() noexcept;
     [[nodiscard]] Event create_event() noexcept;
     [[nodiscard]] TextureHeap create_texture_heap(size_t size = 128_mb) noexcept;
+    [[nodiscard]] CommandGraph create_command_graph() noexcept;
 
     template<typename T>
     [[nodiscard]] auto create_image(PixelStorage pixel, uint width, uint height) noexcept {
@@ -159,10 +181,15 @@ public:
         return _create<Buffer<T>>(size);
     }
 
+    template<typename T>
+    [[nodiscard]] auto create_soa_buffer(size_t size) noexcept {
+        return _create<SoABuffer<T>>(size);
+    }
+
     // see definitions in dsl/func.h
     template<size_t N, typename... Args>
-    [[nodiscard]] auto compile(const Kernel<N, Args...> &kernel) noexcept {
-        return _create<Shader<N, Args...>>(kernel.function());
+    [[nodiscard]] auto compile(const Kernel<N, Args...> &kernel, const CompileOptions &options = {}) noexcept {
+        return _create<Shader<N, Args...>>(kernel.function(), options);
     }
 };
 
@@ -0,0 +1,200 @@
+//
+// Created by Mike Smith on 2021/7/3.
+//
+
+#include <fstream>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/mathematics.h>
+#include <ast/function_serializer.h>
+#include <runtime/context.h>
+#include <runtime/kernel_archive.h>
+
+namespace luisa::compute {
+
+KernelArchive::Builder::Builder(const Device &device) noexcept
+    : _device{device.impl()} {
+    if (_device->backend().size() >= max_backend_name_length) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Backend name '{}' is too long for kernel archives.",
+            _device->backend());
+    }
+}
+
+void KernelArchive::Builder::_add(Function kernel, const CompileOptions &options) noexcept {
+    options.validate(kernel);
+    auto hash = options.hash(FunctionSerializer::hash(kernel));
+    if (std::any_of(_items.cbegin(), _items.cend(), [hash](auto &&item) noexcept {
+            return item.hash == hash;
+        })) { return; }
+    Clock clock;
+    auto binary = _device->compile_shader_binary(kernel, options);
+    if (binary.empty()) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Backend '{}' produced no binary for kernel {}. "
+            "It will be compiled from the archived AST at runtime.",
+            _device->backend(), hash_to_string(hash));
+    }
+    LUISA_INFO(
+        "Archived kernel {} ({} bytes) in {} ms.",
+        hash_to_string(hash), binary.size(), clock.toc());
+    _items.emplace_back(Item{hash, std::move(binary), FunctionSerializer::serialize(kernel)});
+}
+
+bool KernelArchive::Builder::write(const std::filesystem::path &path) const noexcept {
+
+    auto align = [](uint64_t offset) noexcept {
+        return (offset + blob_alignment - 1u) / blob_alignment * blob_alignment;
+    };
+
+    Header header{};
+    header.magic = magic;
+    header.version = version;
+    auto backend = _device->backend();
+    std::copy(backend.cbegin(), backend.cend(), header.backend.begin());
+    header.entry_count = static_cast<uint32_t>(_items.size());
+    header.table_capacity = next_pow2(std::max(static_cast<uint32_t>(_items.size() * 2u), 1u));
+    header.table_offset = align(sizeof(Header));
+    auto offset = align(header.table_offset + header.table_capacity * sizeof(Entry));
+
+    std::vector<Entry> table(header.table_capacity);
+    auto mask = header.table_capacity - 1u;
+    for (auto &&item : _items) {
+        auto slot = item.hash & mask;
+        while (table[slot].binary_offset != 0u) { slot = (slot + 1u) & mask; }
+        auto &&e = table[slot];
+        e.hash = item.hash;
+        e.binary_offset = offset;
+        e.binary_size = item.binary.size();
+        offset = align(offset + item.binary.size());
+        e.ast_offset = offset;
+        e.ast_size = item.ast.size();
+        offset = align(offset + item.ast.size());
+    }
+    header.file_size = offset;
+
+    std::ofstream file{path, std::ios::binary};
+    if (!file) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to open file '{}' for kernel archive.",
+            path.string());
+        return false;
+    }
+    auto pad_to = [&file](uint64_t offset) noexcept {
+        static constexpr std::array<char, blob_alignment> zeros{};
+        auto p = static_cast<uint64_t>(file.tellp());
+        file.write(zeros.data(), static_cast<std::streamsize>(offset - p));
+    };
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    pad_to(header.table_offset);
+    file.write(reinterpret_cast<const char *>(table.data()),
+               static_cast<std::streamsize>(table.size() * sizeof(Entry)));
+    // blobs are laid out in insertion order, matching the offsets above
+    for (auto &&item : _items) {
+        auto e = std::find_if(table.cbegin(), table.cend(), [&item](auto &&e) noexcept {
+            return e.binary_offset != 0u && e.hash == item.hash;
+        });
+        pad_to(e->binary_offset);
+        file.write(reinterpret_cast<const char *>(item.binary.data()),
+                   static_cast<std::streamsize>(item.binary.size()));
+        pad_to(e->ast_offset);
+        file.write(reinterpret_cast<const char *>(item.ast.data()),
+                   static_cast<std::streamsize>(item.ast.size()));
+    }
+    pad_to(header.file_size);
+    if (!file) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to write kernel archive '{}'.",
+            path.string());
+        return false;
+    }
+    LUISA_INFO(
+        "Written {} kernel(s) for backend '{}' to archive '{}' ({} bytes).",
+        _items.size(), backend, path.string(), header.file_size);
+    return true;
+}
+
+KernelArchive::KernelArchive(std::span<const std::byte> mapping) noexcept
+    : _mapping{mapping},
+      _header{reinterpret_cast<const Header *>(mapping.data())},
+      _table{reinterpret_cast<const Entry *>(mapping.data() + _header->table_offset),
+             _header->table_capacity} {}
+
+KernelArchive::~KernelArchive() noexcept { memory_unmap_file(_mapping); }
+
+std::unique_ptr<KernelArchive> KernelArchive::open(const std::filesystem::path &path) noexcept {
+    auto mapping = memory_map_file(path);
+    if (mapping.empty()) [[unlikely]] { return nullptr; }
+    auto valid = [mapping] {
+        if (mapping.size() < sizeof(Header)) { return false; }
+        auto header = reinterpret_cast<const Header *>(mapping.data());
+        if (header->magic != magic || header->version != version) { return false; }
+        if (header->file_size != mapping.size()) { return false; }
+        if (header->table_capacity == 0u || (header->table_capacity & (header->table_capacity - 1u)) != 0u) { return false; }
+        if (header->table_offset % alignof(Entry) != 0u) { return false; }
+        if (header->table_offset > mapping.size() ||
+            header->table_capacity > (mapping.size() - header->table_offset) / sizeof(Entry)) { return false; }
+        auto table = reinterpret_cast<const Entry *>(mapping.data() + header->table_offset);
+        // sizes are compared against the remaining bytes so that the sums cannot overflow
+        auto in_mapping = [size = mapping.size()](uint64_t offset, uint64_t n) noexcept {
+            return offset <= size && n <= size - offset;
+        };
+        auto occupied = 0u;
+        for (auto i = 0u; i < header->table_capacity; i++) {
+            auto &&e = table[i];
+            if (e.binary_offset == 0u) { continue; }
+            if (!in_mapping(e.binary_offset, e.binary_size) ||
+                !in_mapping(e.ast_offset, e.ast_size)) { return false; }
+            occupied++;
+        }
+        // lookups stop at empty slots, so there must be at least one
+        return header->entry_count == occupied && occupied < header->table_capacity;
+    }();
+    if (!valid) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION("Invalid kernel archive '{}'.", path.string());
+        memory_unmap_file(mapping);
+        return nullptr;
+    }
+    return std::unique_ptr<KernelArchive>{new KernelArchive{mapping}};
+}
+
+std::string_view KernelArchive::backend() const noexcept {
+    auto &&b = _header->backend;
+    return {b.data(), static_cast<size_t>(std::find(b.cbegin(), b.cend(), '\0') - b.cbegin())};
+}
+
+const KernelArchive::Entry *KernelArchive::find(uint64_t hash) const noexcept {
+    auto mask = _table.size() - 1u;
+    auto slot = hash & mask;
+    for (auto i = 0u; i < _table.size(); i++, slot = (slot + 1u) & mask) {
+        auto &&e = _table[slot];
+        if (e.binary_offset == 0u) { return nullptr; }
+        if (e.hash == hash) { return &e; }
+    }
+    return nullptr;
+}
+
+std::span<const std::byte> KernelArchive::binary(const Entry &entry) const noexcept {
+    return _mapping.subspan(entry.binary_offset, entry.binary_size);
+}
+
+std::span<const std::byte> KernelArchive::ast(const Entry &entry) const noexcept {
+    return _mapping.subspan(entry.ast_offset, entry.ast_size);
+}
+
+uint64_t detail::create_shader(Device::Interface *device, Function kernel, const CompileOptions &options) noexcept {
+    options.validate(kernel);
+    if (auto archive = device->context().kernel_archive(device->backend()); archive != nullptr) {
+        auto hash = options.hash(FunctionSerializer::hash(kernel));
+        if (auto entry = archive->find(hash); entry != nullptr && entry->binary_size != 0u) {
+            LUISA_VERBOSE_WITH_LOCATION(
+                "Found precompiled kernel {} in archive.",
+                hash_to_string(hash));
+            return device->create_shader_from_binary(kernel, options, archive->binary(*entry));
+        }
+    }
+    return device->create_shader(kernel, options);
+}
+
+}// namespace luisa::compute
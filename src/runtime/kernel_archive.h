@@ -0,0 +1,109 @@
+//
+// Created by Mike Smith on 2021/7/3.
+//
+
+#pragma once
+
+#include <span>
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+#include <core/concepts.h>
+#include <ast/function.h>
+#include <runtime/device.h>
+
+namespace luisa::compute {
+
+// A read-only bundle of precompiled kernels for one backend, memory-mapped by
+// Context::load_kernel_archive(). Layout: Header | Entry[table_capacity] (an
+// open-addressing hash table keyed by FunctionSerializer::hash() combined
+// with CompileOptions::hash()) | blobs,
+// each blob (backend binary or serialized AST) aligned to blob_alignment.
+class KernelArchive : concepts::Noncopyable {
+
+public:
+    static constexpr auto magic = 0x414b434cu;// "LCKA"
+    static constexpr auto version = 2u;
+    static constexpr auto blob_alignment = 256u;
+    static constexpr auto max_backend_name_length = 32u;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        std::array<char, max_backend_name_length> backend;
+        uint32_t entry_count;
+        uint32_t table_capacity;// power of two
+        uint64_t table_offset;
+        uint64_t file_size;
+    };
+
+    struct Entry {
+        uint64_t hash;
+        uint64_t binary_offset;// zero for empty slots
+        uint64_t binary_size;
+        uint64_t ast_offset;
+        uint64_t ast_size;
+    };
+
+    class Builder {
+
+    private:
+        struct Item {
+            uint64_t hash;
+            std::vector<std::byte> binary;
+            std::vector<std::byte> ast;
+        };
+
+    private:
+        Device::Interface *_device;
+        std::vector<Item> _items;
+
+        void _add(Function kernel, const CompileOptions &options) noexcept;
+
+    public:
+        // kernels are compiled by and archived for the backend of `device`
+        explicit Builder(const Device &device) noexcept;
+
+        // see definitions of Kernel in dsl/func.h
+        template<size_t N, typename... Args>
+        Builder &add(const Kernel<N, Args...> &kernel, const CompileOptions &options = {}) noexcept {
+            _add(kernel.function()->function(), options);
+            return *this;
+        }
+
+        [[nodiscard]] auto size() const noexcept { return _items.size(); }
+        [[nodiscard]] bool write(const std::filesystem::path &path) const noexcept;
+    };
+
+private:
+    std::span<const std::byte> _mapping;
+    const Header *_header{nullptr};
+    std::span<const Entry> _table;
+
+private:
+    explicit KernelArchive(std::span<const std::byte> mapping) noexcept;
+
+public:
+    ~KernelArchive() noexcept;
+    // returns nullptr if the file is missing or not a valid archive
+    [[nodiscard]] static std::unique_ptr<KernelArchive> open(const std::filesystem::path &path) noexcept;
+    [[nodiscard]] std::string_view backend() const noexcept;
+    [[nodiscard]] size_t size() const noexcept { return _header->entry_count; }
+    [[nodiscard]] const Entry *find(uint64_t hash) const noexcept;
+    [[nodiscard]] std::span<const std::byte> binary(const Entry &entry) const noexcept;
+    [[nodiscard]] std::span<const std::byte> ast(const Entry &entry) const noexcept;
+};
+
+namespace detail {
+
+// creates the shader from a precompiled binary when one of the loaded
+// kernel archives has it, or compiles it from the AST otherwise
+[[nodiscard]] uint64_t create_shader(Device::Interface *device, Function kernel, const CompileOptions &options) noexcept;
+
+}// namespace detail
+
+}// namespace luisa::compute
@@ -7,6 +7,8 @@
 #include <core/basic_types.h>
 #include <ast/function_builder.h>
 #include <runtime/device.h>
+#include <runtime/kernel_archive.h>
+#include <runtime/soa_buffer.h>
 #include <runtime/texture_heap.h>
 
 namespace luisa::compute {
@@ -28,6 +30,11 @@ struct prototype_to_shader_invocation<Buffer<T>> {
     using type = BufferView<T>;
 };
 
+template<typename T>
+struct prototype_to_shader_invocation<SoABuffer<T>> {
+    using type = const SoABuffer<T> &;
+};
+
 template<typename T>
 struct prototype_to_shader_invocation<Image<T>> {
     using type = ImageView<T>;
@@ -41,6 +48,36 @@ struct prototype_to_shader_invocation<Volume<T>> {
 template<typename T>
 using prototype_to_shader_invocation_t = typename prototype_to_shader_invocation<T>::type;
 
+// encodes the captured resources of a kernel once per shader, so that
+// invocations only copy the prototype and append their explicit arguments
+[[nodiscard]] inline auto make_shader_dispatch_prototype(uint64_t handle, Function kernel) noexcept {
+
+    auto prototype = std::make_unique<ShaderDispatchCommand>(handle, kernel);
+
+    for (auto buffer : kernel.captured_buffers()) {
+        prototype->encode_buffer(
+            buffer.variable.uid(), buffer.handle, buffer.offset_bytes,
+            kernel.variable_usage(buffer.variable.uid()));
+    }
+
+    for (auto texture : kernel.captured_textures()) {
+        prototype->encode_texture(
+            texture.variable.uid(), texture.handle,
+            kernel.variable_usage(texture.variable.uid()));
+    }
+
+    for (auto heap : kernel.captured_texture_heaps()) {
+        prototype->encode_texture_heap(
+            heap.variable.uid(), heap.handle);
+    }
+
+    for (auto accel : kernel.captured_accels()) {
+        prototype->encode_accel(
+            accel.variable.uid(), accel.handle);
+    }
+    return prototype;
+}
+
 class ShaderInvokeBase {
 
 private:
@@ -54,27 +91,9 @@ private:
     }
 
 public:
-    explicit ShaderInvokeBase(uint64_t handle, Function kernel) noexcept
-        : _command{ShaderDispatchCommand::create(handle, kernel)},
-          _kernel{kernel} {
-
-        for (auto buffer : _kernel.captured_buffers()) {
-            _dispatch_command()->encode_buffer(
-                buffer.variable.uid(), buffer.handle, buffer.offset_bytes,
-                _kernel.variable_usage(buffer.variable.uid()));
-        }
-
-        for (auto texture : _kernel.captured_textures()) {
-            _dispatch_command()->encode_texture(
-                texture.variable.uid(), texture.handle,
-                _kernel.variable_usage(texture.variable.uid()));
-        }
-
-        for (auto heap : _kernel.captured_texture_heaps()) {
-            _dispatch_command()->encode_texture_heap(
-                heap.variable.uid(), heap.handle);
-        }
-    }
+    explicit ShaderInvokeBase(const ShaderDispatchCommand *prototype) noexcept
+        : _command{ShaderDispatchCommand::create(prototype)},
+          _kernel{prototype->kernel()} {}
 
     template<typename T>
     ShaderInvokeBase &operator<<(BufferView<T> buffer) noexcept {
@@ -85,6 +104,17 @@ public:
         return *this;
     }
 
+    // one buffer argument per member
+    template<typename T>
+    ShaderInvokeBase &operator<<(const SoABuffer<T> &buffer) noexcept {
+        for (auto handle : buffer.member_handles()) {
+            auto variable_uid = _kernel.arguments()[_argument_index++].uid();
+            auto usage = _kernel.variable_usage(variable_uid);
+            _dispatch_command()->encode_buffer(variable_uid, handle, 0u, usage);
+        }
+        return *this;
+    }
+
     template<typename T>
     ShaderInvokeBase &operator<<(ImageView<T> image) noexcept {
         auto variable_uid = _kernel.arguments()[_argument_index++].uid();
@@ -130,7 +160,7 @@ struct ShaderInvoke {
 
 template<>
 struct ShaderInvoke<1> : public ShaderInvokeBase {
-    explicit ShaderInvoke(uint64_t handle, Function kernel) noexcept : ShaderInvokeBase{handle, kernel} {}
+    explicit ShaderInvoke(const ShaderDispatchCommand *prototype) noexcept : ShaderInvokeBase{prototype} {}
     [[nodiscard]] auto dispatch(uint size_x) noexcept {
         return _parallelize(uint3{size_x, 1u, 1u});
     }
@@ -138,7 +168,7 @@ struct ShaderInvoke<1> : public ShaderInvokeBase {
 
 template<>
 struct ShaderInvoke<2> : public ShaderInvokeBase {
-    explicit ShaderInvoke(uint64_t handle, Function kernel) noexcept : ShaderInvokeBase{handle, kernel} {}
+    explicit ShaderInvoke(const ShaderDispatchCommand *prototype) noexcept : ShaderInvokeBase{prototype} {}
     [[nodiscard]] auto dispatch(uint size_x, uint size_y) noexcept {
         return _parallelize(uint3{size_x, size_y, 1u});
     }
@@ -149,7 +179,7 @@ struct ShaderInvoke<2> : public ShaderInvokeBase {
 
 template<>
 struct ShaderInvoke<3> : public ShaderInvokeBase {
-    explicit ShaderInvoke(uint64_t handle, Function kernel) noexcept : ShaderInvokeBase{handle, kernel} {}
+    explicit ShaderInvoke(const ShaderDispatchCommand *prototype) noexcept : ShaderInvokeBase{prototype} {}
     [[nodiscard]] auto dispatch(uint size_x, uint size_y, uint size_z) noexcept {
         return _parallelize(uint3{size_x, size_y, size_z});
     }
@@ -169,13 +199,15 @@ private:
     Device::Handle _device;
     uint64_t _handle{};
     std::shared_ptr<const detail::FunctionBuilder> _kernel;
+    std::unique_ptr<ShaderDispatchCommand> _prototype;
 
 private:
     friend class Device;
-    Shader(Device::Handle device, std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept
+    Shader(Device::Handle device, std::shared_ptr<const detail::FunctionBuilder> kernel, const CompileOptions &options) noexcept
         : _device{std::move(device)},
-          _handle{_device->create_shader(kernel.get())},
-          _kernel{std::move(kernel)} {}
+          _handle{detail::create_shader(_device.get(), kernel.get(), options)},
+          _kernel{std::move(kernel)},
+          _prototype{detail::make_shader_dispatch_prototype(_handle, _kernel.get())} {}
 
     void _destroy() noexcept {
         if (*this) { _device->destroy_shader(_handle); }
@@ -188,7 +220,8 @@ public:
     Shader(Shader &&another) noexcept
         : _device{std::move(another._device)},
           _handle{another._handle},
-          _kernel{std::move(another._kernel)} {}
+          _kernel{std::move(another._kernel)},
+          _prototype{std::move(another._prototype)} {}
 
     Shader &operator=(Shader &&rhs) noexcept {
         if (this != &rhs) {
@@ -196,13 +229,14 @@ public:
             _device = std::move(rhs._device);
             _handle = rhs._handle;
             _kernel = std::move(rhs._kernel);
+            _prototype = std::move(rhs._prototype);
         }
         return *this;
     }
 
     [[nodiscard]] explicit operator bool() const noexcept { return _device != nullptr; }
     [[nodiscard]] auto operator()(detail::prototype_to_shader_invocation_t<Args>... args) const noexcept {
-        detail::ShaderInvoke<dimension> invoke{_handle, _kernel.get()};
+        detail::ShaderInvoke<dimension> invoke{_prototype.get()};
         (invoke << ... << args);
         return invoke;
     }
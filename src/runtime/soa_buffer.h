@@ -0,0 +1,131 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#pragma once
+
+#include <vector>
+
+#include <core/concepts.h>
+#include <ast/type_registry.h>
+#include <runtime/command.h>
+#include <runtime/device.h>
+
+namespace luisa::compute {
+
+namespace detail {
+template<typename T>
+struct Expr;
+}
+
+// Structure-of-arrays buffer of a LUISA_STRUCT type: each member is stored
+// in its own contiguous buffer, in the order of Type::members(). Kernels
+// access elements as if they were in a Buffer<T>, e.g. soa[i].t_max, and
+// only load or store the members they touch (all member arrays are bound,
+// though). Moving data from or to a Buffer<T> is a kernel assignment, e.g.
+// soa[i] = aos[i]. Kernels take SoABuffer<T> arguments as one buffer
+// argument per member, and the trace commands of Geometry accept
+// SoABuffer<Ray> and SoABuffer<Hit>.
+template<typename T>
+class SoABuffer : public concepts::Noncopyable {
+
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(std::is_trivially_destructible_v<T>);
+
+private:
+    Device::Handle _device;
+    size_t _size{};
+    std::vector<uint64_t> _handles;
+
+private:
+    friend class Device;
+    SoABuffer(Device::Handle device, size_t size) noexcept
+        : _device{std::move(device)},
+          _size{size} {
+        auto type = Type::of<T>();
+        if (!type->is_structure()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Invalid SoA buffer element type {}.",
+                type->description());
+        }
+        _handles.reserve(type->members().size());
+        for (auto member : type->members()) {
+            _handles.emplace_back(_device->create_buffer(size * member->size()));
+        }
+    }
+
+    void _destroy() noexcept {
+        if (*this) {
+            for (auto handle : _handles) { _device->destroy_buffer(handle); }
+        }
+    }
+
+    template<typename M>
+    [[nodiscard]] auto _member_handle(size_t index) const noexcept {
+        auto members = Type::of<T>()->members();
+        if (index >= members.size() || *members[index] != *Type::of<M>()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Invalid member #{} with type {} in SoA buffer of {}.",
+                index, Type::of<M>()->description(), Type::of<T>()->description());
+        }
+        return _handles[index];
+    }
+
+public:
+    SoABuffer() noexcept = default;
+
+    SoABuffer(SoABuffer &&another) noexcept
+        : _device{std::move(another._device)},
+          _size{another._size},
+          _handles{std::move(another._handles)} {}
+
+    SoABuffer &operator=(SoABuffer &&rhs) noexcept {
+        if (&rhs != this) {
+            _destroy();
+            _device = std::move(rhs._device);
+            _size = rhs._size;
+            _handles = std::move(rhs._handles);
+        }
+        return *this;
+    }
+
+    ~SoABuffer() noexcept { _destroy(); }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return _device != nullptr; }
+
+    [[nodiscard]] auto size() const noexcept { return _size; }
+    [[nodiscard]] auto member_count() const noexcept { return _handles.size(); }
+    [[nodiscard]] auto member_handles() const noexcept { return std::span{_handles}; }
+
+    // type of the buffer holding the array of a member
+    [[nodiscard]] static auto member_buffer_type(const Type *member) noexcept {
+        return Type::from(fmt::format(FMT_STRING("buffer<{}>"), member->description()));
+    }
+
+    // uploads/downloads the array of member #index, e.g. all t_max's of rays
+    template<typename M>
+    [[nodiscard]] auto copy_member_from(size_t index, const M *data) const noexcept {
+        return BufferUploadCommand::create(_member_handle<M>(index), 0u, _size * sizeof(M), data);
+    }
+
+    template<typename M>
+    [[nodiscard]] auto copy_member_to(size_t index, M *data) const noexcept {
+        return BufferDownloadCommand::create(_member_handle<M>(index), 0u, _size * sizeof(M), data);
+    }
+
+    template<typename I>
+    [[nodiscard]] decltype(auto) operator[](I &&i) const noexcept {
+        return detail::Expr<SoABuffer<T>>{*this}[std::forward<I>(i)];
+    }
+};
+
+template<typename T>
+struct is_soa_buffer : std::false_type {};
+
+template<typename T>
+struct is_soa_buffer<SoABuffer<T>> : std::true_type {};
+
+template<typename T>
+constexpr auto is_soa_buffer_v = is_soa_buffer<T>::value;
+
+}// namespace luisa::compute
@@ -3,11 +3,13 @@
 //
 
 #include <utility>
+#include <core/trace.h>
 #include <runtime/stream.h>
 
 namespace luisa::compute {
 
 void Stream::_dispatch(CommandList command_buffer) noexcept {
+    LUISA_TRACE(trace_event_id("stream::dispatch"), _handle);
     _device->dispatch(_handle, std::move(command_buffer));
 }
 
@@ -30,7 +32,10 @@ Stream &Stream::operator=(Stream &&rhs) noexcept {
     return *this;
 }
 
-void Stream::_synchronize() noexcept { _device->synchronize_stream(_handle); }
+void Stream::_synchronize() noexcept {
+    LUISA_TRACE(trace_event_id("stream::synchronize"), _handle);
+    _device->synchronize_stream(_handle);
+}
 
 Stream &Stream::operator<<(Event::Signal signal) noexcept {
     _device->signal_event(signal.handle, _handle);
@@ -52,6 +57,12 @@ Stream &Stream::operator<<(Stream::Synchronize) noexcept {
     return *this;
 }
 
+Stream &Stream::operator<<(CommandGraph &graph) noexcept {
+    LUISA_TRACE(trace_event_id("stream::replay"), _handle);
+    graph._replay(_handle);
+    return *this;
+}
+
 Stream::Delegate::~Delegate() noexcept { _commit(); }
 
 Stream::Delegate::Delegate(Stream *s) noexcept : _stream{s} {}
@@ -89,4 +100,10 @@ Stream::Delegate &&Stream::Delegate::operator<<(Stream::Synchronize) &&noexcept
     return std::move(*this);
 }
 
+Stream::Delegate &&Stream::Delegate::operator<<(CommandGraph &graph) &&noexcept {
+    _commit();
+    *_stream << graph;
+    return std::move(*this);
+}
+
 }// namespace luisa::compute
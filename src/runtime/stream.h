@@ -11,6 +11,7 @@
 #include <runtime/event.h>
 #include <runtime/command_list.h>
 #include <runtime/command_buffer.h>
+#include <runtime/command_graph.h>
 
 namespace luisa::compute {
 
@@ -40,6 +41,7 @@ public:
         Delegate &&operator<<(Event::Signal signal) &&noexcept;
         Delegate &&operator<<(Event::Wait wait) &&noexcept;
         Delegate &&operator<<(Synchronize) &&noexcept;
+        Delegate &&operator<<(CommandGraph &graph) &&noexcept;
     };
 
 private:
@@ -64,6 +66,7 @@ public:
     Stream &operator<<(Event::Signal signal) noexcept;
     Stream &operator<<(Event::Wait wait) noexcept;
     Stream &operator<<(Synchronize) noexcept;
+    Stream &operator<<(CommandGraph &graph) noexcept;
     void synchronize() noexcept { _synchronize(); }
     Delegate operator<<(Command *cmd) noexcept;
     [[nodiscard]] auto command_buffer() noexcept { return CommandBuffer{this}; }
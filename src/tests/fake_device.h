@@ -4,8 +4,16 @@
 
 #pragma once
 
+#include <span>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include <core/logging.h>
 #include <runtime/device.h>
 #include <runtime/context.h>
+#include <runtime/command.h>
+#include <compile/cpp_codegen.h>
 
 namespace luisa::compute {
 
@@ -24,7 +32,7 @@ public:
     void destroy_stream(uint64_t) noexcept override {}
     void synchronize_stream(uint64_t stream_handle) noexcept override {}
     void dispatch(uint64_t stream_handle, CommandList) noexcept override {}
-    uint64_t create_shader(Function kernel) noexcept override { return _handle++; }
+    uint64_t create_shader(Function kernel, const CompileOptions &options) noexcept override { return _handle++; }
     void destroy_shader(uint64_t handle) noexcept override {}
     uint64_t create_texture(PixelFormat format, uint dimension, uint width, uint height, uint depth, uint mipmap_levels,
                             TextureSampler sampler, uint64_t heap_handle, uint32_t index_in_heap) override { return _handle++; }
@@ -34,14 +42,9 @@ public:
     void destroy_event(uint64_t handle) noexcept override {}
     void signal_event(uint64_t handle, uint64_t stream_handle) noexcept override {}
     void wait_event(uint64_t handle, uint64_t stream_handle) noexcept override {}
-    virtual uint64_t create_mesh(uint64_t stream_handle,
-                                 uint64_t vertex_buffer_handle, size_t vertex_buffer_offset_bytes, size_t vertex_count,
-                                 uint64_t index_buffer_handle, size_t index_buffer_offset_bytes, size_t triangle_count) noexcept override { return _handle++; }
+    virtual uint64_t create_mesh() noexcept override { return _handle++; }
     virtual void destroy_mesh(uint64_t handle) noexcept override {}
-    virtual uint64_t create_accel(uint64_t stream_handle,
-                                  uint64_t mesh_handle_buffer_handle, size_t mesh_handle_buffer_offset_bytes,
-                                  uint64_t transform_buffer_handle, size_t transform_buffer_offset_bytes,
-                                  size_t mesh_count) noexcept override { return _handle++; }
+    virtual uint64_t create_accel() noexcept override { return _handle++; }
     virtual void destroy_accel(uint64_t handle) noexcept override {}
 
     [[nodiscard]] static auto create(const Context &ctx) noexcept {
@@ -53,4 +56,104 @@ public:
     virtual void destroy_texture_heap(uint64_t handle) noexcept override {}
 };
 
+// records what the runtime asks of the backend, for tests that check the
+// generated kernels and the dispatched commands without running them
+class RecordingDevice : public FakeDevice {
+
+public:
+    struct Dispatch {
+        uint3 dispatch_size;
+        std::vector<uint64_t> buffers;
+        std::vector<uint64_t> accels;
+        std::vector<std::vector<std::byte>> uniforms;
+
+        template<typename T>
+        [[nodiscard]] auto uniform(size_t i) const noexcept {
+            T value;
+            std::memcpy(&value, uniforms[i].data(), sizeof(T));
+            return value;
+        }
+    };
+
+public:
+    std::vector<std::string> sources;// generated by CppCodegen for each shader
+    std::vector<CompileOptions> options;
+    std::vector<Dispatch> dispatches;
+    std::vector<const Command *> commands;// all dispatched commands, in order
+    uint copy_count{0u};
+
+    // when set, compile_shader_binary() exports the generated source as the
+    // binary, and create_shader_from_binary() records the loaded binaries
+    bool export_binaries{false};
+    std::vector<std::string> loaded_binaries;
+
+public:
+    explicit RecordingDevice(const Context &ctx) noexcept : FakeDevice{ctx} {}
+
+    [[nodiscard]] static auto create(const Context &ctx) noexcept {
+        auto deleter = [](Device::Interface *d) { delete d; };
+        return Device{Device::Handle{new RecordingDevice{ctx}, deleter}};
+    }
+    [[nodiscard]] static auto of(const Device &device) noexcept {
+        return static_cast<RecordingDevice *>(device.impl());
+    }
+
+    // dispatch_size.x of the recorded dispatches, in order
+    [[nodiscard]] auto dispatch_widths() const noexcept {
+        std::vector<uint> widths;
+        for (auto &&d : dispatches) { widths.emplace_back(d.dispatch_size.x); }
+        return widths;
+    }
+
+    [[nodiscard]] static auto generate(Function kernel) noexcept {
+        Codegen::Scratch scratch;
+        CppCodegen codegen{scratch};
+        codegen.emit(kernel);
+        return std::string{scratch.view()};
+    }
+
+    uint64_t create_shader(Function kernel, const CompileOptions &o) noexcept override {
+        auto &&source = sources.emplace_back(generate(kernel));
+        LUISA_VERBOSE("{}", source);
+        options.emplace_back(o);
+        return FakeDevice::create_shader(kernel, o);
+    }
+
+    std::vector<std::byte> compile_shader_binary(Function kernel, const CompileOptions &) noexcept override {
+        if (!export_binaries) { return {}; }
+        auto source = generate(kernel);
+        std::vector<std::byte> binary(source.size());
+        std::memcpy(binary.data(), source.data(), source.size());
+        return binary;
+    }
+
+    uint64_t create_shader_from_binary(Function kernel, const CompileOptions &o, std::span<const std::byte> binary) noexcept override {
+        loaded_binaries.emplace_back(reinterpret_cast<const char *>(binary.data()), binary.size());
+        options.emplace_back(o);
+        return FakeDevice::create_shader(kernel, o);
+    }
+
+    void dispatch(uint64_t, CommandList commands) noexcept override {
+        for (auto command : commands) {
+            this->commands.emplace_back(command);
+            if (auto d = dynamic_cast<const ShaderDispatchCommand *>(command)) {
+                auto &&record = dispatches.emplace_back();
+                record.dispatch_size = d->dispatch_size();
+                d->decode([&record](auto, auto argument) noexcept {
+                    using Argument = decltype(argument);
+                    if constexpr (std::is_same_v<Argument, ShaderDispatchCommand::BufferArgument>) {
+                        record.buffers.emplace_back(argument.handle);
+                    } else if constexpr (std::is_same_v<Argument, ShaderDispatchCommand::AccelArgument>) {
+                        record.accels.emplace_back(argument.handle);
+                    } else if constexpr (std::is_same_v<Argument, std::span<const std::byte>>) {
+                        record.uniforms.emplace_back(argument.begin(), argument.end());
+                    }
+                });
+            } else if (dynamic_cast<const BufferCopyCommand *>(command) != nullptr) {
+                copy_count++;
+            }
+        }
+    }
+};
+
 }// namespace luisa::compute
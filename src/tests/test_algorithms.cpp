@@ -0,0 +1,84 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <algorithms/reduce.h>
+#include <algorithms/scan.h>
+#include <algorithms/compact.h>
+#include <algorithms/histogram.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    luisa::log_level_verbose();
+
+    // block counts per level, with at least one block
+    auto same_levels = [](size_t count, std::vector<size_t> expected) noexcept {
+        return luisa::compute::detail::parallel_primitive_levels(count) == expected;
+    };
+    if (!same_levels(0u, {1u}) || !same_levels(256u, {1u}) ||
+        !same_levels(257u, {2u, 1u}) || !same_levels(1000000u, {3907u, 16u, 1u})) {
+        LUISA_ERROR_WITH_LOCATION("Invalid parallel primitive levels.");
+    }
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+
+    // affine maps x -> a * x + b compose in order, but do not commute
+    Callable<float2(float2, float2)> compose = [](Float2 f, Float2 g) noexcept {
+        return make_float2(g.x * f.x, g.x * f.y + g.y);
+    };
+    Callable<float(float, float)> sum = [](Float a, Float b) noexcept { return a + b; };
+    Callable<bool(float)> positive = [](Float x) noexcept { return x > 0.0f; };
+    Callable<uint(float)> bucket = [](Float x) noexcept { return cast<uint>(x * 64.0f); };
+
+    Reduce<float> reduce{device, 1000000u, sum, 0.0f};
+    Scan<float2> scan{device, 100000u, compose, make_float2(1.0f, 0.0f)};
+    CompactIf<float> compact{device, 1000u, positive};
+    Histogram<float> histogram{device, 64u, bucket};
+    Histogram<float> large_histogram{device, 10000u, bucket};
+    auto &&sources = recorder->sources;
+    auto shared_histograms = std::count_if(sources.cbegin(), sources.cend(), [](auto &&s) noexcept {
+        return s.find("atomic_fetch_add") != std::string::npos && s.find("__shared__") != std::string::npos;
+    });
+    if (shared_histograms != 1u) {
+        LUISA_ERROR_WITH_LOCATION("Expected 1 histogram in shared memory, found {}.", shared_histograms);
+    }
+
+    auto stream = device.create_stream();
+    auto values = device.create_buffer<float>(1000000u);
+    auto maps = device.create_buffer<float2>(70000u);
+    auto composed = device.create_buffer<float2>(70000u);
+    auto compacted = device.create_buffer<float>(1000u);
+    auto result = device.create_buffer<float>(1u);
+    auto count = device.create_buffer<uint>(1u);
+    auto bins = device.create_buffer<uint>(64u);
+    stream << reduce(values, result)
+           << scan.exclusive(maps, composed)
+           << compact(values.view(0u, 1000u), compacted, count)
+           << histogram(values.view(0u, 1000u), bins)
+           << reduce(values.view(0u, 0u), result);
+
+    std::vector<uint> expected_sizes{
+        3907u * 256u, 16u * 256u, 256u,                       // reduce
+        274u * 256u, 2u * 256u, 256u, 2u * 256u, 274u * 256u, // scan, with block offsets added back
+        1024u, 1024u, 256u, 1024u, 1024u,                     // compact: mark, scan, scatter
+        256u, 1024u,                                          // histogram: clear, count
+        256u};                                                // empty reduce
+    if (recorder->dispatch_widths() != expected_sizes) {
+        LUISA_ERROR_WITH_LOCATION("Unexpected dispatches of the parallel primitives.");
+    }
+    LUISA_INFO("Parallel primitives validated.");
+}
@@ -49,4 +49,23 @@ int main(int argc, char *argv[]) {
     auto time = clock.toc();
 
     LUISA_INFO("Count: {}, Time: {} ms", host_buffer, time);
+
+    // film accumulation: float splats go through atomic float adds
+    Kernel1D splat_kernel = [](BufferFloat4 film, BufferFloat weights, BufferFloat2 bounds) noexcept {
+        Shared<float> tile_weights{64};
+        auto i = dispatch_id().x;
+        Var w = weights[i];
+        tile_weights[thread_id().x % 64u] = 0.0f;
+        group_memory_barrier();
+        Var old_weight = tile_weights.atomic(thread_id().x % 64u).fetch_add(w);
+        Var old_value = film.atomic(i % 16u).fetch_add(make_float4(w, w * w, 1.0f, 0.0f));
+        Var old_min = bounds.atomic(0u).fetch_min(make_float2(w, -w));
+        Var old_max = weights.atomic(0u).fetch_max(w);
+    };
+    auto splat = device.compile(splat_kernel);
+    auto film = device.create_buffer<float4>(16u);
+    auto weights = device.create_buffer<float>(1024u);
+    auto bounds = device.create_buffer<float2>(1u);
+    stream << splat(film, weights, bounds).dispatch(1024u)
+           << synchronize();
 }
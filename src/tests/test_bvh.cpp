@@ -0,0 +1,169 @@
+//
+// Created by Mike Smith on 2021/7/6.
+//
+
+#include <random>
+#include <algorithm>
+#include <vector>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/mathematics.h>
+#include <rtx/bvh.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// checks that every triangle is referenced by exactly one leaf
+// and that every node encloses its children and triangles
+void validate(const BVH &bvh, std::span<const float3> vertices, std::span<const Triangle> triangles) noexcept {
+    auto nodes = bvh.nodes();
+    auto contains = [](const BVHNode &node, float3 p) noexcept {
+        return node.min[0] <= p.x && node.min[1] <= p.y && node.min[2] <= p.z &&
+               node.max[0] >= p.x && node.max[1] >= p.y && node.max[2] >= p.z;
+    };
+    std::vector<uint32_t> visits(triangles.size(), 0u);
+    std::vector<uint32_t> stack{0u};
+    while (!stack.empty()) {
+        auto &&node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.is_leaf()) {
+            for (auto i = node.index; i < node.index + node.count; i++) {
+                auto t = triangles[bvh.primitives()[i]];
+                visits[bvh.primitives()[i]]++;
+                for (auto v : t.i) {
+                    if (!contains(node, vertices[v])) {
+                        LUISA_ERROR_WITH_LOCATION("Leaf does not enclose its triangles.");
+                    }
+                }
+            }
+        } else {
+            for (auto c = node.index; c < node.index + 2u; c++) {
+                auto &&child = nodes[c];
+                if (!contains(node, make_float3(child.min[0], child.min[1], child.min[2])) ||
+                    !contains(node, make_float3(child.max[0], child.max[1], child.max[2]))) {
+                    LUISA_ERROR_WITH_LOCATION("Node does not enclose its children.");
+                }
+                stack.emplace_back(c);
+            }
+        }
+    }
+    if (std::any_of(visits.cbegin(), visits.cend(), [](auto n) { return n != 1u; })) {
+        LUISA_ERROR_WITH_LOCATION("Triangles are not referenced exactly once.");
+    }
+}
+
+int main() {
+
+    static constexpr auto triangle_count = 200000u;
+    std::mt19937 random{19980810u};
+    std::uniform_real_distribution<float> uniform{0.0f, 1.0f};
+    std::vector<float3> vertices;
+    std::vector<Triangle> triangles;
+    vertices.reserve(triangle_count * 3u);
+    triangles.reserve(triangle_count);
+    for (auto i = 0u; i < triangle_count; i++) {
+        auto center = make_float3(uniform(random), uniform(random), uniform(random)) * 100.0f;
+        for (auto v = 0u; v < 3u; v++) {
+            vertices.emplace_back(center + make_float3(uniform(random), uniform(random), uniform(random)));
+        }
+        triangles.emplace_back(Triangle{{i * 3u, i * 3u + 1u, i * 3u + 2u}});
+    }
+
+    BVH bvh;
+    Clock clock;
+    bvh.build(vertices, triangles);
+    LUISA_INFO("Built BVH with {} nodes in {} ms.", bvh.nodes().size(), clock.toc());
+    validate(bvh, vertices, triangles);
+
+    // host-memory backends pass buffer addresses as handles
+    auto command = MeshBuildCommand::create(
+        0u, reinterpret_cast<uint64_t>(vertices.data()), 0u, vertices.size(),
+        reinterpret_cast<uint64_t>(triangles.data()), 0u, triangles.size() / 2u);
+    BVH half;
+    build_host_mesh(half, command);
+    command->recycle();
+    validate(half, vertices, std::span{triangles}.subspan(0u, triangles.size() / 2u));
+    LUISA_INFO("BVH validated.");
+
+    // small deformations are refit in place
+    auto deformed = vertices;
+    for (auto &&v : deformed) { v += make_float3(uniform(random), uniform(random), uniform(random)) * 0.5f; }
+    auto mesh_update = MeshUpdateCommand::create(
+        0u, reinterpret_cast<uint64_t>(deformed.data()), 0u, deformed.size(),
+        reinterpret_cast<uint64_t>(triangles.data()), 0u, triangles.size());
+    auto built_nodes = bvh.nodes().size();
+    clock.tic();
+    if (update_host_mesh(bvh, mesh_update)) {
+        LUISA_ERROR_WITH_LOCATION("Small deformation rebuilt the BVH (degradation = {}).", bvh.sah_degradation());
+    }
+    LUISA_INFO("Refit BVH in {} ms (SAH cost = {}, degradation = {}).", clock.toc(), bvh.sah_cost(), bvh.sah_degradation());
+    mesh_update->recycle();
+    validate(bvh, deformed, triangles);
+    if (bvh.nodes().size() != built_nodes) {
+        LUISA_ERROR_WITH_LOCATION("Refit changed the BVH topology.");
+    }
+
+    // scrambling the vertices degrades the tree past the threshold
+    std::shuffle(deformed.begin(), deformed.end(), random);
+    if (!bvh.update(deformed, triangles)) {
+        LUISA_ERROR_WITH_LOCATION("Scrambled mesh was refit (degradation = {}).", bvh.sah_degradation());
+    }
+    if (bvh.sah_degradation() != 1.0f) {
+        LUISA_ERROR_WITH_LOCATION("Rebuilt BVH reports degradation {}.", bvh.sah_degradation());
+    }
+    validate(bvh, deformed, triangles);
+    bvh.build(vertices, triangles);
+    LUISA_INFO("BVH refit validated.");
+
+    // instance the two meshes many times; host mesh handles are BVH addresses
+    static constexpr auto instance_count = 100000u;
+    std::vector<uint64_t> mesh_handles;
+    std::vector<float3x4> transforms;
+    for (auto i = 0u; i < instance_count; i++) {
+        mesh_handles.emplace_back(reinterpret_cast<uint64_t>(i % 2u == 0u ? &bvh : &half));
+        transforms.emplace_back(make_float3x4(translation(make_float3(uniform(random), uniform(random), uniform(random)) * 1000.0f)));
+    }
+    TopLevelBVH accel;
+    auto accel_build = AccelBuildCommand::create(0u, mesh_handles, transforms);
+    clock.tic();
+    build_host_accel(accel, accel_build);
+    LUISA_INFO("Built top-level BVH with {} nodes in {} ms.", accel.nodes().size(), clock.toc());
+    accel_build->recycle();
+
+    auto validate_accel = [&] {
+        std::vector<uint32_t> visits(instance_count, 0u);
+        for (auto &&node : accel.nodes()) {
+            if (!node.is_leaf()) { continue; }
+            for (auto i = node.index; i < node.index + node.count; i++) {
+                auto &&instance = accel.instances()[accel.primitives()[i]];
+                auto &&root = instance.mesh->nodes().front();
+                auto p = instance.transform * make_float4(root.min[0], root.min[1], root.min[2], 1.0f);
+                if (p.x < node.min[0] || p.y < node.min[1] || p.z < node.min[2]) {
+                    LUISA_ERROR_WITH_LOCATION("Leaf does not enclose its instances.");
+                }
+                visits[accel.primitives()[i]]++;
+            }
+        }
+        if (std::any_of(visits.cbegin(), visits.cend(), [](auto n) { return n != 1u; })) {
+            LUISA_ERROR_WITH_LOCATION("Instances are not referenced exactly once.");
+        }
+    };
+    validate_accel();
+
+    // moving instances together only refits the top level
+    auto mesh_nodes = bvh.nodes().data();
+    for (auto &&t : transforms) { t = make_float3x4(translation(make_float3(500.0f)) * make_float4x4(t)); }
+    auto accel_update = AccelUpdateCommand::create(0u, transforms);
+    clock.tic();
+    if (update_host_accel(accel, accel_update)) {
+        LUISA_ERROR_WITH_LOCATION("Translated instances rebuilt the top-level BVH.");
+    }
+    LUISA_INFO("Updated top-level BVH in {} ms (degradation = {}).", clock.toc(), accel.sah_degradation());
+    accel_update->recycle();
+    validate_accel();
+    if (bvh.nodes().data() != mesh_nodes) {
+        LUISA_ERROR_WITH_LOCATION("Mesh BVH was touched by a top-level update.");
+    }
+    LUISA_INFO("Top-level BVH validated.");
+}
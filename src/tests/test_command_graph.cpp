@@ -0,0 +1,115 @@
+//
+// Created by Mike Smith on 2021/7/5.
+//
+
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <runtime/buffer.h>
+#include <runtime/command_graph.h>
+#include <rtx/ray.h>
+#include <rtx/hit.h>
+#include <rtx/geometry.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+
+    Kernel1D scale_kernel = [](BufferVar<float> buffer, Var<float> scale) noexcept {
+        Var i = dispatch_id().x;
+        buffer[i] = buffer[i] * scale;
+    };
+    auto shader = device.compile(scale_kernel);
+    auto stream = device.create_stream();
+    auto buffer = device.create_buffer<float>(1024u);
+    auto another_buffer = device.create_buffer<float>(1024u);
+    std::vector<float> host(1024u, 1.0f);
+
+    auto graph = device.create_command_graph();
+    graph << buffer.copy_from(host.data());
+    auto node = graph.add(shader(buffer, 2.0f).dispatch(1024u));
+    graph << buffer.copy_to(host.data());
+
+    stream << graph;
+    auto deps = graph.dependencies(node);
+    if (graph.size() != 3u || deps.size() != 1u || deps[0] != 0u ||
+        graph.dependencies(2u).size() != 1u || graph.dependencies(2u)[0] != node) {
+        LUISA_ERROR_WITH_LOCATION("Unexpected command graph dependencies.");
+    }
+
+    graph.set_uniform(node, 1u, 0.5f);
+    graph.set_dispatch_size(node, make_uint3(512u, 1u, 1u));
+    stream << graph;
+
+    graph.set_buffer(node, 0u, another_buffer);
+    if (graph.planned()) { LUISA_ERROR_WITH_LOCATION("Rebinding should invalidate the plan."); }
+    stream << graph << synchronize();
+
+    auto &&dispatches = recorder->dispatches;
+    std::vector<float> scales;
+    for (auto &&d : dispatches) { scales.emplace_back(d.uniform<float>(0u)); }
+    if (scales != std::vector{2.0f, 0.5f, 0.5f} ||
+        dispatches[1].dispatch_size.x != 512u ||
+        dispatches[2].buffers[0] == dispatches[0].buffers[0]) {
+        LUISA_ERROR_WITH_LOCATION("Command graph replay mismatch.");
+    }
+    // the buffer is no longer shared with the upload/download after rebinding
+    if (!graph.dependencies(node).empty()) {
+        LUISA_ERROR_WITH_LOCATION("Unexpected dependencies after rebinding.");
+    }
+    // replays encode the commands of the graph in place
+    recorder->commands.clear();
+    stream << graph << graph << synchronize();
+    for (auto i = 0u; i < recorder->commands.size(); i++) {
+        if (recorder->commands[i] != graph.node(i % graph.size())) {
+            LUISA_ERROR_WITH_LOCATION("Command #{} is not replayed in place.", i);
+        }
+    }
+    LUISA_INFO("Replayed command graph with {} node(s) 5 times.", graph.size());
+
+    // traces wait for accel builds, which wait for all mesh builds
+    auto vertices = device.create_buffer<float3>(3u);
+    auto triangles = device.create_buffer<Triangle>(1u);
+    auto rays = device.create_buffer<Ray>(1024u);
+    auto hits = device.create_buffer<Hit>(1024u);
+    auto mesh = device.impl()->create_mesh();
+    auto another_mesh = device.impl()->create_mesh();
+    auto accel = device.impl()->create_accel();
+    std::array instance_meshes{mesh, another_mesh};
+    std::array instance_transforms{luisa::make_float3x4(luisa::make_float4x4(1.0f)),
+                                   luisa::make_float3x4(luisa::make_float4x4(1.0f))};
+    auto no_buffer = AccelTraceClosestCommand::no_buffer;
+    auto rtx_graph = device.create_command_graph();
+    auto build_mesh = rtx_graph.add(MeshBuildCommand::create(
+        mesh, vertices.view().handle(), 0u, 3u, triangles.view().handle(), 0u, 1u));
+    auto build_another_mesh = rtx_graph.add(MeshBuildCommand::create(
+        another_mesh, vertices.view().handle(), 0u, 3u, triangles.view().handle(), 0u, 1u));
+    auto build_accel = rtx_graph.add(AccelBuildCommand::create(
+        accel, std::span<const uint64_t>{instance_meshes}, std::span<const float3x4>{instance_transforms}));
+    auto trace = rtx_graph.add(AccelTraceClosestCommand::create(
+        accel, rays.view().handle(), 0u, no_buffer, 0u, hits.view().handle(), 0u, no_buffer, 0u, 1024u));
+    auto update_mesh = rtx_graph.add(MeshUpdateCommand::create(
+        mesh, vertices.view().handle(), 0u, 3u, triangles.view().handle(), 0u, 1u));
+    stream << rtx_graph << synchronize();
+    auto depends_on = [&rtx_graph](auto node, auto dependency) noexcept {
+        auto deps = rtx_graph.dependencies(node);
+        return std::find(deps.begin(), deps.end(), dependency) != deps.end();
+    };
+    if (!depends_on(build_accel, build_mesh) || !depends_on(build_accel, build_another_mesh) ||
+        !depends_on(trace, build_accel) || depends_on(trace, build_mesh) ||
+        !depends_on(update_mesh, build_mesh) || !depends_on(update_mesh, build_accel)) {
+        LUISA_ERROR_WITH_LOCATION("Unexpected mesh and accel dependencies.");
+    }
+    LUISA_INFO("Planned mesh and accel command dependencies.");
+}
@@ -0,0 +1,80 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <vector>
+#include <algorithm>
+
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/shader.h>
+#include <ast/function_serializer.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+
+    Kernel1D exp_kernel = [](BufferFloat x) noexcept {
+        auto i = dispatch_x();
+        x[i] = exp(x[i]) * rsqrt(x[i]);
+    };
+    auto kernel = exp_kernel.function()->function();
+
+    CompileOptions precise;
+    precise.fast_math = false;
+    precise.approximate_transcendentals = false;
+    precise.max_unroll = 4u;
+    precise.block_size = luisa::make_uint3(64u, 1u, 1u);
+    auto fast_shader = device.compile(exp_kernel);
+    auto precise_shader = device.compile(exp_kernel, precise);
+
+    auto &&recorded = recorder->options;
+    if (recorded.size() != 2u || !recorded[0].fast_math || !recorded[0].approximate_transcendentals ||
+        recorded[1].fast_math || recorded[1].max_unroll != 4u) {
+        LUISA_ERROR_WITH_LOCATION("Compile options are not passed to the backend.");
+    }
+    if (any(recorded[0].block_size_of(kernel) != kernel.block_size()) ||
+        any(recorded[1].block_size_of(kernel) != luisa::make_uint3(64u, 1u, 1u))) {
+        LUISA_ERROR_WITH_LOCATION("Invalid block size overrides.");
+    }
+
+    // kernels reading block_size() only take overrides that agree with it
+    Kernel1D stride_kernel = [](BufferUInt x) noexcept {
+        set_block_size(64u);
+        x[dispatch_x()] = block_size_x();
+    };
+    auto stride = stride_kernel.function()->function();
+    auto stride_blob = FunctionSerializer::serialize(stride);
+    if (kernel.block_size_used() || !stride.block_size_used() ||
+        !FunctionSerializer::deserialize(stride_blob)->function().block_size_used()) {
+        LUISA_ERROR_WITH_LOCATION("Block size reads are not tracked.");
+    }
+    auto stride_shader = device.compile(stride_kernel, precise);
+
+    // every option is part of the cache key
+    auto hash = FunctionSerializer::hash(kernel);
+    if (CompileOptions{}.hash(hash) != recorded[0].hash(hash) || precise.hash(hash) == recorded[0].hash(hash)) {
+        LUISA_ERROR_WITH_LOCATION("Invalid compile option hashes.");
+    }
+    std::vector<uint64_t> keys{CompileOptions{}.hash(hash)};
+    for (auto i = 0u; i < 4u; i++) {
+        auto o = CompileOptions{};
+        if (i == 0u) { o.fast_math = false; }
+        if (i == 1u) { o.approximate_transcendentals = false; }
+        if (i == 2u) { o.max_unroll = 1u; }
+        if (i == 3u) { o.block_size = luisa::make_uint3(128u, 1u, 1u); }
+        auto key = o.hash(hash);
+        if (std::find(keys.cbegin(), keys.cend(), key) != keys.cend()) {
+            LUISA_ERROR_WITH_LOCATION("Option #{} is not part of the cache key.", i);
+        }
+        keys.emplace_back(key);
+    }
+    LUISA_INFO("Compile options validated.");
+}
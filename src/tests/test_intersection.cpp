@@ -0,0 +1,125 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <compile/cpp_codegen.h>
+#include <rtx/intersection.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// lanes may be evaluated with different instructions, e.g. with fused multiply-adds
+[[nodiscard]] auto same_hit(const TriangleHit &a, const TriangleHit &b) noexcept {
+    auto close = [](float x, float y) noexcept { return std::abs(x - y) <= 1e-5f * std::max(std::abs(x), 1.0f); };
+    return a.lane == b.lane && (a.lane == ~0u || (close(a.t, b.t) && close(a.u, b.u) && close(a.v, b.v)));
+}
+
+int main(int argc, char *argv[]) {
+
+    std::mt19937 random{20210710u};
+    std::uniform_real_distribution<float> uniform{0.0f, 1.0f};
+    auto random_point = [&] { return make_float3(uniform(random), uniform(random), uniform(random)) * 2.0f - 1.0f; };
+    auto random_ray = [&] {
+        auto o = random_point() * 3.0f;
+        auto d = normalize(random_point() - o * 0.3f);
+        return Ray{{o.x, o.y, o.z}, 0.0f, {d.x, d.y, d.z}, 10.0f};
+    };
+    std::vector<PackedTriangle> triangles(8u);
+    for (auto &&t : triangles) {
+        auto v0 = random_point(), v1 = random_point(), v2 = random_point();
+        t = PackedTriangle{{v0.x, v0.y, v0.z}, {v1.x, v1.y, v1.z}, {v2.x, v2.y, v2.z}};
+    }
+
+    // 1 ray x 4/8 triangles and 4/8 rays x 1 triangle agree with single tests
+    auto hit_count = 0u;
+    for (auto i = 0u; i < 10000u; i++) {
+        IntersectionRay rays[8];
+        float t_max[8];
+        for (auto j = 0u; j < 8u; j++) {
+            auto r = random_ray();
+            rays[j] = make_intersection_ray(r);
+            t_max[j] = r.t_max;
+        }
+        for (auto count : {4u, 8u}) {
+            auto closest = TriangleHit{~0u, t_max[0], 0.0f, 0.0f};
+            for (auto j = 0u; j < count; j++) {
+                if (auto h = intersect_triangle(rays[0], triangles[j], closest.t); h.lane != ~0u) {
+                    closest = h;
+                    closest.lane = j;
+                }
+            }
+            auto h = count == 4u ?
+                         intersect_triangles<4u>(rays[0], triangles.data(), count, t_max[0]) :
+                         intersect_triangles<8u>(rays[0], triangles.data(), count, t_max[0]);
+            if (!same_hit(h, closest)) {
+                LUISA_ERROR_WITH_LOCATION("Ray #{} disagrees on {} triangles.", i, count);
+            }
+        }
+        TriangleHit hits4[4], hits8[8];
+        auto mask4 = intersect_rays<4u>(rays, triangles[i % 8u], t_max, hits4);
+        auto mask8 = intersect_rays<8u>(rays, triangles[i % 8u], t_max, hits8);
+        for (auto j = 0u; j < 8u; j++) {
+            auto h = intersect_triangle(rays[j], triangles[i % 8u], t_max[j]);
+            auto expected = h.lane == 0u ? j : ~0u;
+            if (hits8[j].lane != expected || ((mask8 >> j) & 1u) != (h.lane == 0u) ||
+                (j < 4u && (hits4[j].lane != expected || ((mask4 >> j) & 1u) != (h.lane == 0u)))) {
+                LUISA_ERROR_WITH_LOCATION("Ray #{} disagrees in packet lane {}.", i, j);
+            }
+            hit_count += h.lane == 0u;
+        }
+    }
+    LUISA_INFO("Triangle tests validated ({} hit(s)).", hit_count);
+
+    // boxes: lanes agree with the single test, which contains the triangle hits
+    for (auto i = 0u; i < 10000u; i++) {
+        auto ray = make_intersection_ray(random_ray());
+        float min_x[4], min_y[4], min_z[4], max_x[4], max_y[4], max_z[4], t_near[4];
+        for (auto j = 0u; j < 4u; j++) {
+            auto &&t = triangles[j];
+            auto lo = luisa::min(luisa::min(make_float3(t.v0[0], t.v0[1], t.v0[2]), make_float3(t.v1[0], t.v1[1], t.v1[2])), make_float3(t.v2[0], t.v2[1], t.v2[2]));
+            auto hi = luisa::max(luisa::max(make_float3(t.v0[0], t.v0[1], t.v0[2]), make_float3(t.v1[0], t.v1[1], t.v1[2])), make_float3(t.v2[0], t.v2[1], t.v2[2]));
+            min_x[j] = lo.x, min_y[j] = lo.y, min_z[j] = lo.z;
+            max_x[j] = hi.x, max_y[j] = hi.y, max_z[j] = hi.z;
+        }
+        auto mask = intersect_boxes<4u>(ray, min_x, min_y, min_z, max_x, max_y, max_z, 10.0f, t_near);
+        for (auto j = 0u; j < 4u; j++) {
+            auto interval = intersect_box(ray, make_float3(min_x[j], min_y[j], min_z[j]), make_float3(max_x[j], max_y[j], max_z[j]), 10.0f);
+            auto overlapped = interval.x <= interval.y;
+            if (overlapped != (((mask >> j) & 1u) != 0u) || (overlapped && interval.x != t_near[j])) {
+                LUISA_ERROR_WITH_LOCATION("Ray #{} disagrees on box {}.", i, j);
+            }
+            if (auto h = intersect_triangle(ray, triangles[j], 10.0f);
+                h.lane == 0u && !(overlapped && h.t + 1e-5f >= interval.x && h.t <= interval.y)) {
+                LUISA_ERROR_WITH_LOCATION("Ray #{} hits triangle {} outside its box.", i, j);
+            }
+        }
+    }
+    LUISA_INFO("Box tests validated.");
+
+    // kernels call the same tests as callables
+    Context context{argv[0]};
+    auto device = FakeDevice::create(context);
+    Kernel1D intersect_kernel = [](BufferVar<Ray> rays, BufferVar<float3> vertices, BufferVar<TriangleHit> hits) noexcept {
+        auto i = dispatch_x();
+        Var ray = rays[i];
+        Var lo = min(min(vertices[0u], vertices[1u]), vertices[2u]);
+        Var hi = max(max(vertices[0u], vertices[1u]), vertices[2u]);
+        Var interval = intersect_box(ray, lo, hi);
+        if_(interval.x <= interval.y, [&] {
+            hits[i] = intersect_triangle(ray, vertices[0u], vertices[1u], vertices[2u]);
+        });
+    };
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(intersect_kernel.function()->function());
+    LUISA_INFO("Generated intersection kernel:\n{}", scratch.view());
+    auto shader = device.compile(intersect_kernel);
+}
@@ -0,0 +1,112 @@
+//
+// Created by Mike Smith on 2021/7/3.
+//
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/kernel_archive.h>
+#include <ast/function_serializer.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// writes a copy of the archive with one entry or header field patched
+template<typename Patch>
+[[nodiscard]] static auto patched(const std::filesystem::path &path, const std::string &suffix, Patch &&patch) noexcept {
+    std::ifstream input{path, std::ios::binary};
+    std::vector<char> bytes{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+    auto header = reinterpret_cast<KernelArchive::Header *>(bytes.data());
+    auto table = reinterpret_cast<KernelArchive::Entry *>(bytes.data() + header->table_offset);
+    patch(*header, std::span{table, header->table_capacity});
+    auto patched_path = path;
+    patched_path += suffix;
+    std::ofstream output{patched_path, std::ios::binary};
+    output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return patched_path;
+}
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+    recorder->export_binaries = true;
+
+    Kernel1D scale_kernel = [](BufferFloat x) noexcept {
+        auto i = dispatch_x();
+        x[i] = x[i] * 2.0f;
+    };
+    Kernel1D clear_kernel = [](BufferFloat x) noexcept {
+        x[dispatch_x()] = 0.0f;
+    };
+    CompileOptions precise;
+    precise.fast_math = false;
+
+    auto path = std::filesystem::temp_directory_path() / "test_kernel_archive.bin";
+    KernelArchive::Builder builder{device};
+    builder.add(scale_kernel).add(scale_kernel).add(scale_kernel, precise);
+    if (builder.size() != 2u || !builder.write(path)) {
+        LUISA_ERROR_WITH_LOCATION("Failed to build the kernel archive.");
+    }
+
+    // the archive maps hashes of kernels and options to their blobs
+    auto scale = scale_kernel.function()->function();
+    auto hash = FunctionSerializer::hash(scale);
+    auto archive = KernelArchive::open(path);
+    if (archive == nullptr || archive->size() != 2u || archive->backend() != device.impl()->backend()) {
+        LUISA_ERROR_WITH_LOCATION("Failed to open the kernel archive.");
+    }
+    auto entry = archive->find(CompileOptions{}.hash(hash));
+    if (entry == nullptr || archive->find(precise.hash(hash)) == nullptr ||
+        archive->find(CompileOptions{}.hash(FunctionSerializer::hash(clear_kernel.function()->function()))) != nullptr) {
+        LUISA_ERROR_WITH_LOCATION("Invalid kernel archive lookups.");
+    }
+    auto binary = archive->binary(*entry);
+    if (std::string_view{reinterpret_cast<const char *>(binary.data()), binary.size()} != RecordingDevice::generate(scale)) {
+        LUISA_ERROR_WITH_LOCATION("Archived binary mismatch.");
+    }
+    auto ast = archive->ast(*entry);
+    if (FunctionSerializer::serialize(FunctionSerializer::deserialize(ast)->function()) != FunctionSerializer::serialize(scale)) {
+        LUISA_ERROR_WITH_LOCATION("Archived AST mismatch.");
+    }
+
+    // archived kernels are loaded from binaries, others are compiled
+    if (!context.load_kernel_archive(path)) {
+        LUISA_ERROR_WITH_LOCATION("Failed to load the kernel archive.");
+    }
+    recorder->sources.clear();
+    auto scale_shader = device.compile(scale_kernel);
+    auto precise_shader = device.compile(scale_kernel, precise);
+    auto clear_shader = device.compile(clear_kernel);
+    if (recorder->loaded_binaries.size() != 2u || recorder->sources.size() != 1u ||
+        recorder->loaded_binaries[0] != RecordingDevice::generate(scale)) {
+        LUISA_ERROR_WITH_LOCATION("Archived kernels are not loaded from binaries.");
+    }
+
+    // corrupt tables are rejected instead of hanging lookups
+    auto full = patched(path, ".full", [](auto &&header, auto table) noexcept {
+        for (auto &&e : table) {
+            if (e.binary_offset == 0u) { e = *std::find_if(table.begin(), table.end(), [](auto &&e) noexcept { return e.binary_offset != 0u; }); }
+        }
+        header.entry_count = header.table_capacity;
+    });
+    auto overflow = patched(path, ".overflow", [](auto &&, auto table) noexcept {
+        for (auto &&e : table) {
+            if (e.binary_offset != 0u) { e.binary_size = ~0ull - e.binary_offset + 2u; }
+        }
+    });
+    if (KernelArchive::open(full) != nullptr || KernelArchive::open(overflow) != nullptr) {
+        LUISA_ERROR_WITH_LOCATION("Corrupt kernel archives are accepted.");
+    }
+    for (auto &&p : {path, full, overflow}) { std::filesystem::remove(p); }
+    LUISA_INFO("Kernel archives validated.");
+}
@@ -0,0 +1,76 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <string>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <ast/function_serializer.h>
+#include <compile/cpp_codegen.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    // storage types are laid out without padding
+    static_assert(sizeof(packed_float3) == 12u && alignof(packed_float3) == 4u);
+    static_assert(sizeof(float3x4) == 48u && sizeof(float4x4) == 64u);
+    if (Type::of<packed_float3>()->size() != 12u || Type::of<packed_float3>()->alignment() != 4u ||
+        Type::of<packed_uint3>()->size() != 12u || Type::of<float3x4>()->size() != 48u ||
+        Type::of<float3x4>()->alignment() != 16u || !Type::of<packed_int3>()->is_structure()) {
+        LUISA_ERROR_WITH_LOCATION("Invalid storage type descriptions.");
+    }
+
+    // host conversions round trip
+    constexpr auto p = make_packed_float3(float3{1.0f, 2.0f, 3.0f});
+    static_assert(make_float3(p).y == 2.0f && make_int3(make_packed_int3(int3{-1, 0, 1})).x == -1);
+    float4x4 m{float4{1.0f, 2.0f, 3.0f, 0.0f}, float4{4.0f, 5.0f, 6.0f, 0.0f},
+               float4{7.0f, 8.0f, 9.0f, 0.0f}, float4{10.0f, 11.0f, 12.0f, 1.0f}};
+    auto affine = make_float3x4(m);
+    if (affine.rows[0].w != 10.0f || affine.rows[2].y != 6.0f) {
+        LUISA_ERROR_WITH_LOCATION("Invalid float3x4 rows.");
+    }
+    auto back = make_float4x4(affine);
+    for (auto c = 0u; c < 4u; c++) {
+        if (any(back[c] != m[c])) {
+            LUISA_ERROR_WITH_LOCATION("Column {} is lost in the float3x4 round trip.", c);
+        }
+    }
+    LUISA_INFO("Host storage types validated.");
+
+    // kernels load and store them as float3 and float4x4
+    Context context{argv[0]};
+    auto device = FakeDevice::create(context);
+    Kernel1D transform_kernel = [](BufferVar<packed_float3> positions, BufferVar<float3x4> transforms,
+                                   BufferVar<packed_uint3> triangles) noexcept {
+        auto i = dispatch_x();
+        Float3 position = positions[i];
+        Float4x4 transform = transforms[i];
+        positions[i] = make_float3(transform * make_float4(position, 1.0f));
+        transforms[i] = inverse(transform);
+        UInt3 triangle = triangles[i];
+        triangles[i] = triangle.zxy();
+    };
+    auto kernel = transform_kernel.function()->function();
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(kernel);
+    std::string source{scratch.view()};
+    LUISA_INFO("Generated kernel:\n{}", source);
+    for (auto s : {"struct alignas(4) S", "struct alignas(16) S", "array<float4, 3>", "transpose(", ".m0 = ", ".m0[0u] = "}) {
+        if (source.find(s) == std::string::npos) {
+            LUISA_ERROR_WITH_LOCATION("Missing '{}' in generated source.", s);
+        }
+    }
+    auto blob = FunctionSerializer::serialize(kernel);
+    if (FunctionSerializer::serialize(FunctionSerializer::deserialize(blob)->function()) != blob) {
+        LUISA_ERROR_WITH_LOCATION("Storage types are lost in serialization.");
+    }
+    auto shader = device.compile(transform_kernel);
+    LUISA_INFO("Storage types validated.");
+}
@@ -0,0 +1,116 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <algorithms/radix_sort.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// stable sorts of (key, value) pairs by the lowest key_bits bits
+template<typename Key>
+[[nodiscard]] auto reference_sort(std::vector<std::pair<Key, uint>> pairs, uint key_bits) noexcept {
+    auto mask = key_bits == sizeof(Key) * 8u ? ~Key{0u} : (Key{1u} << key_bits) - 1u;
+    std::stable_sort(pairs.begin(), pairs.end(), [mask](auto lhs, auto rhs) noexcept {
+        return (lhs.first & mask) < (rhs.first & mask);
+    });
+    return pairs;
+}
+
+template<typename Key>
+void test_host_sort(std::mt19937_64 &random, uint key_bits) noexcept {
+    std::vector<Key> keys(10000u);
+    std::vector<uint> values(keys.size());
+    std::vector<std::pair<Key, uint>> pairs;
+    for (auto i = 0u; i < keys.size(); i++) {
+        keys[i] = static_cast<Key>(random());
+        values[i] = i;
+        pairs.emplace_back(keys[i], i);
+    }
+    auto expected = reference_sort(pairs, key_bits);
+    auto sorted_keys = keys;
+    radix_sort_keys(std::span{sorted_keys}, key_bits);
+    radix_sort_pairs(std::span{keys}, std::span{values}, key_bits);
+    for (auto i = 0u; i < keys.size(); i++) {
+        if (keys[i] != expected[i].first || values[i] != expected[i].second || sorted_keys[i] != keys[i]) {
+            LUISA_ERROR_WITH_LOCATION(
+                "Host radix sort of {}-byte keys over {} bits differs at element {}.",
+                sizeof(Key), key_bits, i);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    std::mt19937_64 random{20210710u};
+    for (auto key_bits : {1u, 12u, 32u}) { test_host_sort<uint32_t>(random, key_bits); }
+    for (auto key_bits : {20u, 33u, 64u}) { test_host_sort<uint64_t>(random, key_bits); }
+
+    // segments, including empty ones, are sorted on their own
+    std::vector<uint> offsets{0u, 0u, 100u, 101u, 5000u, 5000u, 10000u};
+    std::vector<uint> keys(10000u);
+    std::vector<uint> values(keys.size());
+    for (auto i = 0u; i < keys.size(); i++) {
+        keys[i] = static_cast<uint>(random());
+        values[i] = i;
+    }
+    auto segmented_keys = keys;
+    auto segmented_values = values;
+    segmented_sort(segmented_keys, segmented_values, offsets, 16u);
+    for (auto s = 0u; s + 1u < offsets.size(); s++) {
+        std::vector<std::pair<uint, uint>> pairs;
+        for (auto i = offsets[s]; i < offsets[s + 1u]; i++) { pairs.emplace_back(keys[i], values[i]); }
+        auto expected = reference_sort(pairs, 16u);
+        for (auto i = 0u; i < expected.size(); i++) {
+            if (segmented_keys[offsets[s] + i] != expected[i].first || segmented_values[offsets[s] + i] != expected[i].second) {
+                LUISA_ERROR_WITH_LOCATION("Segmented sort differs at element {} of segment {}.", i, s);
+            }
+        }
+    }
+    LUISA_INFO("Host radix sorts validated.");
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+    RadixSort<uint> sort{device, 1000u};
+    RadixSort<uint2> sort64{device, 1000u};
+    SegmentedSort segmented{device, 1000u};
+
+    auto stream = device.create_stream();
+    auto device_keys = device.create_buffer<uint>(1000u);
+    auto device_keys64 = device.create_buffer<uint2>(1000u);
+    auto device_values = device.create_buffer<uint>(1000u);
+    auto device_offsets = device.create_buffer<uint>(11u);
+    stream << sort.sort_keys(device_keys, 12u);
+    if (recorder->copy_count != 1u) {
+        LUISA_ERROR_WITH_LOCATION("Odd pass counts should copy the sorted keys back.");
+    }
+    stream << sort64.sort_pairs(device_keys64, device_values)
+           << segmented(device_keys, device_values, device_offsets, 8u);
+    if (recorder->copy_count != 5u) {
+        LUISA_ERROR_WITH_LOCATION("Expected 5 copies, got {}.", recorder->copy_count);
+    }
+
+    // per pass: count digits, scan the counts over 4 blocks, scatter
+    std::vector<uint> pass{1024u, 256u, 1024u};
+    std::vector<uint> expected_sizes;
+    for (auto i = 0u; i < 3u; i++) { expected_sizes.insert(expected_sizes.end(), pass.cbegin(), pass.cend()); }
+    for (auto i = 0u; i < 16u; i++) { expected_sizes.insert(expected_sizes.end(), pass.cbegin(), pass.cend()); }
+    // 10 segments add 4 bits to the 8 key bits
+    expected_sizes.emplace_back(1024u);
+    for (auto i = 0u; i < 3u; i++) { expected_sizes.insert(expected_sizes.end(), pass.cbegin(), pass.cend()); }
+    expected_sizes.insert(expected_sizes.end(), {1024u, 1024u});
+    if (recorder->dispatch_widths() != expected_sizes) {
+        LUISA_ERROR_WITH_LOCATION("Unexpected dispatches of the radix sorts.");
+    }
+    LUISA_INFO("Radix sort commands validated.");
+}
@@ -0,0 +1,67 @@
+//
+// Created by Mike Smith on 2021/7/9.
+//
+
+#include <vector>
+
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <runtime/buffer.h>
+#include <algorithms/block.h>
+#include <rtx/ray_queue.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    luisa::log_level_verbose();
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+
+    // keep rays that still travel upwards
+    Callable<bool(Ray)> upwards = [](Var<Ray> ray) noexcept {
+        return ray.direction[1] > 0.0f;
+    };
+    RayQueue queue{device, upwards};
+    RayQueue default_queue{device};
+
+    static constexpr auto ray_count = 1000u;
+    auto stream = device.create_stream();
+    auto rays = device.create_buffer<Ray>(ray_count);
+    auto indices = device.create_buffer<uint>(ray_count);
+    auto sorted = device.create_buffer<uint>(ray_count);
+    auto count = device.create_buffer<uint>(1u);
+    {
+        auto command_buffer = stream.command_buffer();
+        queue.compact(command_buffer, rays, indices, count);
+        queue.sort(command_buffer, rays, indices, sorted, count, make_float3(-1.0f), make_float3(1.0f));
+        default_queue.compact(command_buffer, rays, sorted, indices, count);
+        command_buffer.commit();
+    }
+
+    std::vector<uint> expected_sizes{1u, ray_count, 1u, RayQueue::bucket_count, ray_count, parallel_primitive_block_size, ray_count, 1u, ray_count, 1u};
+    auto &&dispatches = recorder->dispatches;
+    if (dispatches.size() != expected_sizes.size()) {
+        LUISA_ERROR_WITH_LOCATION("Expected {} dispatches, got {}.", expected_sizes.size(), dispatches.size());
+    }
+    for (auto i = 0u; i < expected_sizes.size(); i++) {
+        if (dispatches[i].dispatch_size.x != expected_sizes[i]) {
+            LUISA_ERROR_WITH_LOCATION(
+                "Dispatch #{} has size {} instead of {}.",
+                i, dispatches[i].dispatch_size.x, expected_sizes[i]);
+        }
+    }
+    // the count is written last by compaction and read by sorting
+    auto &&compact_buffers = dispatches[2].buffers;
+    auto &&scatter_buffers = dispatches[6].buffers;
+    if (compact_buffers.back() != count.view().handle() ||
+        scatter_buffers[2] != sorted.view().handle() || scatter_buffers[3] != count.view().handle()) {
+        LUISA_ERROR_WITH_LOCATION("Ray queue buffers are bound incorrectly.");
+    }
+    LUISA_INFO("Ray queue commands validated.");
+}
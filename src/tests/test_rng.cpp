@@ -0,0 +1,81 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <vector>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <compile/cpp_codegen.h>
+#include <algorithms/rng.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    // known answers of Philox4x32-10 from Random123
+    struct KnownAnswer {
+        uint4 counter;
+        uint2 key;
+        uint4 result;
+    };
+    KnownAnswer philox_answers[]{
+        {make_uint4(0u), make_uint2(0u), make_uint4(0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u)},
+        {make_uint4(~0u), make_uint2(~0u), make_uint4(0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu)},
+        {make_uint4(0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u), make_uint2(0xa4093822u, 0x299f31d0u),
+         make_uint4(0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u)}};
+    for (auto &&[counter, key, result] : philox_answers) {
+        if (!all(philox4x32(counter, key) == result)) {
+            LUISA_ERROR_WITH_LOCATION("Philox4x32 disagrees with the known answers.");
+        }
+    }
+
+    // vectorized host streams match the scalar generators, tails included
+    std::vector<float> philox_values(1001u);
+    std::vector<float> squares_values(1001u);
+    auto key = make_uint2(20210710u, 42u);
+    philox_uniform(philox_values, 7u, key);
+    squares_uniform(squares_values, 7u);
+    auto sum = 0.0;
+    for (auto i = 0u; i < philox_values.size(); i++) {
+        auto x = philox4x32(make_uint4(i / 4u, 0u, 0u, 7u), key)[i % 4u];
+        auto y = squares32((uint64_t{7u} << 32u) | i, squares_default_key);
+        if (philox_values[i] != static_cast<float>(x >> 8u) * 0x1p-24f ||
+            squares_values[i] != static_cast<float>(y >> 8u) * 0x1p-24f ||
+            philox_values[i] >= 1.0f || squares_values[i] >= 1.0f) {
+            LUISA_ERROR_WITH_LOCATION("Host random streams differ at element {}.", i);
+        }
+        sum += philox_values[i] + squares_values[i];
+    }
+    if (auto mean = sum / 2002.0; mean < 0.45 || mean > 0.55) {
+        LUISA_ERROR_WITH_LOCATION("Biased random streams (mean = {}).", mean);
+    }
+    LUISA_INFO("Host random streams validated.");
+
+    // kernels seek the streams by dispatch id and sample index
+    Context context{argv[0]};
+    auto device = FakeDevice::create(context);
+    Kernel2D sample_kernel = [](BufferFloat4 samples, BufferFloat jitter, UInt sample_index, UInt2 key) noexcept {
+        auto id = dispatch_id();
+        auto index = id.y * dispatch_size_x() + id.x;
+        samples[index] = philox_uniform(id, sample_index, key);
+        jitter[index] = squares_uniform(index, sample_index, key);
+    };
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(sample_kernel.function()->function());
+    std::string source{scratch.view()};
+    LUISA_INFO("Generated kernel:\n{}", source);
+    if (auto callables = sample_kernel.function()->function().custom_callables().size(); callables != 2u) {
+        LUISA_ERROR_WITH_LOCATION("Expected 2 random number callables, got {}.", callables);
+    }
+    for (auto s : {"3528531795u", "2654435769u", "65535u"}) {
+        if (source.find(s) == std::string::npos) {
+            LUISA_ERROR_WITH_LOCATION("Missing '{}' in generated source.", s);
+        }
+    }
+    auto shader = device.compile(sample_kernel);
+}
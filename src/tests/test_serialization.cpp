@@ -0,0 +1,77 @@
+//
+// Created by Mike Smith on 2021/7/2.
+//
+
+#include <iostream>
+#include <numeric>
+
+#include <core/clock.h>
+#include <ast/function_serializer.h>
+#include <compile/cpp_codegen.h>
+#include <dsl/syntax.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+struct Pair {
+    float2 v;
+    uint n;
+};
+
+LUISA_STRUCT(Pair, v, n)
+
+int main() {
+
+    std::vector<int> const_vector(64u);
+    std::iota(const_vector.begin(), const_vector.end(), 0);
+
+    Callable lookup = [&](Var<int> i, Var<float> scale) noexcept {
+        Constant table = const_vector;
+        return cast<float>(table[i]) * scale;
+    };
+
+    Kernel1D<Buffer<float>, Buffer<Pair>, uint> kernel_def = [&](BufferVar<float> out, BufferVar<Pair> pairs, Var<uint> count) noexcept {
+        Shared<float> cache{32};
+        Var i = dispatch_id().x;
+        Var sum = 0.0f;
+        for (auto j : range(count)) {
+            sum += lookup(cast<int>(j % 64u), 0.5f);
+        }
+        Var p = pairs[i];
+        if_(p.n > 3u, [&] {
+            sum += p.v.x;
+        }).else_([&] {
+            sum -= p.v.yx().x;
+        });
+        switch_(p.n)
+            .case_(0u, [&] { sum = -sum; })
+            .default_([&] { sum *= 2.0f; });
+        while_(sum > 100.0f, [&] {
+            sum *= 0.5f;
+            if_(sum < 1.0f, [] { break_(); });
+        });
+        cache[thread_id().x % 32u] = sum;
+        out[i] = cache[thread_id().x % 32u] + cast<float>(make_uint2(i, count).y);
+    };
+
+    Clock clock;
+    auto kernel = kernel_def.function()->function();
+    auto blob = FunctionSerializer::serialize(kernel);
+    auto t_serialize = clock.toc();
+
+    clock.tic();
+    auto restored = FunctionSerializer::deserialize(blob);
+    auto t_deserialize = clock.toc();
+
+    // serializing the reconstructed AST again must produce the identical blob
+    auto blob_again = FunctionSerializer::serialize(restored->function());
+    if (blob_again != blob) {
+        LUISA_ERROR_WITH_LOCATION("Round-trip mismatch ({} vs. {} bytes).", blob.size(), blob_again.size());
+    }
+    LUISA_INFO("Serialized {} bytes in {} ms, deserialized in {} ms.", blob.size(), t_serialize, t_deserialize);
+
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(restored->function());
+    std::cout << scratch.view() << std::endl;
+}
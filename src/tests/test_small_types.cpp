@@ -0,0 +1,99 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <cmath>
+#include <string>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <ast/function_serializer.h>
+#include <compile/cpp_codegen.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    // every non-nan half survives the round trip through float
+    for (auto bits = 0u; bits < 0x10000u; bits++) {
+        auto h = half::from_bits(static_cast<uint16_t>(bits));
+        auto f = static_cast<float>(h);
+        if (std::isnan(f)) {
+            if ((bits & 0x7c00u) != 0x7c00u || (bits & 0x03ffu) == 0u || !std::isnan(static_cast<float>(half{f}))) {
+                LUISA_ERROR_WITH_LOCATION("Invalid nan conversion of half 0x{:04x}.", bits);
+            }
+        } else if (half{f}.bits() != bits) {
+            LUISA_ERROR_WITH_LOCATION("Half 0x{:04x} converts back to 0x{:04x}.", bits, half{f}.bits());
+        }
+    }
+    // ties round to even, and overflows to infinity
+    constexpr std::pair<float, uint16_t> conversions[]{
+        {1.0f, 0x3c00u}, {-2.0f, 0xc000u}, {65504.0f, 0x7bffu}, {65520.0f, 0x7c00u},
+        {1e10f, 0x7c00u}, {0x1p-24f, 0x0001u}, {0x1p-25f, 0x0000u}, {0x1.8p-24f, 0x0002u},
+        {1.0f + 0x1p-11f, 0x3c00u}, {1.0f + 0x3p-11f, 0x3c02u}, {-0.0f, 0x8000u}};
+    for (auto [f, bits] : conversions) {
+        if (half{f}.bits() != bits) {
+            LUISA_ERROR_WITH_LOCATION("Float {} converts to half 0x{:04x} instead of 0x{:04x}.", f, half{f}.bits(), bits);
+        }
+    }
+    static_assert(half{0.5f}.bits() == 0x3800u && static_cast<float>(half::from_bits(0x3555u)) == 0x1.554p-2f);
+    LUISA_INFO("Half conversions validated.");
+
+    // the new scalars pack into vectors the same way as 32-bit ones
+    if (Type::of<half4>()->size() != 8u || Type::of<half3>()->alignment() != 8u ||
+        Type::of<short2>()->size() != 4u || Type::of<ubyte3>()->size() != 4u ||
+        Type::of<byte>()->size() != 1u || Type::of<ushort>()->description() != "ushort" ||
+        Type::from("vector<ubyte,2>") != Type::of<ubyte2>() ||
+        Type::from("vector<half,3>") != Type::of<half3>() ||
+        !Type::of<half>()->is_scalar() || Type::of<byte4>()->element() != Type::of<byte>()) {
+        LUISA_ERROR_WITH_LOCATION("Invalid small type descriptions.");
+    }
+    static_assert(sizeof(half4) == 8u && alignof(half3) == 8u && sizeof(ubyte3) == 4u && sizeof(short2) == 4u);
+
+    // 16-bit colors are decoded to float and normals quantized to bytes
+    Context context{argv[0]};
+    auto device = FakeDevice::create(context);
+    Kernel1D decode_kernel = [](BufferVar<half4> colors, BufferVar<float3> normals,
+                                BufferVar<float4> decoded, BufferVar<byte4> packed, BufferVar<ushort> ids) noexcept {
+        auto i = dispatch_x();
+        Var scale = half4{half{0.5f}, half{1.0f}, half{-2.0f}, half{65504.0f}};
+        Var c = colors[i] * scale;
+        decoded[i] = c;
+        Var n = normals[i] * 127.0f;
+        packed[i] = cast<byte4>(make_float4(n, 0.0f));
+        Var offset = ushort{7u};
+        ids[i] = cast<ushort>(i + cast<uint>(offset));
+        Var s = short{-3};
+        Var b = ubyte{255u};
+        colors[i] = cast<half4>(decoded[i] + cast<float>(s) + cast<float>(b));
+    };
+    auto kernel = decode_kernel.function()->function();
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(kernel);
+    std::string source{scratch.view()};
+    LUISA_INFO("Generated kernel:\n{}", source);
+    for (auto s : {"half4(half(0.5f), half(1.0f), half(-2.0f), half(65504.0f))", "byte4", "ushort(7u)",
+                   "short(-3)", "ubyte(255u)", "__device__ half4 *", "__device__ ushort *"}) {
+        if (source.find(s) == std::string::npos) {
+            LUISA_ERROR_WITH_LOCATION("Missing '{}' in generated source.", s);
+        }
+    }
+
+    // literals survive serialization
+    auto f = FunctionSerializer::deserialize(FunctionSerializer::serialize(kernel));
+    Codegen::Scratch deserialized_scratch;
+    CppCodegen deserialized_codegen{deserialized_scratch};
+    deserialized_codegen.emit(f->function());
+    // kernel names are made of the builder hashes, which differ
+    auto body = [](std::string_view s) noexcept { return s.substr(s.find('\n')); };
+    if (body(deserialized_scratch.view()) != body(source)) {
+        LUISA_ERROR_WITH_LOCATION("Small type literals are lost in serialization.");
+    }
+    auto shader = device.compile(decode_kernel);
+    LUISA_INFO("Small types validated.");
+}
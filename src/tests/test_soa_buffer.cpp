@@ -0,0 +1,118 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <string>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <ast/function_serializer.h>
+#include <compile/cpp_codegen.h>
+#include <dsl/syntax.h>
+#include <rtx/ray.h>
+#include <rtx/hit.h>
+#include <rtx/geometry.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+    static constexpr auto ray_count = 1024u;
+    auto rays = device.create_soa_buffer<Ray>(ray_count);
+    auto ray_buffer = device.create_buffer<Ray>(ray_count);
+    auto t_max_buffer = device.create_buffer<float>(ray_count);
+    if (rays.size() != ray_count || rays.member_count() != 4u) {
+        LUISA_ERROR_WITH_LOCATION("Invalid SoA buffer of rays.");
+    }
+    std::vector<float> t_max(ray_count, 1.0f);
+    auto upload = rays.copy_member_from(3u, t_max.data());
+    if (upload->handle() != rays.member_handles()[3] || upload->size() != ray_count * sizeof(float)) {
+        LUISA_ERROR_WITH_LOCATION("Invalid member upload.");
+    }
+    upload->recycle();
+
+    // touching one member only reads and writes its array
+    Kernel1D clip_kernel = [&] {
+        auto i = dispatch_x();
+        Var t = rays[i].t_max;
+        rays[i].t_max = min(t, 100.0f);
+    };
+    auto clip = clip_kernel.function()->function();
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(clip);
+    std::string source{scratch.view()};
+    LUISA_INFO("Generated kernel:\n{}", source);
+    if (source.find("__device__ float *") == std::string::npos ||
+        source.find("__device__ S") != std::string::npos ||
+        source.find(".m3") != std::string::npos) {
+        LUISA_ERROR_WITH_LOCATION("SoA member accesses are not rewritten to member arrays.");
+    }
+
+    // whole elements are gathered and scattered member by member
+    Kernel1D convert_kernel = [&] {
+        auto i = dispatch_x();
+        rays[i] = ray_buffer[i];
+        Var<Ray> ray = rays[i];
+        t_max_buffer[i] = ray.t_max - ray.t_min;
+    };
+    auto convert = convert_kernel.function()->function();
+    if (convert.captured_buffers().size() != 6u) {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid captured buffer count {} in conversion kernel.",
+            convert.captured_buffers().size());
+    }
+    Codegen::Scratch convert_scratch;
+    CppCodegen convert_codegen{convert_scratch};
+    convert_codegen.emit(convert);
+    LUISA_INFO("Generated kernel:\n{}", convert_scratch.view());
+    auto blob = FunctionSerializer::serialize(convert);
+    if (FunctionSerializer::serialize(FunctionSerializer::deserialize(blob)->function()) != blob) {
+        LUISA_ERROR_WITH_LOCATION("SoA buffer accesses are lost in serialization.");
+    }
+    auto clip_shader = device.compile(clip_kernel);
+    auto convert_shader = device.compile(convert_kernel);
+
+    // kernels take one buffer argument per member
+    Kernel1D scale_kernel = [](Var<SoABuffer<Ray>> rays, Float s) noexcept {
+        auto i = dispatch_x();
+        rays[i].t_max = rays[i].t_max * s;
+    };
+    auto scale = scale_kernel.function()->function();
+    if (scale.arguments().size() != 5u || !scale.captured_buffers().empty()) {
+        LUISA_ERROR_WITH_LOCATION("Invalid SoA buffer arguments.");
+    }
+    auto scale_shader = device.compile(scale_kernel);
+    auto stream = device.create_stream();
+    stream << scale_shader(rays, 2.0f).dispatch(ray_count) << synchronize();
+    auto &&scale_dispatch = recorder->dispatches.back();
+    if (!std::equal(scale_dispatch.buffers.cbegin(), scale_dispatch.buffers.cend(),
+                    rays.member_handles().begin(), rays.member_handles().end()) ||
+        scale_dispatch.uniform<float>(0u) != 2.0f) {
+        LUISA_ERROR_WITH_LOCATION("Invalid SoA buffer arguments in dispatch.");
+    }
+
+    // the same buffers feed the trace commands
+    auto hits = device.create_soa_buffer<Hit>(ray_count);
+    Geometry geometry{device};
+    auto trace = geometry.trace_closest(rays, hits);
+    auto trace_command = static_cast<const AccelTraceClosestCommand *>(trace);
+    if (!trace_command->has_soa_rays() || !trace_command->has_soa_hits() ||
+        !std::equal(trace_command->ray_members().cbegin(), trace_command->ray_members().cend(),
+                    rays.member_handles().begin(), rays.member_handles().end()) ||
+        !std::equal(trace_command->hit_members().cbegin(), trace_command->hit_members().cend(),
+                    hits.member_handles().begin(), hits.member_handles().end()) ||
+        trace_command->max_ray_count() != ray_count) {
+        LUISA_ERROR_WITH_LOCATION("Invalid SoA trace command.");
+    }
+    trace->recycle();
+    LUISA_INFO("SoA buffers validated.");
+}
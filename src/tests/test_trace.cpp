@@ -0,0 +1,101 @@
+//
+// Created by Mike Smith on 2021/7/1.
+//
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
+
+#include <core/logging.h>
+#include <core/trace.h>
+
+using namespace luisa;
+
+// payloads of a ring are consecutive if no torn record is kept
+[[nodiscard]] static auto consecutive(const std::vector<TraceRecord> &records) noexcept {
+    for (auto i = 1u; i < records.size(); i++) {
+        if (records[i].payload != records[i - 1u].payload + 1u) { return false; }
+    }
+    return true;
+}
+
+int main() {
+
+    static constexpr auto event = trace_event_id("test::push");
+    static_assert(event == trace_event_id("test::push") && event != trace_event_id("test::pop"));
+
+    // rings keep the most recent records, oldest first
+    TraceRing ring{7u};
+    std::vector<TraceRecord> records;
+    for (auto i = 0u; i < 100u; i++) { ring.push(event, i); }
+    ring.snapshot(records);
+    if (records.size() != 100u || records.front().payload != 0u ||
+        records.front().thread != 7u || records.front().event != event || !consecutive(records)) {
+        LUISA_ERROR_WITH_LOCATION("Invalid snapshot of a partially filled ring.");
+    }
+    for (auto i = 100u; i < 3u * TraceRing::capacity; i++) { ring.push(event, i); }
+    records.clear();
+    ring.snapshot(records);
+    if (records.size() != TraceRing::capacity - 1u ||
+        records.back().payload != 3u * TraceRing::capacity - 1u || !consecutive(records)) {
+        LUISA_ERROR_WITH_LOCATION("Invalid snapshot of a wrapped ring.");
+    }
+
+    // snapshots taken while the owner pushes drop overwritten records
+    TraceRing busy{8u};
+    std::atomic<bool> stop{false};
+    std::thread producer{[&busy, &stop] {
+        for (auto i = 0ull; !stop.load(std::memory_order::relaxed); i++) { busy.push(event, i); }
+    }};
+    for (auto i = 0u; i < 1000u; i++) {
+        records.clear();
+        busy.snapshot(records);
+        if (!consecutive(records)) {
+            stop = true;
+            producer.join();
+            LUISA_ERROR_WITH_LOCATION("Torn records in snapshot #{}.", i);
+        }
+    }
+    stop = true;
+    producer.join();
+
+    // per-thread rings are merged and dumped
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < 4u; t++) {
+        threads.emplace_back([] {
+            for (auto i = 0u; i < 10u; i++) { trace_ring().push(event, i); }
+        });
+    }
+    for (auto &&t : threads) { t.join(); }
+    auto merged = trace_snapshot();
+    if (merged.size() != 40u) {
+        LUISA_ERROR_WITH_LOCATION("Expected 40 merged records, got {}.", merged.size());
+    }
+    for (auto i = 1u; i < merged.size(); i++) {
+        if (merged[i].timestamp < merged[i - 1u].timestamp) {
+            LUISA_ERROR_WITH_LOCATION("Merged records are not sorted by timestamp.");
+        }
+    }
+    auto path = std::filesystem::temp_directory_path() / "test_trace.bin";
+    trace_dump(path);
+    std::ifstream file{path, std::ios::binary};
+    std::array<char, 8u> magic{};
+    uint32_t version = 0u;
+    uint32_t count = 0u;
+    file.read(magic.data(), magic.size());
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    file.read(reinterpret_cast<char *>(&count), sizeof(count));
+    std::vector<TraceRecord> dumped(count);
+    file.read(reinterpret_cast<char *>(dumped.data()), static_cast<std::streamsize>(count * sizeof(TraceRecord)));
+    if (!file || std::string_view{magic.data()} != "LCTRACE" || version != 1u || count != merged.size() ||
+        dumped.back().timestamp != merged.back().timestamp || dumped.back().payload != merged.back().payload) {
+        LUISA_ERROR_WITH_LOCATION("Invalid trace dump.");
+    }
+    file.close();
+    std::filesystem::remove(path);
+    LUISA_INFO("Trace rings validated.");
+}
@@ -0,0 +1,89 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <string_view>
+
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <ast/function_serializer.h>
+#include <rtx/geometry.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    luisa::log_level_verbose();
+
+    Context context{argv[0]};
+    auto device = RecordingDevice::create(context);
+    auto recorder = RecordingDevice::of(device);
+    Geometry geometry{device};
+
+    // shadow rays are traced inline and only their visibility is stored
+    Kernel1D shade_kernel = [&](BufferVar<Ray> rays, BufferFloat visibility) noexcept {
+        auto i = dispatch_x();
+        Var ray = rays[i];
+        Var hit = geometry.trace_closest(ray);
+        if_(hit.prim != ~0u, [&] {
+            ray.t_max = 0.5f;
+        });
+        visibility[i] = select(1.0f, 0.0f, geometry.trace_any(ray));
+    };
+    auto kernel = shade_kernel.function()->function();
+    if (!kernel.raytracing() || kernel.captured_accels().size() != 1u ||
+        kernel.captured_accels()[0].handle != geometry.handle()) {
+        LUISA_ERROR_WITH_LOCATION("Geometry is not captured by the kernel.");
+    }
+
+    // the binding survives serialization
+    auto f = FunctionSerializer::deserialize(FunctionSerializer::serialize(kernel));
+    if (auto accels = f->function().captured_accels();
+        accels.size() != 1u || accels[0].handle != geometry.handle() ||
+        !accels[0].variable.type()->is_accel()) {
+        LUISA_ERROR_WITH_LOCATION("Captured geometry is lost in serialization.");
+    }
+
+    auto shader = device.compile(shade_kernel);
+    for (auto call : {"trace_closest(a", "trace_any(a", "accel a"}) {
+        if (recorder->sources.back().find(call) == std::string::npos) {
+            LUISA_ERROR_WITH_LOCATION("Missing '{}' in generated source.", call);
+        }
+    }
+
+    auto stream = device.create_stream();
+    auto rays = device.create_buffer<Ray>(1024u);
+    auto visibility = device.create_buffer<float>(1024u);
+    stream << shader(rays, visibility).dispatch(1024u);
+    if (auto &&accels = recorder->dispatches.back().accels;
+        accels.size() != 1u || accels[0] != geometry.handle()) {
+        LUISA_ERROR_WITH_LOCATION("Geometry is bound incorrectly.");
+    }
+    LUISA_INFO("In-kernel ray queries validated.");
+
+    // updates are skipped until something moves
+    auto vertices = device.create_buffer<float3>(3u);
+    auto triangles = device.create_buffer<Triangle>(1u);
+    auto mesh = geometry.add_mesh(vertices.view(), triangles.view());
+    auto instance = geometry.add_instance(mesh);
+    stream << mesh.build() << geometry.build();
+    if (geometry.update() != nullptr) {
+        LUISA_ERROR_WITH_LOCATION("Clean geometry is refitted.");
+    }
+    stream << geometry.update() << synchronize();
+    geometry.set_transform(instance, luisa::make_float4x4(2.0f));
+    auto update = geometry.update();
+    if (dynamic_cast<AccelUpdateCommand *>(update) == nullptr || geometry.update() != nullptr) {
+        LUISA_ERROR_WITH_LOCATION("Moved instances are not refitted exactly once.");
+    }
+    stream << update << mesh.update();
+    if (auto refit = geometry.update(); refit == nullptr) {
+        LUISA_ERROR_WITH_LOCATION("Updated meshes are not refitted.");
+    } else {
+        refit->recycle();
+    }
+    LUISA_INFO("Geometry updates validated.");
+}
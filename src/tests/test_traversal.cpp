@@ -0,0 +1,313 @@
+//
+// Created by Mike Smith on 2021/7/8.
+//
+
+#include <array>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/mathematics.h>
+#include <rtx/traversal.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// Möller-Trumbore over all triangles as the reference
+[[nodiscard]] float brute_force(std::span<const float3> vertices, std::span<const Triangle> triangles, const Ray &ray) noexcept {
+    auto o = make_float3(ray.origin[0], ray.origin[1], ray.origin[2]);
+    auto d = make_float3(ray.direction[0], ray.direction[1], ray.direction[2]);
+    auto t_hit = ray.t_max;
+    for (auto triangle : triangles) {
+        auto v0 = vertices[triangle.i[0]];
+        auto e1 = vertices[triangle.i[1]] - v0;
+        auto e2 = vertices[triangle.i[2]] - v0;
+        auto p = cross(d, e2);
+        auto det = dot(e1, p);
+        if (std::abs(det) < 1e-12f) { continue; }
+        auto s = o - v0;
+        auto u = dot(s, p) / det;
+        auto q = cross(s, e1);
+        auto v = dot(d, q) / det;
+        auto t = dot(e2, q) / det;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > ray.t_min && t < t_hit) { t_hit = t; }
+    }
+    return t_hit;
+}
+
+[[nodiscard]] auto make_ray(float3 o, float3 d, float t_max = std::numeric_limits<float>::max()) noexcept {
+    return Ray{{o.x, o.y, o.z}, 0.0f, {d.x, d.y, d.z}, t_max};
+}
+
+int main() {
+
+    static constexpr auto triangle_count = 5000u;
+    std::mt19937 random{19980810u};
+    std::uniform_real_distribution<float> uniform{0.0f, 1.0f};
+    std::vector<float3> vertices;
+    std::vector<Triangle> triangles;
+    for (auto i = 0u; i < triangle_count; i++) {
+        auto center = make_float3(uniform(random), uniform(random), uniform(random)) * 10.0f;
+        for (auto v = 0u; v < 3u; v++) {
+            vertices.emplace_back(center + make_float3(uniform(random), uniform(random), uniform(random)) - 0.5f);
+        }
+        triangles.emplace_back(Triangle{{i * 3u, i * 3u + 1u, i * 3u + 2u}});
+    }
+    BVH mesh;
+    mesh.build(vertices, triangles);
+
+    // closest hits agree with brute force
+    auto hit_count = 0u;
+    for (auto i = 0u; i < 2000u; i++) {
+        auto o = make_float3(uniform(random), uniform(random), uniform(random)) * 14.0f - 2.0f;
+        auto d = normalize(make_float3(uniform(random), uniform(random), uniform(random)) * 2.0f - 1.0f);
+        auto ray = make_ray(o, d);
+        auto expected = brute_force(vertices, triangles, ray);
+        auto hit = trace_closest(mesh, ray);
+        auto missed = hit.prim == ~0u;
+        if (missed != (expected == ray.t_max)) {
+            LUISA_ERROR_WITH_LOCATION("Ray #{} disagrees with brute force on hit/miss.", i);
+        }
+        if (!missed) {
+            auto t = triangles[hit.prim];
+            auto p = (1.0f - hit.uv.x - hit.uv.y) * vertices[t.i[0]] + hit.uv.x * vertices[t.i[1]] + hit.uv.y * vertices[t.i[2]];
+            if (std::abs(length(p - o) - expected) > 1e-3f) {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Ray #{} hits at distance {} instead of {}.",
+                    i, length(p - o), expected);
+            }
+            if (!trace_any(mesh, ray) || trace_any(mesh, make_ray(o, d, expected * 0.999f))) {
+                LUISA_ERROR_WITH_LOCATION("Ray #{} disagrees with brute force on any hit.", i);
+            }
+            hit_count++;
+        }
+    }
+    LUISA_INFO("Closest hits validated ({} hit(s)).", hit_count);
+
+    // the compact layout finds the same hits in less memory, also after refits
+    BVH::Config compact_config;
+    compact_config.layout = AccelLayout::COMPACT;
+    BVH compact;
+    compact.build(vertices, triangles, compact_config);
+    LUISA_INFO(
+        "Memory usage: {} bytes (fast-trace), {} bytes (compact).",
+        mesh.memory_usage(), compact.memory_usage());
+    if (compact.memory_usage() * 2u > mesh.memory_usage()) {
+        LUISA_ERROR_WITH_LOCATION("Compact BVH is not compact.");
+    }
+    auto compare_layouts = [&] {
+        for (auto i = 0u; i < 2000u; i++) {
+            auto o = make_float3(uniform(random), uniform(random), uniform(random)) * 14.0f - 2.0f;
+            auto d = normalize(make_float3(uniform(random), uniform(random), uniform(random)) * 2.0f - 1.0f);
+            auto ray = make_ray(o, d);
+            auto expected = trace_closest(mesh, ray);
+            auto hit = trace_closest(compact, ray);
+            if (hit.prim != expected.prim || hit.uv.x != expected.uv.x || hit.uv.y != expected.uv.y) {
+                LUISA_ERROR_WITH_LOCATION("Compact BVH disagrees on ray #{}.", i);
+            }
+            if (trace_any(compact, ray) != (expected.prim != ~0u)) {
+                LUISA_ERROR_WITH_LOCATION("Compact BVH disagrees on any hit of ray #{}.", i);
+            }
+        }
+    };
+    compare_layouts();
+    for (auto &&v : vertices) { v += make_float3(uniform(random), uniform(random), uniform(random)) * 0.2f; }
+    mesh.refit(vertices, triangles);
+    compact.refit(vertices, triangles);
+    compare_layouts();
+    LUISA_INFO("Compact BVH validated (degradation = {}).", compact.sah_degradation());
+
+    // compact vertex and index formats are decoded on the fly
+    auto bounds_min = make_float3(std::numeric_limits<float>::max());
+    auto bounds_max = make_float3(-std::numeric_limits<float>::max());
+    for (auto v : vertices) {
+        bounds_min = min(bounds_min, v);
+        bounds_max = max(bounds_max, v);
+    }
+    auto quantized_format = MeshFormat::unorm16(bounds_min, bounds_max);
+    quantized_format.index = IndexFormat::UINT16;
+    std::vector<uint16_t> quantized_vertices;
+    std::vector<float3> decoded_vertices;
+    for (auto v : vertices) {
+        auto q = round((v - quantized_format.offset) / quantized_format.scale);
+        quantized_vertices.insert(quantized_vertices.end(), {static_cast<uint16_t>(q.x), static_cast<uint16_t>(q.y), static_cast<uint16_t>(q.z)});
+        decoded_vertices.emplace_back(quantized_format.offset + quantized_format.scale * q);
+    }
+    std::vector<uint16_t> short_indices;
+    for (auto t : triangles) {
+        short_indices.insert(short_indices.end(), {static_cast<uint16_t>(t.i[0]), static_cast<uint16_t>(t.i[1]), static_cast<uint16_t>(t.i[2])});
+    }
+    MeshView quantized_mesh{quantized_vertices.data(), vertices.size(), short_indices.data(), triangles.size(), quantized_format};
+    MeshView default_mesh{vertices, triangles};
+    LUISA_INFO(
+        "Mesh memory usage: {} bytes (float3, uint32), {} bytes (unorm16, uint16).",
+        default_mesh.size_bytes(), quantized_mesh.size_bytes());
+    BVH decoded;
+    decoded.build(decoded_vertices, triangles);
+    for (auto layout : {AccelLayout::FAST_TRACE, AccelLayout::COMPACT}) {
+        BVH::Config config;
+        config.layout = layout;
+        BVH quantized;
+        quantized.build(quantized_mesh, config);
+        for (auto i = 0u; i < 2000u; i++) {
+            auto o = make_float3(uniform(random), uniform(random), uniform(random)) * 14.0f - 2.0f;
+            auto d = normalize(make_float3(uniform(random), uniform(random), uniform(random)) * 2.0f - 1.0f);
+            auto ray = make_ray(o, d);
+            auto expected = trace_closest(decoded, ray);
+            auto hit = trace_closest(quantized, ray);
+            if (hit.prim != expected.prim || hit.uv.x != expected.uv.x || hit.uv.y != expected.uv.y) {
+                LUISA_ERROR_WITH_LOCATION("Quantized mesh disagrees on ray #{}.", i);
+            }
+        }
+    }
+    std::vector<float> packed_vertices;
+    for (auto v : vertices) { packed_vertices.insert(packed_vertices.end(), {v.x, v.y, v.z}); }
+    MeshFormat packed_format;
+    packed_format.vertex = VertexFormat::PACKED_FLOAT3;
+    auto packed_build = MeshBuildCommand::create(
+        0u, reinterpret_cast<uint64_t>(packed_vertices.data()), 0u, vertices.size(),
+        reinterpret_cast<uint64_t>(triangles.data()), 0u, triangles.size(),
+        AccelLayout::COMPACT, packed_format);
+    BVH packed;
+    build_host_mesh(packed, packed_build);
+    packed_build->recycle();
+    for (auto i = 0u; i < 2000u; i++) {
+        auto o = make_float3(uniform(random), uniform(random), uniform(random)) * 14.0f - 2.0f;
+        auto d = normalize(make_float3(uniform(random), uniform(random), uniform(random)) * 2.0f - 1.0f);
+        auto ray = make_ray(o, d);
+        auto expected = trace_closest(mesh, ray);
+        auto hit = trace_closest(packed, ray);
+        if (hit.prim != expected.prim || hit.uv.x != expected.uv.x || hit.uv.y != expected.uv.y) {
+            LUISA_ERROR_WITH_LOCATION("Packed mesh disagrees on ray #{}.", i);
+        }
+    }
+    LUISA_INFO("Compact mesh formats validated.");
+
+    // rays through shared edges and vertices of a grid never slip through
+    static constexpr auto grid_size = 16u;
+    std::vector<float3> grid_vertices;
+    std::vector<Triangle> grid_triangles;
+    for (auto y = 0u; y <= grid_size; y++) {
+        for (auto x = 0u; x <= grid_size; x++) {
+            grid_vertices.emplace_back(make_float3(static_cast<float>(x), static_cast<float>(y), 0.0f) * 0.1f);
+        }
+    }
+    for (auto y = 0u; y < grid_size; y++) {
+        for (auto x = 0u; x < grid_size; x++) {
+            auto v = y * (grid_size + 1u) + x;
+            grid_triangles.emplace_back(Triangle{{v, v + 1u, v + grid_size + 2u}});
+            grid_triangles.emplace_back(Triangle{{v, v + grid_size + 2u, v + grid_size + 1u}});
+        }
+    }
+    BVH grid;
+    grid.build(grid_vertices, grid_triangles);
+    for (auto y = 1u; y < grid_size * 4u; y++) {
+        for (auto x = 1u; x < grid_size * 4u; x++) {
+            auto p = make_float3(static_cast<float>(x), static_cast<float>(y), 0.0f) * 0.025f;
+            for (auto d : {make_float3(0.0f, 0.0f, -1.0f), normalize(make_float3(0.3f, 0.2f, -1.0f))}) {
+                if (trace_closest(grid, make_ray(p - d, d)).prim == ~0u) {
+                    LUISA_ERROR_WITH_LOCATION("Ray at ({}, {}) slipped through the grid.", p.x, p.y);
+                }
+            }
+        }
+    }
+    LUISA_INFO("Watertightness validated.");
+
+    // instanced queues with an index list and a ray count buffer
+    std::vector<const BVH *> meshes{&mesh, &grid};
+    std::vector<float3x4> transforms{make_float3x4(translation(make_float3(0.0f, 0.0f, 100.0f))), make_float3x4(scaling(make_float3(10.0f)))};
+    TopLevelBVH accel;
+    accel.build(meshes, transforms);
+    static constexpr auto ray_count = 1u << 20u;
+    std::vector<Ray> rays;
+    for (auto i = 0u; i < ray_count; i++) {
+        auto o = make_float3(uniform(random) * 10.0f, uniform(random) * 10.0f, 200.0f);
+        rays.emplace_back(make_ray(o, make_float3(0.0f, 0.0f, -1.0f)));
+    }
+    std::vector<uint32_t> indices(ray_count / 2u);
+    for (auto i = 0u; i < indices.size(); i++) { indices[i] = ray_count - 1u - i * 2u; }
+    auto queue_size = static_cast<uint>(indices.size() - 1000u);
+    std::vector<Hit> hits(ray_count, Hit{42u, 42u, make_float2(0.0f)});
+    auto command = AccelTraceClosestCommand::create(
+        0u, reinterpret_cast<uint64_t>(rays.data()), 0u,
+        reinterpret_cast<uint64_t>(indices.data()), 0u,
+        reinterpret_cast<uint64_t>(hits.data()), 0u,
+        reinterpret_cast<uint64_t>(&queue_size), 0u,
+        indices.size());
+    Clock clock;
+    trace_host_closest(accel, command);
+    LUISA_INFO("Traced {} ray(s) in {} ms.", queue_size, clock.toc());
+    command->recycle();
+    std::vector<uint8_t> queued(ray_count, 0u);
+    for (auto i = 0u; i < queue_size; i++) { queued[indices[i]] = 1u; }
+    for (auto i = 0u; i < ray_count; i++) {
+        if (!queued[i]) {
+            if (hits[i].prim != 42u) { LUISA_ERROR_WITH_LOCATION("Ray #{} is not queued but traced.", i); }
+            continue;
+        }
+        auto expected = trace_closest(accel, rays[i]);
+        if (hits[i].prim != expected.prim || hits[i].inst != expected.inst) {
+            LUISA_ERROR_WITH_LOCATION("Queued ray #{} has a wrong hit.", i);
+        }
+        // kernels on the host trace inline through the accel handle
+        auto inline_hit = trace_closest(reinterpret_cast<uint64_t>(&accel), rays[i]);
+        if (inline_hit.prim != expected.prim || inline_hit.inst != expected.inst ||
+            !trace_any(reinterpret_cast<uint64_t>(&accel), rays[i])) {
+            LUISA_ERROR_WITH_LOCATION("Queued ray #{} has a wrong inline hit.", i);
+        }
+    }
+    std::vector<uint8_t> any_hits(ray_count, 2u);
+    auto any_command = AccelTraceAnyCommand::create(
+        0u, reinterpret_cast<uint64_t>(rays.data()), 0u,
+        AccelTraceAnyCommand::no_buffer, 0u,
+        reinterpret_cast<uint64_t>(any_hits.data()), 0u,
+        AccelTraceAnyCommand::no_buffer, 0u,
+        rays.size());
+    trace_host_any(accel, any_command);
+    any_command->recycle();
+    for (auto i = 0u; i < ray_count; i++) {// every ray hits the scaled grid
+        if (any_hits[i] != 1u) { LUISA_ERROR_WITH_LOCATION("Ray #{} misses the accel.", i); }
+    }
+    LUISA_INFO("Trace commands validated.");
+
+    // structure-of-arrays rays and hits give the same hits
+    static constexpr auto soa_ray_count = 4096u;
+    std::vector<std::array<float, 3u>> soa_origins(soa_ray_count);
+    std::vector<std::array<float, 3u>> soa_directions(soa_ray_count);
+    std::vector<float> soa_t_mins(soa_ray_count);
+    std::vector<float> soa_t_maxs(soa_ray_count);
+    for (auto i = 0u; i < soa_ray_count; i++) {
+        auto &&ray = rays[i * 7u];
+        std::copy_n(ray.origin, 3u, soa_origins[i].begin());
+        std::copy_n(ray.direction, 3u, soa_directions[i].begin());
+        soa_t_mins[i] = ray.t_min;
+        soa_t_maxs[i] = ray.t_max;
+    }
+    std::vector<uint> soa_prims(soa_ray_count);
+    std::vector<uint> soa_insts(soa_ray_count);
+    std::vector<float2> soa_uvs(soa_ray_count);
+    auto soa_command = AccelTraceClosestCommand::create(
+        0u, AccelTraceClosestCommand::no_buffer, 0u,
+        AccelTraceClosestCommand::no_buffer, 0u,
+        AccelTraceClosestCommand::no_buffer, 0u,
+        AccelTraceClosestCommand::no_buffer, 0u,
+        soa_ray_count,
+        AccelTraceClosestCommand::RayMembers{
+            reinterpret_cast<uint64_t>(soa_origins.data()), reinterpret_cast<uint64_t>(soa_t_mins.data()),
+            reinterpret_cast<uint64_t>(soa_directions.data()), reinterpret_cast<uint64_t>(soa_t_maxs.data())},
+        AccelTraceClosestCommand::HitMembers{
+            reinterpret_cast<uint64_t>(soa_prims.data()), reinterpret_cast<uint64_t>(soa_insts.data()),
+            reinterpret_cast<uint64_t>(soa_uvs.data())});
+    trace_host_closest(accel, soa_command);
+    soa_command->recycle();
+    for (auto i = 0u; i < soa_ray_count; i++) {
+        auto expected = trace_closest(accel, rays[i * 7u]);
+        if (soa_prims[i] != expected.prim || soa_insts[i] != expected.inst ||
+            soa_uvs[i].x != expected.uv.x || soa_uvs[i].y != expected.uv.y) {
+            LUISA_ERROR_WITH_LOCATION("SoA ray #{} has a wrong hit.", i);
+        }
+    }
+    LUISA_INFO("SoA trace commands validated.");
+}
@@ -91,6 +91,11 @@ std::string_view tag_name(Type::Tag tag) noexcept {
     if (tag == Type::Tag::FLOAT) { return "float"sv; }
     if (tag == Type::Tag::INT) { return "int"sv; }
     if (tag == Type::Tag::UINT) { return "uint"sv; }
+    if (tag == Type::Tag::HALF) { return "half"sv; }
+    if (tag == Type::Tag::SHORT) { return "short"sv; }
+    if (tag == Type::Tag::USHORT) { return "ushort"sv; }
+    if (tag == Type::Tag::BYTE) { return "byte"sv; }
+    if (tag == Type::Tag::UBYTE) { return "ubyte"sv; }
     if (tag == Type::Tag::VECTOR) { return "vector"sv; }
     if (tag == Type::Tag::MATRIX) { return "matrix"sv; }
     if (tag == Type::Tag::ARRAY) { return "array"sv; }
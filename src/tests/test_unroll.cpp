@@ -0,0 +1,121 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <string>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <ast/function_serializer.h>
+#include <compile/cpp_codegen.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    auto device = FakeDevice::create(context);
+    auto emit = [](Function kernel) noexcept {
+        Codegen::Scratch scratch;
+        CppCodegen codegen{scratch};
+        codegen.emit(kernel);
+        std::string source{scratch.view()};
+        LUISA_INFO("Generated kernel:\n{}", source);
+        return source;
+    };
+
+    // constant ranges are expanded with the induction variable as a literal
+    Kernel1D unrolled_kernel = [](BufferUInt buffer) noexcept {
+        auto i = dispatch_x();
+        Var sum = 0u;
+        for (auto k : unroll(range(3u))) { sum += buffer[i * 3u + k]; }
+        for (auto k : unroll(range(compute::detail::Expr{10}, 4, -3))) { sum += cast<uint>(k); }
+        buffer[i] = sum;
+    };
+    auto unrolled = unrolled_kernel.function()->function();
+    auto source = emit(unrolled);
+    if (source.find("for (") != std::string::npos) {
+        LUISA_ERROR_WITH_LOCATION("Constant ranges are not unrolled.");
+    }
+    for (auto s : {"+ 0u)", "+ 1u)", "+ 2u)", "(10)", "(7)"}) {
+        if (source.find(s) == std::string::npos) {
+            LUISA_ERROR_WITH_LOCATION("Missing induction literal '{}' in unrolled loop.", s);
+        }
+    }
+    auto blob = FunctionSerializer::serialize(unrolled);
+    if (FunctionSerializer::serialize(FunctionSerializer::deserialize(blob)->function()) != blob) {
+        LUISA_ERROR_WITH_LOCATION("Unrolled loops are lost in serialization.");
+    }
+
+    // long and dynamic ranges stay runtime loops
+    Kernel1D long_kernel = [](BufferUInt buffer) noexcept {
+        auto i = dispatch_x();
+        Var sum = 0u;
+        for (auto k : unroll(range(64u))) { sum += k; }
+        for (auto k : unroll(range(64u), 4u)) { sum += k; }
+        buffer[i] = sum;
+    };
+    auto long_source = emit(long_kernel.function()->function());
+    Kernel1D dynamic_kernel = [](BufferUInt buffer, UInt n) noexcept {
+        auto i = dispatch_x();
+        Var sum = 0u;
+        for (auto k : unroll(range(n))) { sum += k; }
+        buffer[i] = sum;
+    };
+    auto dynamic_source = emit(dynamic_kernel.function()->function());
+    if (long_source.find("for (") == std::string::npos ||
+        long_source.find("for (") == long_source.rfind("for (") ||
+        dynamic_source.find("for (") == std::string::npos) {
+        LUISA_ERROR_WITH_LOCATION("Long or dynamic ranges are unrolled.");
+    }
+    // jumps in loops and switches nested in unrolled bodies stay legal
+    Kernel1D nested_kernel = [](BufferUInt buffer) noexcept {
+        auto i = dispatch_x();
+        Var sum = 0u;
+        for (auto k : unroll(range(2u))) {
+            while_(true, [&] {
+                sum += k;
+                if_(sum > 8u, [] { break_(); });
+                continue_();
+            });
+            for (auto j : range(4u)) {
+                switch_(j)
+                    .case_(1u, [] { continue_(); })
+                    .default_([&] { sum += j; });
+            }
+        }
+        buffer[i] = sum;
+    };
+    auto nested_source = emit(nested_kernel.function()->function());
+    if (nested_source.find("break;") == std::string::npos ||
+        nested_source.find("continue;") == std::string::npos) {
+        LUISA_ERROR_WITH_LOCATION("Jumps in nested loops of unrolled bodies are lost.");
+    }
+
+    // leaving an unrolled range early on the host keeps jumps balanced
+    Kernel1D early_exit_kernel = [](BufferUInt buffer, UInt n) noexcept {
+        auto i = dispatch_x();
+        Var sum = 0u;
+        for (auto j : range(n)) {
+            for (auto k : unroll(range(4u))) {
+                sum += k;
+                break;
+            }
+            if_(sum > 8u, [] { break_(); });
+            sum += j;
+        }
+        buffer[i] = sum;
+    };
+    auto early_exit_source = emit(early_exit_kernel.function()->function());
+    if (early_exit_source.find("break;") == std::string::npos) {
+        LUISA_ERROR_WITH_LOCATION("Jumps after an early exit from an unrolled body are lost.");
+    }
+    auto unrolled_shader = device.compile(unrolled_kernel);
+    auto long_shader = device.compile(long_kernel);
+    auto dynamic_shader = device.compile(dynamic_kernel);
+    LUISA_INFO("Loop unrolling validated.");
+}
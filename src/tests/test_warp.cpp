@@ -0,0 +1,78 @@
+//
+// Created by Mike Smith on 2021/7/10.
+//
+
+#include <algorithm>
+#include <string>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <ast/function_serializer.h>
+#include <compile/cpp_codegen.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    auto device = FakeDevice::create(context);
+
+    // sums values with one atomic per warp instead of shared memory
+    // round trips, and compacts the positive ones
+    Kernel1D compact_kernel = [](BufferFloat values, BufferFloat sum, BufferFloat compacted, BufferUInt count) noexcept {
+        auto i = dispatch_x();
+        Var x = values[i];
+        Var warp_sum = warp_reduce_sum(x);
+        Var lo = warp_reduce_min(x);
+        Var hi = warp_reduce_max(make_float2(x, -x));
+        if_(warp_lane_id() == 0u, [&] {
+            sum[i / warp_size()] = warp_sum + lo + hi.x + hi.y;
+        });
+        Var keep = x > 0.0f;
+        Var mask = warp_ballot(keep);
+        Var offset = 0u;
+        if_(warp_any(keep) && !warp_all(keep), [&] {
+            Var base = 0u;
+            if_(warp_lane_id() == 0u, [&] {
+                base = count.atomic(0u).fetch_add(popcount(mask.x) + popcount(mask.y) + popcount(mask.z) + popcount(mask.w));
+            });
+            offset = warp_broadcast(base, 0u) + warp_prefix_sum(select(0u, 1u, keep));
+        });
+        if_(keep, [&] {
+            compacted[offset] = warp_shuffle(x, warp_lane_id() ^ 1u);
+        });
+    };
+
+    auto kernel = compact_kernel.function()->function();
+    for (auto op : {CallOp::WARP_SIZE, CallOp::WARP_LANE_ID, CallOp::WARP_BALLOT, CallOp::WARP_ANY,
+                    CallOp::WARP_ALL, CallOp::WARP_BROADCAST, CallOp::WARP_SHUFFLE, CallOp::WARP_REDUCE_SUM,
+                    CallOp::WARP_REDUCE_MIN, CallOp::WARP_REDUCE_MAX, CallOp::WARP_PREFIX_SUM}) {
+        if (std::find(kernel.builtin_callables().begin(), kernel.builtin_callables().end(), op) ==
+            kernel.builtin_callables().end()) {
+            LUISA_ERROR_WITH_LOCATION("Warp operation {} is not recorded.", to_underlying(op));
+        }
+    }
+
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(kernel);
+    std::string source{scratch.view()};
+    LUISA_INFO("Generated kernel:\n{}", source);
+    for (auto s : {"warp_reduce_sum(", "warp_reduce_max(float2(", "warp_size()", "warp_lane_id()", "uint4 v",
+                   "warp_ballot(", "warp_broadcast(", "warp_prefix_sum(", "warp_shuffle("}) {
+        if (source.find(s) == std::string::npos) {
+            LUISA_ERROR_WITH_LOCATION("Missing '{}' in generated source.", s);
+        }
+    }
+
+    auto blob = FunctionSerializer::serialize(kernel);
+    if (FunctionSerializer::serialize(FunctionSerializer::deserialize(blob)->function()) != blob) {
+        LUISA_ERROR_WITH_LOCATION("Warp operations are lost in serialization.");
+    }
+    auto shader = device.compile(compact_kernel);
+    LUISA_INFO("Warp operations validated.");
+}